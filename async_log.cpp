@@ -0,0 +1,246 @@
+#include "async_log.h"
+#include <atomic>
+#include <stdint.h>
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+
+/**
+ * Bounded MPSC ring (Vyukov): a slot is free for position `pos` when its
+ * seq == pos, and holds a finished record when seq == pos + 1.
+ */
+struct AsyncLogRecord {
+    std::atomic<uint64_t> seq;
+    time_t when;
+    int targets;
+    int len;
+    char text[ASYNC_LOG_RECORD_SIZE];
+};
+
+struct AsyncLogger {
+    AsyncLogRecord* records;
+    uint64_t mask;
+    AsyncLogConfig cfg;
+    FILE* file;
+
+    alignas(64) std::atomic<uint64_t> enqueue_pos;  // Producers
+    alignas(64) uint64_t dequeue_pos;               // Writer thread only
+    alignas(64) std::atomic<int> writer_sleeping;
+    std::atomic<bool> running;
+    std::atomic<long> dropped;
+
+    int bell_fd;        // eventfd, rung only while the writer sleeps
+    pthread_t thread;
+};
+
+static AsyncLogger logger;
+static std::atomic<bool> logger_active(false);
+
+
+// --- Writer thread ---
+
+struct LogBuffer {
+    char data[ASYNC_LOG_BATCH_BYTES];
+    size_t len;
+};
+
+static void flush_buffer(LogBuffer* b, int target) {
+    if (b->len == 0) return;
+    if (target == LOG_TO_CONSOLE) {
+        // Through stdio, so the lines stay in order with direct printf/cout output
+        fwrite(b->data, 1, b->len, stdout);
+        fflush(stdout);
+    } else {
+        size_t off = 0;
+        while (off < b->len) {
+            ssize_t n = write(fileno(logger.file), b->data + off, b->len - off);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            off += n;
+        }
+    }
+    b->len = 0;
+}
+
+static void append(LogBuffer* b, int target, const char* data, size_t len) {
+    if (b->len + len > sizeof(b->data)) flush_buffer(b, target);
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+}
+
+static bool ring_peek_ready() {
+    AsyncLogRecord* rec = &logger.records[logger.dequeue_pos & logger.mask];
+    return rec->seq.load(std::memory_order_acquire) == logger.dequeue_pos + 1;
+}
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void* writer_loop(void*) {
+    static LogBuffer file_buf, console_buf;
+    time_t stamp_for = (time_t)-1;
+    char stamp[20] = "";
+    double last_flush = now_ms();
+
+    for (;;) {
+        // Drain every finished record into the batch buffers
+        int drained = 0;
+        while (ring_peek_ready()) {
+            AsyncLogRecord* rec = &logger.records[logger.dequeue_pos & logger.mask];
+            if (rec->targets & LOG_TO_CONSOLE) append(&console_buf, LOG_TO_CONSOLE, rec->text, rec->len);
+            if ((rec->targets & LOG_TO_FILE) && logger.file) {
+                if (rec->when != stamp_for) {
+                    // Cached per second: one localtime_r per distinct timestamp
+                    struct tm ltm;
+                    localtime_r(&rec->when, &ltm);
+                    snprintf(stamp, sizeof(stamp), "[%02d:%02d:%02d] ", ltm.tm_hour, ltm.tm_min, ltm.tm_sec);
+                    stamp_for = rec->when;
+                }
+                append(&file_buf, LOG_TO_FILE, stamp, strlen(stamp));
+                append(&file_buf, LOG_TO_FILE, rec->text, rec->len);
+            }
+            rec->seq.store(logger.dequeue_pos + logger.mask + 1, std::memory_order_release);
+            logger.dequeue_pos++;
+            drained++;
+        }
+
+        bool pending = (file_buf.len > 0 || console_buf.len > 0);
+        bool stopping = !logger.running.load();
+        double waited = now_ms() - last_flush;
+        if (pending && (stopping || logger.cfg.flush_interval_ms == 0 || waited >= logger.cfg.flush_interval_ms)) {
+            flush_buffer(&console_buf, LOG_TO_CONSOLE);
+            flush_buffer(&file_buf, LOG_TO_FILE);
+            last_flush = now_ms();
+            pending = false;
+        }
+        if (stopping && !ring_peek_ready()) break;
+        if (drained > 0) continue;
+
+        // Nothing ready: announce the sleep, then re-check (pairs with async_log_vwrite)
+        logger.writer_sleeping.store(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (ring_peek_ready() || !logger.running.load()) {
+            logger.writer_sleeping.store(0);
+            continue;
+        }
+        int timeout = 100; // Also how quickly a stop is noticed
+        if (pending) {
+            timeout = logger.cfg.flush_interval_ms - (int)waited;
+            if (timeout < 1) timeout = 1;
+        }
+        struct pollfd pfd = { logger.bell_fd, POLLIN, 0 };
+        poll(&pfd, 1, timeout);
+        logger.writer_sleeping.store(0);
+        uint64_t count;
+        if (read(logger.bell_fd, &count, sizeof(count)) == -1 && errno != EAGAIN) perror("AsyncLog: eventfd read");
+    }
+    return NULL;
+}
+
+static void ring_bell() {
+    uint64_t one = 1;
+    if (write(logger.bell_fd, &one, sizeof(one)) == -1) perror("AsyncLog: eventfd write");
+}
+
+
+// --- Public Functions ---
+
+void async_log_default_config(AsyncLogConfig* cfg) {
+    cfg->capacity = ASYNC_LOG_DEFAULT_CAPACITY;
+    cfg->flush_interval_ms = 0;
+    cfg->full_policy = LOG_FULL_BLOCK;
+}
+
+bool async_log_start(FILE* file, const AsyncLogConfig* cfg) {
+    int capacity = 1;
+    while (capacity < cfg->capacity) capacity <<= 1;
+
+    logger.records = new (std::nothrow) AsyncLogRecord[capacity];
+    if (logger.records == NULL) return false;
+    for (int i = 0; i < capacity; i++) logger.records[i].seq.store(i);
+    logger.mask = capacity - 1;
+    logger.cfg = *cfg;
+    logger.file = file;
+    logger.enqueue_pos.store(0);
+    logger.dequeue_pos = 0;
+    logger.writer_sleeping.store(0);
+    logger.dropped.store(0);
+    logger.running.store(true);
+
+    logger.bell_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (logger.bell_fd == -1) {
+        perror("AsyncLog: Failed to create eventfd");
+        delete[] logger.records;
+        return false;
+    }
+    if (file) fflush(file); // Earlier synchronous lines go first
+    fflush(stdout);
+    if (pthread_create(&logger.thread, NULL, writer_loop, NULL) != 0) {
+        perror("AsyncLog: Failed to create writer thread");
+        close(logger.bell_fd);
+        delete[] logger.records;
+        return false;
+    }
+    logger_active.store(true);
+    return true;
+}
+
+void async_log_stop() {
+    if (!logger_active.load()) return;
+    logger.running.store(false);
+    ring_bell();
+    pthread_join(logger.thread, NULL);
+    logger_active.store(false);
+    close(logger.bell_fd);
+    delete[] logger.records;
+    logger.records = NULL;
+}
+
+bool async_log_running() {
+    return logger_active.load(std::memory_order_relaxed);
+}
+
+void async_log_vwrite(int targets, time_t when, const char* format, va_list args) {
+    uint64_t pos = logger.enqueue_pos.load(std::memory_order_relaxed);
+    AsyncLogRecord* rec;
+    for (;;) {
+        rec = &logger.records[pos & logger.mask];
+        int64_t diff = (int64_t)rec->seq.load(std::memory_order_acquire) - (int64_t)pos;
+        if (diff == 0) {
+            if (logger.enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // Full
+            if (logger.cfg.full_policy == LOG_FULL_DROP) {
+                logger.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            ring_bell();
+            sched_yield();
+            pos = logger.enqueue_pos.load(std::memory_order_relaxed);
+        } else {
+            pos = logger.enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    int len = vsnprintf(rec->text, ASYNC_LOG_RECORD_SIZE, format, args);
+    if (len < 0) len = 0;
+    if (len >= ASYNC_LOG_RECORD_SIZE) {
+        len = ASYNC_LOG_RECORD_SIZE - 1;
+        rec->text[len - 1] = '\n'; // Keep the line break of a truncated line
+    }
+    rec->len = len;
+    rec->when = when;
+    rec->targets = targets;
+    rec->seq.store(pos + 1, std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (logger.writer_sleeping.load(std::memory_order_relaxed)) ring_bell();
+}
+
+long async_log_dropped() {
+    return logger.dropped.load();
+}
@@ -0,0 +1,52 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include "utils.h"
+#include <stdarg.h>
+
+/**
+ * @brief Asynchronous logger. log_event and the scheduler's log helper
+ * format their line into a preallocated record of a lock-free MPSC ring
+ * and return; a writer thread stamps the records (one localtime per
+ * second, not per line) and writes them out in large batches. Nothing
+ * that runs under scheduler.lock waits on the disk or the terminal.
+ *
+ * While the logger is not running, the callers log synchronously as
+ * before.
+ */
+
+#define ASYNC_LOG_DEFAULT_CAPACITY 4096 // Records in the ring (power of two)
+#define ASYNC_LOG_RECORD_SIZE 240       // Longer lines are truncated
+#define ASYNC_LOG_BATCH_BYTES 65536     // Writer buffer per destination
+
+// Where a record goes
+#define LOG_TO_FILE    1    // Log file, with a "[HH:MM:SS] " prefix
+#define LOG_TO_CONSOLE 2    // stdout, as is
+
+enum LogFullPolicy {
+    LOG_FULL_BLOCK,     // Producer waits for the writer (nothing is lost)
+    LOG_FULL_DROP       // Producer drops the line and counts it
+};
+
+struct AsyncLogConfig {
+    int capacity;
+    int flush_interval_ms;      // 0: write as soon as lines are queued
+    LogFullPolicy full_policy;
+};
+
+void async_log_default_config(AsyncLogConfig* cfg);
+
+// Starts the writer thread for `file` (and stdout)
+bool async_log_start(FILE* file, const AsyncLogConfig* cfg);
+
+// Writes out everything queued and stops the writer thread
+void async_log_stop();
+
+bool async_log_running();
+
+// Queues one line; `when` is the timestamp for LOG_TO_FILE
+void async_log_vwrite(int targets, time_t when, const char* format, va_list args);
+
+long async_log_dropped();
+
+#endif // ASYNC_LOG_H
@@ -0,0 +1,242 @@
+#include "utils.h"
+#include "shm_ring.h"
+#include <time.h>
+#include <stdint.h>
+#include <errno.h>
+#include <vector>
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+
+/**
+ * @brief Tower <-> drone IPC benchmark. A producer process plays N
+ * drones; each round it sends one JetFeedbackMessage-sized message per
+ * jet (the burst a scheduler tick causes) and the consumer, playing the
+ * tower, drains them through epoll. Compares a pipe per jet, a
+ * socketpair per jet and an shm ring per jet.
+ *
+ * Compile: g++ -O2 bench_ipc.cpp shm_ring.cpp -o bench_ipc -lpthread
+ */
+
+enum BenchTransport { BENCH_PIPE, BENCH_SOCKETPAIR, BENCH_SHM };
+static const char* TRANSPORT_NAMES[] = { "pipe", "socketpair", "shm" };
+
+static const int POPULATIONS[] = { 10, 1000, 10000 };
+static const int NUM_POPULATIONS = sizeof(POPULATIONS) / sizeof(POPULATIONS[0]);
+static const long MESSAGES_PER_RUN = 100000;
+
+#define FD_BATCH 64 // fds passed per SCM_RIGHTS message
+
+struct BenchMessage {
+    JetFeedbackMessage feedback;
+    int jet;
+    int64_t sent_ns;
+};
+
+static int64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// --- fd passing, so neither process ever holds both ends of every jet ---
+
+static void send_fds(int sock, const int* fds, int count) {
+    char byte = 0;
+    struct iovec iov = { &byte, 1 };
+    char control[CMSG_SPACE(sizeof(int) * FD_BATCH)];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * count);
+    if (sendmsg(sock, &msg, 0) == -1) perror("bench_ipc: sendmsg");
+}
+
+static int recv_fds(int sock, int* fds) {
+    char byte;
+    struct iovec iov = { &byte, 1 };
+    char control[CMSG_SPACE(sizeof(int) * FD_BATCH)];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(sock, &msg, 0) <= 0) return 0;
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == NULL) return 0;
+    int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * count);
+    return count;
+}
+
+// --- Producer (the drones) ---
+
+static void run_producer(BenchTransport t, int n, long rounds, int ctl) {
+    std::vector<int> send_fd(n);
+    std::vector<ShmChannel*> channels(n, (ShmChannel*)NULL);
+
+    // Create every channel here and hand the tower its end(s)
+    int batch[FD_BATCH], batch_count = 0;
+    for (int j = 0; j < n; j++) {
+        int ends[2];
+        if (t == BENCH_PIPE) {
+            if (pipe(ends) == -1) { perror("bench_ipc: pipe"); _exit(1); }
+            send_fd[j] = ends[1];
+            batch[batch_count++] = ends[0];
+        } else if (t == BENCH_SOCKETPAIR) {
+            if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, ends) == -1) { perror("bench_ipc: socketpair"); _exit(1); }
+            send_fd[j] = ends[1];
+            batch[batch_count++] = ends[0];
+        } else {
+            int mem_fd, jet_bell, tower_bell;
+            channels[j] = shm_channel_create(&mem_fd, &jet_bell, &tower_bell);
+            if (channels[j] == NULL) { perror("bench_ipc: shm_channel_create"); _exit(1); }
+            close(jet_bell); // One direction only
+            send_fd[j] = tower_bell;
+            batch[batch_count++] = mem_fd;
+            batch[batch_count++] = tower_bell;
+        }
+        if (batch_count + 2 > FD_BATCH || j == n - 1) {
+            send_fds(ctl, batch, batch_count);
+            for (int i = 0; i < batch_count; i++) {
+                if (t != BENCH_SHM || i % 2 == 0) close(batch[i]); // Keep the tower_bell for ringing
+            }
+            batch_count = 0;
+        }
+    }
+
+    BenchMessage m;
+    memset(&m, 0, sizeof(m));
+    m.feedback.status = STATUS_FUEL_LOW;
+    for (long r = 0; r < rounds; r++) {
+        char go;
+        if (read(ctl, &go, 1) != 1) break;
+        for (int j = 0; j < n; j++) {
+            m.jet = j;
+            m.feedback.data = (int)r;
+            m.sent_ns = now_ns();
+            if (t == BENCH_SHM) {
+                while (!shm_ring_send(&channels[j]->to_tower, send_fd[j], &m, sizeof(m))) sched_yield();
+            } else if (write(send_fd[j], &m, sizeof(m)) != (ssize_t)sizeof(m)) {
+                perror("bench_ipc: write");
+                _exit(1);
+            }
+        }
+    }
+    _exit(0);
+}
+
+// --- Consumer (the tower) ---
+
+static void bench_transport(BenchTransport t, int n) {
+    long rounds = MESSAGES_PER_RUN / n;
+    if (rounds < 10) rounds = 10;
+
+    int ctl[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, ctl) == -1) { perror("bench_ipc: socketpair"); return; }
+    pid_t pid = fork();
+    if (pid < 0) { perror("bench_ipc: fork"); return; }
+    if (pid == 0) {
+        close(ctl[0]);
+        run_producer(t, n, rounds, ctl[1]);
+    }
+    close(ctl[1]);
+
+    std::vector<int> recv_fd(n);
+    std::vector<ShmChannel*> channels(n, (ShmChannel*)NULL);
+    int epoll_fd = epoll_create1(0);
+    int received_fds = 0, fds[FD_BATCH];
+    int fds_per_jet = (t == BENCH_SHM) ? 2 : 1;
+    while (received_fds < n * fds_per_jet) {
+        int count = recv_fds(ctl[0], fds);
+        if (count == 0) { printf("  (fd passing failed)\n"); return; }
+        for (int i = 0; i < count; i += fds_per_jet) {
+            int j = (received_fds + i) / fds_per_jet;
+            if (t == BENCH_SHM) {
+                channels[j] = shm_channel_attach(fds[i]);
+                close(fds[i]);
+                recv_fd[j] = fds[i + 1];
+            } else {
+                recv_fd[j] = fds[i];
+            }
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.u32 = (uint32_t)j;
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, recv_fd[j], &ev);
+        }
+        received_fds += count;
+    }
+
+    std::vector<int64_t> latencies;
+    latencies.reserve(rounds * n);
+    struct epoll_event events[256];
+
+    int64_t t0 = now_ns();
+    for (long r = 0; r < rounds; r++) {
+        char go = 1;
+        if (write(ctl[0], &go, 1) != 1) break;
+        long pending = n;
+        while (pending > 0) {
+            int ready = epoll_wait(epoll_fd, events, 256, 1000);
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready <= 0) { printf("  (timed out)\n"); pending = 0; break; }
+            for (int e = 0; e < ready; e++) {
+                int j = (int)events[e].data.u32;
+                BenchMessage m;
+                if (t == BENCH_SHM) {
+                    ShmRing* ring = &channels[j]->to_tower;
+                    shm_ring_finish_wait(ring, recv_fd[j]);
+                    do {
+                        while (shm_ring_recv(ring, &m, sizeof(m))) {
+                            latencies.push_back(now_ns() - m.sent_ns);
+                            pending--;
+                        }
+                    } while (!shm_ring_prepare_wait(ring));
+                } else if (read(recv_fd[j], &m, sizeof(m)) == (ssize_t)sizeof(m)) {
+                    latencies.push_back(now_ns() - m.sent_ns);
+                    pending--;
+                }
+            }
+        }
+    }
+    int64_t t1 = now_ns();
+
+    close(ctl[0]);
+    waitpid(pid, NULL, 0);
+    for (int j = 0; j < n; j++) {
+        close(recv_fd[j]);
+        if (channels[j]) munmap(channels[j], sizeof(ShmChannel));
+    }
+    close(epoll_fd);
+
+    if (latencies.empty()) return;
+    std::sort(latencies.begin(), latencies.end());
+    size_t count = latencies.size();
+    printf("%10d %12s %14.0f %12.1f %12.1f\n", n, TRANSPORT_NAMES[t],
+        count / ((t1 - t0) / 1e9), latencies[count / 2] / 1e3, latencies[count * 99 / 100] / 1e3);
+}
+
+int main() {
+    printf("======================================\n");
+    printf("    OPERATION SKYWATCH - IPC BENCHMARK\n");
+    printf("======================================\n");
+
+    printf("\n--- Feedback bursts, one message per jet per round ---\n");
+    printf("%10s %12s %14s %12s %12s\n", "jets", "transport", "msgs/sec", "p50 (us)", "p99 (us)");
+    for (int p = 0; p < NUM_POPULATIONS; p++) {
+        bench_transport(BENCH_PIPE, POPULATIONS[p]);
+        bench_transport(BENCH_SOCKETPAIR, POPULATIONS[p]);
+        bench_transport(BENCH_SHM, POPULATIONS[p]);
+    }
+    return 0;
+}
@@ -0,0 +1,894 @@
+#include "utils.h"
+#include "scheduler.h"
+#include "jet_model.h"
+#include "sector.h"
+#include <time.h>
+#include <vector>
+#include <algorithm>
+
+/**
+ * @brief Scheduler benchmarks. Drives the scheduler API directly with
+ * synthetic jets (no drone processes, no pipes, no log file).
+ *
+ * Compile: see README.md (links scheduler.cpp, jet_model.cpp and their dependencies)
+ *
+ * --only <list> runs some sections (queue,lookup,dispatch,tick,runways,
+ * refuel,sectors,api,scenarios). --json <file> also writes the api and
+ * scenarios results as JSON, for tracking regressions between versions.
+ */
+
+// --- NEW: Allocation counting. These wrap glibc's allocator for the whole
+// program (operator new goes through malloc), so a benchmark reads the
+// count before and after ---
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+static long alloc_count = 0;
+
+extern "C" void* malloc(size_t size) {
+    __atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+extern "C" void* calloc(size_t count, size_t size) {
+    __atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(count, size);
+}
+extern "C" void* realloc(void* ptr, size_t size) {
+    __atomic_add_fetch(&alloc_count, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+
+static long allocs() { return __atomic_load_n(&alloc_count, __ATOMIC_RELAXED); }
+
+static const int POPULATIONS[] = { 20, 100, 1000, 10000, 100000 };
+static const int NUM_POPULATIONS = sizeof(POPULATIONS) / sizeof(POPULATIONS[0]);
+
+static double now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double percentile(std::vector<double>* samples, double pct) {
+    if (samples->empty()) return 0;
+    size_t k = (size_t)(pct / 100.0 * (samples->size() - 1));
+    std::nth_element(samples->begin(), samples->begin() + k, samples->end());
+    return (*samples)[k];
+}
+
+// --- MODIFIED: Warm runs, repeated, so small populations are not one cold pass ---
+#define QUEUE_RUNS 7            // Median of this many warm runs per population
+#define QUEUE_RUN_OPS 200000    // Each run repeats the population up to about this many jets
+
+/**
+ * @brief Per-operation cost of the jet pool and queue lists.
+ * Dequeue is measured through scheduler_jet_landed_unsafe (index
+ * lookup, unlink and pool release). "grow" is the first enqueue pass
+ * on a fresh scheduler, which also allocates the pool slabs and sizes
+ * the pid index. The other columns are the median of QUEUE_RUNS runs
+ * after that pass, when the pool already holds the population.
+ */
+static void bench_queue_ops() {
+    printf("\n--- Queue operations (ns/op, median of %d warm runs) ---\n", QUEUE_RUNS);
+    printf("%10s %12s %12s %12s %12s\n", "jets", "grow", "enqueue", "move", "dequeue");
+
+    for (int p = 0; p < NUM_POPULATIONS; p++) {
+        int n = POPULATIONS[p];
+        int rounds = (n < QUEUE_RUN_OPS) ? QUEUE_RUN_OPS / n : 1;
+        SchedulerState s;
+        scheduler_init(&s);
+
+        // Cold pass: grows the pool and the index to n jets
+        double t0 = now_ns();
+        for (int i = 0; i < n; i++) {
+            scheduler_add_jet(&s, (pid_t)(i + 1), -1, -1, 60, NULL);
+        }
+        double grow = (now_ns() - t0) / n;
+        for (int i = 0; i < n; i++) {
+            scheduler_jet_landed_unsafe(&s, s.queue2.head->pid, NULL);
+        }
+
+        std::vector<double> enqueue, move, dequeue;
+        for (int run = 0; run < QUEUE_RUNS; run++) {
+            double enqueue_ns = 0, move_ns = 0, dequeue_ns = 0;
+            for (int k = 0; k < rounds; k++) {
+                double t1 = now_ns();
+                for (int i = 0; i < n; i++) {
+                    scheduler_add_jet(&s, (pid_t)(i + 1), -1, -1, 60, NULL);
+                }
+                double t2 = now_ns();
+
+                // Q2 -> Q3 -> Q2 for every jet, always taking the current head
+                for (int i = 0; i < n; i++) {
+                    scheduler_move_jet_unsafe(&s, s.queue2.head, 3, NULL);
+                }
+                for (int i = 0; i < n; i++) {
+                    scheduler_move_jet_unsafe(&s, s.queue3.head, 2, NULL);
+                }
+                double t3 = now_ns();
+
+                for (int i = 0; i < n; i++) {
+                    scheduler_jet_landed_unsafe(&s, s.queue2.head->pid, NULL);
+                }
+                double t4 = now_ns();
+                enqueue_ns += t2 - t1;
+                move_ns += t3 - t2;
+                dequeue_ns += t4 - t3;
+            }
+            double ops = (double)n * rounds;
+            enqueue.push_back(enqueue_ns / ops);
+            move.push_back(move_ns / (2.0 * ops));
+            dequeue.push_back(dequeue_ns / ops);
+        }
+
+        printf("%10d %12.1f %12.1f %12.1f %12.1f\n", n, grow,
+            percentile(&enqueue, 50.0), percentile(&move, 50.0), percentile(&dequeue, 50.0));
+
+        scheduler_destroy(&s);
+    }
+}
+
+// The pre-index lookup: walk every queue until the pid turns up
+static SchedulerJet* find_jet_by_scan(SchedulerState* s, pid_t pid) {
+    for (int q = 1; q <= 3; q++) {
+        for (SchedulerJet* jet = scheduler_get_queue(s, q)->head; jet != NULL; jet = jet->next) {
+            if (jet->pid == pid) return jet;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief scheduler_find_jet_unsafe (hash index) against a linear scan
+ * of the queues. Jets are spread over all three queues and looked up
+ * in a pseudo-random order.
+ */
+static void bench_lookup() {
+    static const int SIZES[] = { 20, 1000, 100000 };
+    printf("\n--- PID lookup (ns/op) ---\n");
+    printf("%10s %12s %12s\n", "jets", "index", "scan");
+
+    for (int p = 0; p < 3; p++) {
+        int n = SIZES[p];
+        SchedulerState s;
+        scheduler_init(&s);
+        for (int i = 0; i < n; i++) {
+            scheduler_add_jet(&s, (pid_t)(i + 1), -1, -1, 60, NULL);
+        }
+        for (int i = 0; i < n / 3; i++) scheduler_move_jet_unsafe(&s, s.queue2.head, 1, NULL);
+        for (int i = 0; i < n / 3; i++) scheduler_move_jet_unsafe(&s, s.queue2.head, 3, NULL);
+
+        long found = 0;
+        int index_ops = 1000000;
+        unsigned int x = 12345;
+        double t0 = now_ns();
+        for (int i = 0; i < index_ops; i++) {
+            x = x * 1103515245u + 12345u;
+            found += scheduler_find_jet_unsafe(&s, (pid_t)(x % n + 1), NULL) != NULL;
+        }
+        double t1 = now_ns();
+
+        // The scan is O(n), so cap the total work
+        int scan_ops = (n <= 1000) ? 100000 : 2000;
+        x = 12345;
+        for (int i = 0; i < scan_ops; i++) {
+            x = x * 1103515245u + 12345u;
+            found += find_jet_by_scan(&s, (pid_t)(x % n + 1)) != NULL;
+        }
+        double t2 = now_ns();
+
+        if (found != index_ops + scan_ops) printf("  (lookup mismatch: %ld)\n", found);
+        printf("%10d %12.1f %12.1f\n", n, (t1 - t0) / index_ops, (t2 - t1) / scan_ops);
+
+        scheduler_destroy(&s);
+    }
+}
+
+// --- Runway throughput: scheduler + jet_model jets on a virtual clock ---
+
+struct RunwayBench {
+    std::vector<JetModel> jets;     // pid = index + 1
+    std::vector<std::pair<pid_t, JetFeedbackMessage> > feedback;
+    time_t now;
+};
+
+static void bench_feedback_sink(void* ctx, pid_t pid, JetFeedbackMessage msg) {
+    ((RunwayBench*)ctx)->feedback.push_back(std::make_pair(pid, msg));
+}
+
+static bool bench_command_hook(void* ctx, SchedulerJet* jet, AtcCommand command) {
+    RunwayBench* b = (RunwayBench*)ctx;
+    jet_model_command(&b->jets[jet->pid - 1], command, b->now, bench_feedback_sink, b);
+    return true;
+}
+
+// What tower_handle_feedback_unsafe does, minus stats and logging. Returns landings.
+// If hold_ns is set, the time s->lock was held is appended to it.
+static int bench_drain_feedback(SchedulerState* s, RunwayBench* b, std::vector<double>* hold_ns = NULL) {
+    int landed = 0;
+    pthread_mutex_lock(&s->lock);
+    double locked = hold_ns ? now_ns() : 0;
+    for (size_t i = 0; i < b->feedback.size(); i++) { // Handlers may append more
+        pid_t pid = b->feedback[i].first;
+        JetFeedbackMessage msg = b->feedback[i].second;
+        SchedulerJet* jet = scheduler_find_jet_unsafe(s, pid, NULL);
+        if (!jet) continue;
+        if (msg.status == STATUS_LANDED) { scheduler_jet_landed_unsafe(s, pid, NULL); landed++; }
+        else if (msg.status == STATUS_EMERGENCY) scheduler_handle_emergency_unsafe(s, pid, msg.data, NULL);
+        else if (msg.status == STATUS_FUEL_LOW) scheduler_update_fuel_unsafe(s, jet, msg.data);
+        else if (msg.status == STATUS_WAITING_FUEL) scheduler_handle_refuel_request_unsafe(s, pid, msg.data, NULL);
+        else if (msg.status == STATUS_REFUELED) scheduler_handle_refueled_unsafe(s, pid, msg.data, NULL);
+    }
+    b->feedback.clear();
+    if (hold_ns) hold_ns->push_back(now_ns() - locked);
+    pthread_mutex_unlock(&s->lock);
+    return landed;
+}
+
+// --- NEW: A runway lands one jet per JET_LANDING_TIME under any policy (300/hour) ---
+static int limit_violations = 0;
+
+static void check_landing_limit(const char* run, int landed, int runways, long seconds) {
+    if ((long)landed * JET_LANDING_TIME <= (long)runways * seconds) return;
+    printf("  LIMIT EXCEEDED (%s): %d landings on %d runways in %ld s, at most %ld\n",
+        run, landed, runways, seconds, (long)runways * seconds / JET_LANDING_TIME);
+    limit_violations++;
+}
+
+// One virtual hour at 1 arrival/s. Returns landings; runway/bay busy seconds and cpu ms via out params.
+static int bench_airfield_hour(int runways, int bays, const int* fuels, int fuel_count,
+                               double* runway_busy, double* bay_busy, double* cpu_ms) {
+    const int hour = 3600;
+    SchedulerState s;
+    scheduler_init(&s);
+    scheduler_set_runway_count(&s, runways);
+    scheduler_set_refuel_bays(&s, bays);
+    RunwayBench b;
+    b.jets.reserve(hour);
+    b.now = 1000000;
+    scheduler_set_virtual_time(b.now);
+    s.command_hook = bench_command_hook;
+    s.command_hook_ctx = &b;
+
+    int landed = 0;
+    double t0 = now_ns();
+    for (int t = 0; t < hour; t++) {
+        b.now++;
+        scheduler_set_virtual_time(b.now);
+        JetModel m;
+        jet_model_init(&m, (pid_t)(b.jets.size() + 1), fuels[t % fuel_count], b.now);
+        b.jets.push_back(m);
+        scheduler_add_jet(&s, m.pid, -1, -1, m.fuel_base, NULL);
+
+        for (size_t j = 0; j < b.jets.size(); j++) {
+            time_t due = jet_model_next_event(&b.jets[j]);
+            if (due != 0 && due <= b.now) jet_model_advance(&b.jets[j], b.now, bench_feedback_sink, &b);
+        }
+        landed += bench_drain_feedback(&s, &b);
+        scheduler_tick(&s, NULL);
+        landed += bench_drain_feedback(&s, &b);
+    }
+    *cpu_ms = (now_ns() - t0) / 1e6;
+    uint64_t runway_ns = 0, bay_ns = 0;
+    for (int r = 0; r < s.runway_count; r++) runway_ns += scheduler_runway_busy_ns_unsafe(&s, r);
+    for (int k = 0; k < s.bay_count; k++) bay_ns += scheduler_bay_busy_ns_unsafe(&s, k);
+    *runway_busy = runway_ns / 1e9 / (hour * (double)runways) * 100.0;
+    *bay_busy = bays > 0 ? bay_ns / 1e9 / (hour * (double)bays) * 100.0 : 0.0;
+    s.command_hook = NULL;
+    scheduler_destroy(&s);
+    return landed;
+}
+
+/**
+ * @brief Landings per hour against runway count. One jet arrives per
+ * second with the generator's fuel mix, for one virtual hour; landings
+ * in that hour are counted. A Q1 landing holds its runway for the full
+ * 12 s, a Q2 jet gives it back when its RR quantum expires.
+ */
+static void bench_runways() {
+    static const int RUNWAYS[] = { 1, 2, 4, 8, 12, 16 };
+    static const int FUELS[] = { 60, 20, 60, 40, 60, 60, 18, 50 };
+    printf("\n--- Runway throughput (1 arrival/s for 1 virtual hour) ---\n");
+    printf("%10s %14s %14s %12s\n", "runways", "landings/hour", "runway util", "cpu ms");
+
+    for (int k = 0; k < (int)(sizeof(RUNWAYS) / sizeof(RUNWAYS[0])); k++) {
+        double runway_util, bay_util, cpu_ms;
+        int landed = bench_airfield_hour(RUNWAYS[k], DEFAULT_REFUEL_BAYS, FUELS, 8, &runway_util, &bay_util, &cpu_ms);
+        printf("%10d %14d %13.1f%% %12.1f\n", RUNWAYS[k], landed, runway_util, cpu_ms);
+        check_landing_limit("runways", landed, RUNWAYS[k], 3600);
+    }
+}
+
+/**
+ * @brief Refuel bays against refuels on the runways, on a refuel-heavy
+ * mix (every other jet starts close to FUEL_REFUEL_LEVEL). 0 bays is
+ * the old behaviour: each refuel holds a runway for 10 s.
+ */
+static void bench_refuel_bays() {
+    static const int BAYS[] = { 0, 1, 2, 4 };
+    static const int FUELS[] = { 30, 60, 35, 60, 28, 45, 40, 60 };
+    const int runways = 4;
+    printf("\n--- Refuel bays (%d runways, refuel-heavy mix, 1 virtual hour) ---\n", runways);
+    printf("%10s %14s %14s %12s %12s\n", "bays", "landings/hour", "runway util", "bay util", "cpu ms");
+
+    for (int k = 0; k < (int)(sizeof(BAYS) / sizeof(BAYS[0])); k++) {
+        double runway_util, bay_util, cpu_ms;
+        int landed = bench_airfield_hour(runways, BAYS[k], FUELS, 8, &runway_util, &bay_util, &cpu_ms);
+        printf("%10d %14d %13.1f%% %11.1f%% %12.1f\n", BAYS[k], landed, runway_util, bay_util, cpu_ms);
+        check_landing_limit("refuel", landed, runways, 3600);
+    }
+}
+
+// --- Runway idle gap: tick-only dispatch against event-driven dispatch ---
+
+static bool bench_noop_hook(void*, SchedulerJet*, AtcCommand) { return true; }
+
+struct DispatchBench {
+    SchedulerState* s;
+    volatile bool running;
+};
+
+// The tower's scheduler_loop, on the real clock
+static void* bench_dispatch_thread(void* arg) {
+    DispatchBench* d = (DispatchBench*)arg;
+    int tick_fd = scheduler_open_tick_timer(TICK_PERIOD_MS);
+    while (d->running) {
+        int ticks;
+        bool dispatch;
+        scheduler_wait_events(d->s, tick_fd, 50, &ticks, &dispatch);
+        for (int t = 0; t < ticks; t++) scheduler_tick(d->s, NULL);
+        if (dispatch) scheduler_dispatch(d->s, NULL);
+    }
+    close(tick_fd);
+    return NULL;
+}
+
+// Lands the runway's jet `landings` times, each as soon as the next one is on it. Returns the average idle gap in us.
+static double bench_idle_gap(bool events, int landings, double* max_us) {
+    SchedulerState s;
+    scheduler_init(&s);
+    s.command_hook = bench_noop_hook;
+    if (events) scheduler_enable_dispatch_events(&s); // Otherwise only the tick dispatches
+    DispatchBench d = { &s, true };
+    pthread_t thread;
+    pthread_create(&thread, NULL, bench_dispatch_thread, &d);
+
+    for (int i = 0; i <= landings; i++) scheduler_add_jet(&s, (pid_t)(i + 1), -1, -1, 60, NULL);
+    for (int i = 0; i < landings; i++) {
+        for (;;) {
+            pthread_mutex_lock(&s.lock);
+            if (s.runways[0].busy) {
+                scheduler_jet_landed_unsafe(&s, s.runways[0].jet_pid, NULL);
+                pthread_mutex_unlock(&s.lock);
+                break;
+            }
+            pthread_mutex_unlock(&s.lock);
+            usleep(100);
+        }
+    }
+    // The last landing's successor
+    for (;;) {
+        pthread_mutex_lock(&s.lock);
+        bool busy = s.runways[0].busy;
+        pthread_mutex_unlock(&s.lock);
+        if (busy) break;
+        usleep(100);
+    }
+    d.running = false;
+    pthread_join(thread, NULL);
+
+    double avg_us = s.runway_idle_gap_ns / s.runway_dispatches / 1e3;
+    *max_us = s.runway_idle_gap_max_ns / 1e3;
+    s.command_hook = NULL;
+    scheduler_destroy(&s);
+    return avg_us;
+}
+
+/**
+ * @brief How long the runway stands idle between a landing and the
+ * next dispatch, with a jet always waiting. Tick-only dispatch waits
+ * for the next 1 s tick; with the dispatch eventfd the scheduler
+ * thread wakes on the landing itself. Real clock, so run it before
+ * anything switches the scheduler to virtual time.
+ */
+static void bench_dispatch() {
+    printf("\n--- Runway idle gap (1 runway, a jet always waiting, real clock) ---\n");
+    printf("%10s %10s %14s %14s\n", "dispatch", "landings", "avg gap (us)", "max gap (us)");
+
+    for (int events = 0; events <= 1; events++) {
+        int landings = events ? 2000 : 4; // Each tick-only landing costs up to a second
+        double max_us;
+        double avg_us = bench_idle_gap(events != 0, landings, &max_us);
+        printf("%10s %10d %14.1f %14.1f\n", events ? "event" : "tick", landings, avg_us, max_us);
+    }
+}
+
+// --- Sharded scheduler: tick throughput against sector count ---
+
+/**
+ * @brief Cost of scheduler_tick with n jets waiting in Q3, on a virtual
+ * clock advancing 1 ms per tick. While nothing is due a tick only looks
+ * at the timer wheel. Then the clock jumps past every aging deadline and
+ * one tick promotes them all.
+ */
+static void bench_tick() {
+    static const int SIZES[] = { 20, 1000, 100000 };
+    const int ticks = 5000; // 5 virtual seconds, short of the aging threshold
+    printf("\n--- Tick cost (jets waiting in Q3, 1 ms ticks, virtual clock) ---\n");
+    printf("%10s %16s %16s\n", "jets", "idle ns/tick", "aging ns/jet");
+
+    uint64_t clock = 1000 * NS_PER_SEC;
+    for (int p = 0; p < 3; p++) {
+        int n = SIZES[p];
+        scheduler_set_virtual_time_ns(clock, 0);
+        SchedulerState s;
+        scheduler_init(&s);
+        s.command_hook = bench_noop_hook;
+        for (int i = 0; i < n; i++) scheduler_add_jet(&s, (pid_t)(i + 1), -1, -1, 60, NULL);
+        for (int i = 0; i < n; i++) scheduler_move_jet_unsafe(&s, s.queue2.head, 3, NULL);
+        scheduler_tick(&s, NULL); // Settles the dispatch the arrivals asked for
+
+        double t0 = now_ns();
+        for (int i = 0; i < ticks; i++) {
+            clock += NS_PER_MS;
+            scheduler_set_virtual_time_ns(clock, 0);
+            scheduler_tick(&s, NULL);
+        }
+        double t1 = now_ns();
+
+        clock += (uint64_t)s.aging_ms * NS_PER_MS;
+        scheduler_set_virtual_time_ns(clock, 0);
+        double t2 = now_ns();
+        scheduler_tick(&s, NULL);
+        double t3 = now_ns();
+
+        if (s.queue2.count != n) printf("  (aged %d of %d jets)\n", s.queue2.count, n);
+        printf("%10d %16.1f %16.1f\n", n, (t1 - t0) / ticks, (t3 - t2) / n);
+        s.command_hook = NULL;
+        scheduler_destroy(&s);
+        clock += NS_PER_SEC;
+    }
+}
+
+struct SectorBenchThread {
+    SectorSet* set;
+    int index;
+    int ticks;
+};
+
+static void* bench_sector_thread(void* arg) {
+    SectorBenchThread* t = (SectorBenchThread*)arg;
+    sector_pin_thread(t->index);
+    for (int i = 0; i < t->ticks; i++) sector_run_tick(t->set, t->index, NULL);
+    return NULL;
+}
+
+/**
+ * @brief Aggregate tick throughput (jets visited per second) with the
+ * same 100k jets split over 1 to 8 sectors, each ticking on its own
+ * pinned thread. Then every jet is put in sector 1 and each sector ticks
+ * once, to show idle sectors stealing work to fill their runways.
+ */
+static void bench_sectors() {
+    static const int SECTORS[] = { 1, 2, 4, 8 };
+    const int jets = 100000, ticks = 50, runways_per_sector = 4;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("\n--- Sectors (%d jets, %d ticks, %d runways per sector, %ld cores) ---\n",
+        jets, ticks, runways_per_sector, cores);
+    printf("%10s %16s %10s %18s %10s\n", "sectors", "jet-ticks/s", "speedup", "runways filled*", "steals");
+
+    double base = 0;
+    for (int k = 0; k < (int)(sizeof(SECTORS) / sizeof(SECTORS[0])); k++) {
+        int n = SECTORS[k];
+        double rate = 0;
+        int filled = 0;
+        long steals = 0;
+        for (int imbalanced = 0; imbalanced <= 1; imbalanced++) {
+            SchedulerState first;
+            scheduler_init(&first);
+            SectorSet set;
+            sectors_init(&set, &first, n, n * runways_per_sector, 0);
+            sectors_set_command_hook(&set, bench_noop_hook, NULL);
+            // Imbalanced: pids that are multiples of n all land in sector 1
+            for (int i = 0; i < jets; i++) {
+                sectors_add_jet(&set, (pid_t)(imbalanced ? (i + 1) * n : i + 1), -1, -1, 60, NULL);
+            }
+
+            if (!imbalanced) {
+                SectorBenchThread threads[MAX_SECTORS];
+                pthread_t ids[MAX_SECTORS];
+                double t0 = now_ns();
+                for (int i = 0; i < n; i++) {
+                    threads[i].set = &set;
+                    threads[i].index = i;
+                    threads[i].ticks = ticks;
+                    pthread_create(&ids[i], NULL, bench_sector_thread, &threads[i]);
+                }
+                for (int i = 0; i < n; i++) pthread_join(ids[i], NULL);
+                rate = (double)jets * ticks / ((now_ns() - t0) / 1e9);
+            } else {
+                for (int i = 0; i < n; i++) sector_run_tick(&set, i, NULL);
+                for (int i = 0; i < n; i++) {
+                    filled += set.sectors[i].s->runways_busy;
+                    steals += set.sectors[i].steals;
+                }
+            }
+            sectors_set_command_hook(&set, NULL, NULL);
+            sectors_destroy(&set);
+            scheduler_destroy(&first);
+        }
+        if (k == 0) base = rate;
+        char filled_str[32];
+        snprintf(filled_str, sizeof(filled_str), "%d/%d", filled, n * runways_per_sector);
+        printf("%10d %16.3e %9.2fx %18s %10ld\n", n, rate, rate / base, filled_str, steals);
+    }
+    printf("  * after one tick per sector with every jet arriving in sector 1\n");
+}
+
+// --- NEW: Scheduler API and scenario suite (--only api,scenarios, --json) ---
+
+struct BenchConfig {
+    std::vector<int> populations;   // --jets, for the api section
+    int mix[3];                     // --mix: percent of the jets in Q1, Q2, Q3
+    const char* json_path;          // --json
+    const char* label;              // --label, copied into the JSON
+};
+
+static BenchConfig config;
+
+struct ApiResult {
+    const char* op;
+    int jets;
+    long ops;
+    double ns_per_op;
+    double allocs_per_op;
+};
+
+struct ScenarioResult {
+    const char* name;
+    int jets;
+    int landed;
+    long sim_seconds;
+    double landings_per_sim_sec;
+    double wall_ms;             // Whole run, including the simulated jets
+    double scheduler_ms;        // Time spent holding s->lock
+    double allocs_per_landing;
+    int context_switches;
+    double hold_mean_ns;        // One critical section: a tick, an arrival or a batch of feedback
+    double hold_p99_ns;
+    double hold_max_ns;
+};
+
+static std::vector<ApiResult> api_results;
+static std::vector<ScenarioResult> scenario_results;
+static uint64_t suite_clock = 5000 * NS_PER_SEC; // Virtual clock of the api section
+
+// n jets (fuel 30 to 89) spread over Q1/Q2/Q3 by config.mix, with the runways filled
+static void bench_populate(SchedulerState* s, int n) {
+    scheduler_set_virtual_time_ns(suite_clock, 0);
+    scheduler_init(s);
+    s->command_hook = bench_noop_hook;
+    for (int i = 0; i < n; i++) scheduler_add_jet(s, (pid_t)(i + 1), -1, -1, 30 + i % 60, NULL);
+    int to_q1 = n * config.mix[0] / 100;
+    int to_q3 = n * config.mix[2] / 100;
+    for (int i = 0; i < to_q1 && s->queue2.head; i++) scheduler_move_jet_unsafe(s, s->queue2.head, 1, NULL);
+    for (int i = 0; i < to_q3 && s->queue2.head; i++) scheduler_move_jet_unsafe(s, s->queue2.head, 3, NULL);
+    scheduler_tick(s, NULL); // Fills the runways
+}
+
+static void bench_unpopulate(SchedulerState* s) {
+    s->command_hook = NULL;
+    scheduler_destroy(s);
+    suite_clock += 100 * NS_PER_SEC;
+}
+
+// Up to max Q2/Q3 jets that hold nothing, in queue order
+static void bench_waiting_jets(SchedulerState* s, std::vector<SchedulerJet*>* out, size_t max) {
+    out->clear();
+    for (int q = 2; q <= 3; q++) {
+        for (SchedulerJet* jet = scheduler_get_queue(s, q)->head; jet && out->size() < max; jet = jet->next) {
+            if (jet->runway < 0 && jet->bay < 0) out->push_back(jet);
+        }
+    }
+}
+
+static void api_result(const char* op, int jets, long ops, double ns, long allocated) {
+    ApiResult res = { op, jets, ops, ns / ops, (double)allocated / ops };
+    api_results.push_back(res);
+    printf("%10d %-12s %12.1f %12.4f\n", jets, op, res.ns_per_op, res.allocs_per_op);
+}
+
+/**
+ * @brief ns/op and allocations/op of the scheduler calls the tower makes
+ * most, for each --jets population in the --mix queue mix:
+ * scheduler_find_jet_unsafe (random pids), scheduler_move_jet_unsafe
+ * (Q2 <-> Q3), scheduler_handle_emergency_unsafe (every runway held, so
+ * it preempts) and scheduler_tick (1 ms virtual steps).
+ */
+static void bench_api() {
+    printf("\n--- Scheduler API (Q1/Q2/Q3 mix %d/%d/%d%%, virtual clock) ---\n",
+        config.mix[0], config.mix[1], config.mix[2]);
+    printf("%10s %-12s %12s %12s\n", "jets", "op", "ns/op", "allocs/op");
+    std::vector<SchedulerJet*> jets;
+
+    for (size_t p = 0; p < config.populations.size(); p++) {
+        int n = config.populations[p];
+        SchedulerState s;
+        bench_populate(&s, n);
+
+        const long find_ops = 1000000;
+        unsigned int x = 12345;
+        long found = 0;
+        long a0 = allocs();
+        double t0 = now_ns();
+        for (long i = 0; i < find_ops; i++) {
+            x = x * 1103515245u + 12345u;
+            found += scheduler_find_jet_unsafe(&s, (pid_t)(x % n + 1), NULL) != NULL;
+        }
+        api_result("find", n, find_ops, now_ns() - t0, allocs() - a0);
+        if (found != find_ops) printf("  (lookup mismatch: %ld)\n", found);
+
+        bench_waiting_jets(&s, &jets, 4096);
+        if (!jets.empty()) {
+            const long move_ops = 200000;
+            a0 = allocs();
+            t0 = now_ns();
+            for (long i = 0; i < move_ops; i++) {
+                SchedulerJet* jet = jets[i % jets.size()];
+                scheduler_move_jet_unsafe(&s, jet, jet->queue == 2 ? 3 : 2, NULL);
+            }
+            api_result("move", n, move_ops, now_ns() - t0, allocs() - a0);
+        }
+
+        const long ticks = 5000;
+        a0 = allocs();
+        t0 = now_ns();
+        for (long i = 0; i < ticks; i++) {
+            suite_clock += NS_PER_MS;
+            scheduler_set_virtual_time_ns(suite_clock, 0);
+            scheduler_tick(&s, NULL);
+        }
+        api_result("tick", n, ticks, now_ns() - t0, allocs() - a0);
+        bench_unpopulate(&s);
+
+        // An emergency changes the state for good, so each batch starts from a fresh population
+        long emergency_ops = 0, emergency_allocs = 0;
+        double emergency_ns = 0;
+        for (int batch = 0; batch < 50 && emergency_ops < 10000; batch++) {
+            bench_populate(&s, n);
+            bench_waiting_jets(&s, &jets, 1000);
+            a0 = allocs();
+            t0 = now_ns();
+            for (size_t i = 0; i < jets.size(); i++) {
+                scheduler_handle_emergency_unsafe(&s, jets[i]->pid, 5 + (int)(i % 5), NULL);
+            }
+            emergency_ns += now_ns() - t0;
+            emergency_allocs += allocs() - a0;
+            emergency_ops += jets.size();
+            bench_unpopulate(&s);
+        }
+        if (emergency_ops > 0) api_result("emergency", n, emergency_ops, emergency_ns, emergency_allocs);
+    }
+}
+
+struct Scenario {
+    const char* name;
+    int jets;
+    int per_second;     // Arrivals per virtual second until all have arrived
+    int runways;
+    int bays;
+    const int* fuels;   // Initial fuel, cycled
+    int fuel_count;
+};
+
+// Runs until every jet has landed (or a virtual day after the last arrival)
+static ScenarioResult run_scenario(const Scenario* sc) {
+    SchedulerState s;
+    scheduler_init(&s);
+    scheduler_set_runway_count(&s, sc->runways);
+    scheduler_set_refuel_bays(&s, sc->bays);
+    RunwayBench b;
+    b.jets.reserve(sc->jets);
+    b.now = 2000000;
+    scheduler_set_virtual_time(b.now);
+    s.command_hook = bench_command_hook;
+    s.command_hook_ctx = &b;
+
+    std::vector<double> hold_ns;
+    int landed = 0;
+    time_t start = b.now;
+    time_t give_up = start + (sc->jets + sc->per_second - 1) / sc->per_second + 86400;
+    long a0 = allocs();
+    double t0 = now_ns();
+    while (landed < sc->jets && b.now < give_up) {
+        b.now++;
+        scheduler_set_virtual_time(b.now);
+        for (int k = 0; k < sc->per_second && (int)b.jets.size() < sc->jets; k++) {
+            JetModel m;
+            jet_model_init(&m, (pid_t)(b.jets.size() + 1), sc->fuels[b.jets.size() % sc->fuel_count], b.now);
+            b.jets.push_back(m);
+            double t = now_ns();
+            scheduler_add_jet(&s, m.pid, -1, -1, m.fuel_base, NULL);
+            hold_ns.push_back(now_ns() - t);
+        }
+        for (size_t j = 0; j < b.jets.size(); j++) {
+            time_t due = jet_model_next_event(&b.jets[j]);
+            if (due != 0 && due <= b.now) jet_model_advance(&b.jets[j], b.now, bench_feedback_sink, &b);
+        }
+        landed += bench_drain_feedback(&s, &b, &hold_ns);
+        double t = now_ns();
+        scheduler_tick(&s, NULL);
+        hold_ns.push_back(now_ns() - t);
+        landed += bench_drain_feedback(&s, &b, &hold_ns);
+    }
+
+    ScenarioResult res;
+    res.wall_ms = (now_ns() - t0) / 1e6;
+    long allocated = allocs() - a0;
+    res.name = sc->name;
+    res.jets = sc->jets;
+    res.landed = landed;
+    res.sim_seconds = (long)(b.now - start);
+    res.landings_per_sim_sec = res.sim_seconds ? (double)landed / res.sim_seconds : 0;
+    double held = 0, held_max = 0;
+    for (size_t i = 0; i < hold_ns.size(); i++) {
+        held += hold_ns[i];
+        if (hold_ns[i] > held_max) held_max = hold_ns[i];
+    }
+    res.scheduler_ms = held / 1e6;
+    res.allocs_per_landing = landed ? (double)allocated / landed : 0;
+    res.context_switches = s.total_context_switches;
+    res.hold_mean_ns = hold_ns.empty() ? 0 : held / hold_ns.size();
+    res.hold_p99_ns = percentile(&hold_ns, 99.0);
+    res.hold_max_ns = held_max;
+    s.command_hook = NULL;
+    scheduler_destroy(&s);
+    return res;
+}
+
+/**
+ * @brief End-to-end scenarios on jet_model jets and a virtual clock.
+ * Each runs until every jet has landed. landings/s is per simulated
+ * second; wall ms is the real cost of the run, of which "sched ms" is
+ * time spent holding s->lock (ticks, arrivals, feedback). Lock hold is
+ * per critical section.
+ */
+static void bench_scenarios() {
+    static const int GENERATOR_MIX[] = { 60, 20, 60, 40, 60, 60, 18, 50 };
+    static const int EMERGENCY_MIX[] = { 14, 12, 60, 16, 11, 60, 18, 13 };
+    static const int REFUEL_MIX[] = { 30, 60, 35, 60, 28, 45, 40, 60 };
+    static const Scenario SCENARIOS[] = {
+        { "steady", 1800, 1, 4, 1, GENERATOR_MIX, 8 },
+        { "burst", 2000, 200, 4, 1, GENERATOR_MIX, 8 },
+        { "emergency_storm", 600, 2, 4, 1, EMERGENCY_MIX, 8 },
+        { "refuel_heavy", 1800, 1, 4, 2, REFUEL_MIX, 8 },
+    };
+    printf("\n--- Scenarios (jet_model jets, virtual clock, run until all land) ---\n");
+    printf("%-16s %6s %9s %10s %10s %10s %11s %10s %10s\n", "scenario", "jets", "sim s",
+        "landings/s", "wall ms", "sched ms", "allocs/lnd", "hold p99", "hold max");
+
+    for (int k = 0; k < (int)(sizeof(SCENARIOS) / sizeof(SCENARIOS[0])); k++) {
+        ScenarioResult res = run_scenario(&SCENARIOS[k]);
+        scenario_results.push_back(res);
+        printf("%-16s %6d %9ld %10.3f %10.1f %10.1f %11.3f %8.0fns %8.0fns\n", res.name, res.jets,
+            res.sim_seconds, res.landings_per_sim_sec, res.wall_ms, res.scheduler_ms,
+            res.allocs_per_landing, res.hold_p99_ns, res.hold_max_ns);
+        if (res.landed != res.jets) printf("  (%d of %d jets landed)\n", res.landed, res.jets);
+        check_landing_limit(res.name, res.landed, SCENARIOS[k].runways, res.sim_seconds);
+    }
+}
+
+static bool write_json(const char* path) {
+    FILE* out = (strcmp(path, "-") == 0) ? stdout : fopen(path, "w");
+    if (!out) return false;
+    fprintf(out, "{\n  \"benchmark\": \"bench_scheduler\",\n  \"label\": \"%s\",\n", config.label);
+    fprintf(out, "  \"policy\": \"%s\",\n", scheduler_policy_name());
+    fprintf(out, "  \"unix_time\": %ld,\n  \"cores\": %ld,\n", (long)time(NULL), sysconf(_SC_NPROCESSORS_ONLN));
+    fprintf(out, "  \"mix\": { \"q1\": %d, \"q2\": %d, \"q3\": %d },\n", config.mix[0], config.mix[1], config.mix[2]);
+    fprintf(out, "  \"api\": [");
+    for (size_t i = 0; i < api_results.size(); i++) {
+        const ApiResult* a = &api_results[i];
+        fprintf(out, "%s\n    { \"op\": \"%s\", \"jets\": %d, \"ops\": %ld, \"ns_per_op\": %.2f, \"allocs_per_op\": %.6f }",
+            i ? "," : "", a->op, a->jets, a->ops, a->ns_per_op, a->allocs_per_op);
+    }
+    fprintf(out, "%s],\n  \"scenarios\": [", api_results.empty() ? "" : "\n  ");
+    for (size_t i = 0; i < scenario_results.size(); i++) {
+        const ScenarioResult* r = &scenario_results[i];
+        fprintf(out, "%s\n    { \"scenario\": \"%s\", \"jets\": %d, \"landed\": %d, \"sim_seconds\": %ld, "
+            "\"landings_per_sim_sec\": %.4f, \"wall_ms\": %.2f, \"scheduler_ms\": %.2f, "
+            "\"allocs_per_landing\": %.4f, \"context_switches\": %d, "
+            "\"lock_hold_ns\": { \"mean\": %.1f, \"p99\": %.1f, \"max\": %.1f } }",
+            i ? "," : "", r->name, r->jets, r->landed, r->sim_seconds, r->landings_per_sim_sec,
+            r->wall_ms, r->scheduler_ms, r->allocs_per_landing, r->context_switches,
+            r->hold_mean_ns, r->hold_p99_ns, r->hold_max_ns);
+    }
+    fprintf(out, "%s]\n}\n", scenario_results.empty() ? "" : "\n  ");
+    if (out != stdout) fclose(out);
+    return true;
+}
+
+static void print_usage(const char* prog) {
+    printf("Usage: %s [--only <sections>] [--jets <n,n,...>] [--mix <q1:q2:q3>] [--json <file>] [--label <text>]\n", prog);
+    printf("  --only <list>   Comma-separated: queue,lookup,dispatch,tick,runways,refuel,sectors,api,scenarios\n");
+    printf("  --jets <list>   Populations for the api section (default 20,1000,100000)\n");
+    printf("  --mix <a:b:c>   Percent of the api jets in Q1, Q2 and Q3 (default 10:60:30)\n");
+    printf("  --json <file>   Also write the api and scenarios results as JSON (- for stdout)\n");
+    printf("  --label <text>  Stored in the JSON, e.g. a version or commit\n");
+}
+
+// Section `name` was asked for (all of them without --only)
+static bool selected(const char* only, const char* name) {
+    if (only == NULL) return true;
+    size_t len = strlen(name);
+    for (const char* p = only; (p = strstr(p, name)) != NULL; p += len) {
+        bool starts = (p == only || p[-1] == ',');
+        bool ends = (p[len] == '\0' || p[len] == ',');
+        if (starts && ends) return true;
+    }
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    const char* only = NULL;
+    config.mix[0] = 10;
+    config.mix[1] = 60;
+    config.mix[2] = 30;
+    config.json_path = NULL;
+    config.label = "";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (strcmp(argv[i], "--jets") == 0 && i + 1 < argc) {
+            for (char* p = argv[++i]; *p; ) {
+                int n = (int)strtol(p, &p, 10);
+                if (n > 0) config.populations.push_back(n);
+                if (*p == ',') p++;
+                else if (*p) { print_usage(argv[0]); return 1; }
+            }
+        } else if (strcmp(argv[i], "--mix") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d:%d:%d", &config.mix[0], &config.mix[1], &config.mix[2]) != 3 ||
+                config.mix[0] < 0 || config.mix[1] < 0 || config.mix[2] < 0 ||
+                config.mix[0] + config.mix[1] + config.mix[2] != 100) {
+                printf("--mix needs three percentages that add up to 100\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            config.json_path = argv[++i];
+        } else if (strcmp(argv[i], "--label") == 0 && i + 1 < argc) {
+            config.label = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.populations.empty()) {
+        config.populations.push_back(20);
+        config.populations.push_back(1000);
+        config.populations.push_back(100000);
+    }
+
+    printf("======================================\n");
+    printf("    OPERATION SKYWATCH - BENCHMARKS\n");
+    printf("======================================\n");
+    printf("Scheduling policy: %s\n", scheduler_policy_name());
+
+    if (selected(only, "queue")) bench_queue_ops();
+    if (selected(only, "lookup")) bench_lookup();
+    if (selected(only, "dispatch")) bench_dispatch(); // Real clock: before the virtual-time benchmarks
+    if (selected(only, "tick")) bench_tick();
+    if (selected(only, "runways")) bench_runways();
+    if (selected(only, "refuel")) bench_refuel_bays();
+    if (selected(only, "sectors")) bench_sectors();
+    if (selected(only, "api")) bench_api();
+    if (selected(only, "scenarios")) bench_scenarios();
+
+    if (config.json_path && !write_json(config.json_path)) {
+        perror("Failed to write JSON results");
+        return 1;
+    }
+    if (limit_violations > 0) {
+        printf("\n%d run(s) landed more jets than the runways can (%s policy)\n", limit_violations, scheduler_policy_name());
+        return 1;
+    }
+    return 0;
+}
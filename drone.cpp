@@ -1,4 +1,7 @@
 #include "utils.h"
+#include "shm_ring.h"
+#include <poll.h>
+#include <errno.h>
 
 // --- Student Information ---
 const char* STUDENT_ROLLNO = "23i-2035";
@@ -9,10 +12,57 @@ bool is_emergency = false;
 bool keep_running = true;
 bool is_landing = false; 
 
-// Pipe FDs
+// Pipe FDs (the doorbell eventfds when running on shm rings)
 int atc_read_fd;  
 int atc_write_fd; 
 
+// --- NEW: Shared-memory transport ---
+ShmChannel* shm_channel = NULL;
+pthread_mutex_t shm_send_lock = PTHREAD_MUTEX_INITIALIZER; // Fuel and main thread both send
+pid_t tower_pid;
+
+// --- NEW: Shared feedback socket (atc_write_fd is shared by every drone) ---
+bool mux_feedback = false;
+unsigned int feedback_seq = 0;
+pthread_mutex_t mux_lock = PTHREAD_MUTEX_INITIALIZER; // Keeps seq order == send order
+
+/**
+ * @brief NEW: Sends one message to the tower over the pipe or the ring.
+ */
+bool jet_send(const void* msg, size_t len) 
+{
+    if (shm_channel == NULL) return write(atc_write_fd, msg, len) != -1;
+
+    pthread_mutex_lock(&shm_send_lock);
+    while (!shm_ring_send(&shm_channel->to_tower, atc_write_fd, msg, len)) 
+    {
+        usleep(1000); // Ring full: the tower is behind
+    }
+    pthread_mutex_unlock(&shm_send_lock);
+    return true;
+}
+
+/**
+ * @brief NEW: Blocks for the next message from the tower.
+ * Returns the bytes read, 0 once the tower is gone, -1 on error.
+ */
+ssize_t jet_recv(void* msg, size_t len) 
+{
+    if (shm_channel == NULL) return read(atc_read_fd, msg, len);
+
+    for (;;) 
+    {
+        if (shm_ring_recv(&shm_channel->to_jet, msg, len)) return (ssize_t)len;
+        if (!shm_ring_prepare_wait(&shm_channel->to_jet)) continue;
+
+        struct pollfd pfd = { atc_read_fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, 1000);
+        shm_ring_finish_wait(&shm_channel->to_jet, atc_read_fd);
+        if (ready < 0 && errno != EINTR) return -1;
+        if (ready == 0 && getppid() != tower_pid) return 0; // No EOF on a ring: tower exited
+    }
+}
+
 const char* my_jet_id = "UNKNOWN-ID";
 
 /**
@@ -27,7 +77,23 @@ void send_status(JetStatus status, int data = 0)
     msg.status = status;
     msg.data = data; 
     
-    if (write(atc_write_fd, &msg, sizeof(JetFeedbackMessage)) == -1) 
+    bool sent;
+    if (mux_feedback) 
+    {
+        pthread_mutex_lock(&mux_lock);
+        JetTaggedFeedback tagged;
+        tagged.pid = getpid();
+        tagged.seq = feedback_seq++;
+        tagged.msg = msg;
+        sent = jet_send(&tagged, sizeof(JetTaggedFeedback));
+        pthread_mutex_unlock(&mux_lock);
+    } 
+    else 
+    {
+        sent = jet_send(&msg, sizeof(JetFeedbackMessage));
+    }
+    
+    if (!sent) 
     {
         perror("Jet: Pipe write error");
     }
@@ -45,17 +111,17 @@ void* fuel_thread_loop(void* arg)
         
         if (is_landing) continue; 
         
-        if (my_fuel == 20 && !is_emergency) 
+        if (my_fuel == FUEL_LOW_LEVEL && !is_emergency) 
         {
              send_status(STATUS_FUEL_LOW, my_fuel);
         }
         
-        if (my_fuel == 25 && !is_emergency)
+        if (my_fuel == FUEL_REFUEL_LEVEL && !is_emergency)
         {
             send_status(STATUS_WAITING_FUEL, my_fuel);
         }
         
-        if (my_fuel <= 10 && !is_emergency) 
+        if (my_fuel <= FUEL_EMERGENCY_LEVEL && !is_emergency) 
         {
             is_emergency = true;
             send_status(STATUS_EMERGENCY, my_fuel);
@@ -78,7 +144,7 @@ void run_jet_main_loop()
 
     while (keep_running) 
     {
-        ssize_t bytes_read = read(atc_read_fd, &command, sizeof(AtcCommandMessage));
+        ssize_t bytes_read = jet_recv(&command, sizeof(AtcCommandMessage));
         
         if (bytes_read <= 0) 
         {
@@ -98,7 +164,7 @@ void run_jet_main_loop()
             // --- REMOVED cout ---
             
             // --- MODIFIED: Landing now takes 12 seconds ---
-            sleep(12); 
+            sleep(JET_LANDING_TIME); 
             
             // --- REMOVED cout ---
                  
@@ -112,8 +178,8 @@ void run_jet_main_loop()
             send_status(STATUS_REFUELING); 
             
             // --- MODIFIED: Refuel now takes 10 seconds ---
-            sleep(10);
-            my_fuel += 75; 
+            sleep(JET_REFUEL_TIME);
+            my_fuel += JET_REFUEL_AMOUNT; 
             
             // --- REMOVED cout ---
             
@@ -128,17 +194,64 @@ void run_jet_main_loop()
  */
 int main(int argc, char* argv[]) 
 {
-    if (argc != 5) 
+    bool use_shm = (argc == 5 && strcmp(argv[1], "--shm") == 0);
+    mux_feedback = (argc == 4 && strcmp(argv[1], "--mux") == 0);
+    if (argc != 5 && argc != 3 && !mux_feedback) 
     {
         // Keep this one cout for critical argument errors
-        cout << "Jet Process: Invalid arguments. " << "Expected: <read_fd> <write_fd> <fuel> <jet_id>" << endl;
+        cout << "Jet Process: Invalid arguments. " << "Expected: <read_fd> <write_fd> [<fuel> <jet_id>]" 
+             << " or --shm <mem_fd> <jet_bell> <tower_bell> or --mux <read_fd> <mux_fd>" << endl;
         return 1;
     }
     
-    atc_read_fd = atoi(argv[1]);
-    atc_write_fd = atoi(argv[2]);
-    int initial_fuel = atoi(argv[3]);
-    my_jet_id = argv[4];
+    if (use_shm) 
+    {
+        // --- NEW: Rings in the shared memfd, eventfds as doorbells ---
+        int mem_fd = atoi(argv[2]);
+        atc_read_fd = atoi(argv[3]);
+        atc_write_fd = atoi(argv[4]);
+        tower_pid = getppid();
+        shm_channel = shm_channel_attach(mem_fd);
+        close(mem_fd);
+        if (shm_channel == NULL) 
+        {
+            perror("Jet: Failed to map shm channel");
+            return 1;
+        }
+    } 
+    else if (mux_feedback) 
+    {
+        atc_read_fd = atoi(argv[2]);
+        atc_write_fd = atoi(argv[3]);
+    } 
+    else 
+    {
+        atc_read_fd = atoi(argv[1]);
+        atc_write_fd = atoi(argv[2]);
+    }
+    int initial_fuel;
+
+    // --- NEW: Warm pool drone: fuel and id arrive later with CMD_ACTIVATE ---
+    static AtcActivateMessage activate;
+    if (argc == 3 || use_shm || mux_feedback) 
+    {
+        ssize_t bytes_read = jet_recv(&activate, sizeof(AtcActivateMessage));
+        if (bytes_read != (ssize_t)sizeof(AtcActivateMessage) || activate.command != CMD_ACTIVATE) 
+        {
+            // Pool shut down before this drone was used
+            close(atc_read_fd);
+            close(atc_write_fd);
+            return 0;
+        }
+        activate.jet_id[sizeof(activate.jet_id) - 1] = '\0';
+        initial_fuel = activate.initial_fuel;
+        my_jet_id = activate.jet_id;
+    } 
+    else 
+    {
+        initial_fuel = atoi(argv[3]);
+        my_jet_id = argv[4];
+    }
     
     // --- REMOVED cout ---
 
@@ -0,0 +1,216 @@
+#include "drone_pool.h"
+#include "metrics.h"
+#include <fcntl.h>
+#include <time.h>
+
+static double now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// --- Internal ---
+
+/**
+ * @brief Forks an idle drone ("drone <read_fd> <write_fd>",
+ * "drone --shm <mem_fd> <jet_bell> <tower_bell>" or
+ * "drone --mux <read_fd> <mux_fd>"). Everything is
+ * close-on-exec so later drones do not inherit this drone's ends; the
+ * child clears the flag on the fds it keeps. Callable from any thread:
+ * the child only touches fds before exec.
+ */
+static bool spawn_idle_drone(bool use_shm, int mux_fd, PooledDrone* out) {
+    int keep[3], nkeep;
+    ShmChannel* shm = NULL;
+    int cmd_fd, feedback_fd;
+
+    if (use_shm) {
+        int mem_fd, jet_bell, tower_bell;
+        shm = shm_channel_create(&mem_fd, &jet_bell, &tower_bell);
+        if (shm == NULL) return false;
+        keep[0] = mem_fd; keep[1] = jet_bell; keep[2] = tower_bell;
+        nkeep = 3;
+        cmd_fd = jet_bell;
+        feedback_fd = tower_bell;
+    } else if (mux_fd >= 0) {
+        int cmd_pipe[2];
+        if (pipe2(cmd_pipe, O_CLOEXEC) == -1) return false;
+        keep[0] = cmd_pipe[0]; keep[1] = mux_fd;
+        nkeep = 2;
+        cmd_fd = cmd_pipe[1];
+        feedback_fd = -1;
+    } else {
+        int cmd_pipe[2], feedback_pipe[2];
+        if (pipe2(cmd_pipe, O_CLOEXEC) == -1) return false;
+        if (pipe2(feedback_pipe, O_CLOEXEC) == -1) {
+            close(cmd_pipe[0]); close(cmd_pipe[1]);
+            return false;
+        }
+        keep[0] = cmd_pipe[0]; keep[1] = feedback_pipe[1];
+        nkeep = 2;
+        cmd_fd = cmd_pipe[1];
+        feedback_fd = feedback_pipe[0];
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        for (int i = 0; i < nkeep; i++) {
+            if (keep[i] != cmd_fd && keep[i] != feedback_fd && keep[i] != mux_fd) close(keep[i]);
+        }
+        close(cmd_fd);
+        if (feedback_fd >= 0) close(feedback_fd);
+        if (shm) shm_channel_unmap(shm);
+        return false;
+    }
+
+    if (pid == 0) {
+        char args[3][12];
+        for (int i = 0; i < nkeep; i++) {
+            fcntl(keep[i], F_SETFD, 0);
+            snprintf(args[i], 12, "%d", keep[i]);
+        }
+        if (use_shm) execlp("./drone", "drone", "--shm", args[0], args[1], args[2], (char*)NULL);
+        else if (mux_fd >= 0) execlp("./drone", "drone", "--mux", args[0], args[1], (char*)NULL);
+        else execlp("./drone", "drone", args[0], args[1], (char*)NULL);
+        perror("DronePool: execlp failed");
+        _exit(1);
+    }
+
+    // Keep only the tower's ends (the memfd stays alive through the mapping)
+    for (int i = 0; i < nkeep; i++) {
+        if (keep[i] != cmd_fd && keep[i] != feedback_fd && keep[i] != mux_fd) close(keep[i]);
+    }
+    out->pid = pid;
+    out->cmd_fd = cmd_fd;
+    out->feedback_fd = feedback_fd;
+    out->shm = shm;
+    out->from_pool = false;
+    return true;
+}
+
+// The activation (or shutdown) message, over whichever transport the drone uses
+static bool send_to_drone(PooledDrone* d, const void* msg, size_t len) {
+    if (d->shm) return shm_ring_send(&d->shm->to_jet, d->cmd_fd, msg, len);
+    // One write of < PIPE_BUF bytes, so the drone never sees half a message
+    return write(d->cmd_fd, msg, len) == (ssize_t)len;
+}
+
+static void retire_drone(PooledDrone* d) {
+    if (d->shm) {
+        // No EOF on a ring: anything but CMD_ACTIVATE makes an idle drone exit
+        AtcCommandMessage shutdown = { CMD_SHUTDOWN };
+        send_to_drone(d, &shutdown, sizeof(shutdown));
+    }
+    close(d->cmd_fd); // Idle pipe drone sees EOF and exits
+    if (d->feedback_fd >= 0) close(d->feedback_fd);
+    waitpid(d->pid, NULL, 0);
+    if (d->shm) shm_channel_unmap(d->shm);
+}
+
+static void* spawner_loop(void* arg) {
+    DronePool* p = (DronePool*)arg;
+    pthread_mutex_lock(&p->lock);
+    while (p->running) {
+        if ((int)p->idle.size() >= p->target_size) {
+            pthread_cond_wait(&p->refill, &p->lock);
+            continue;
+        }
+
+        pthread_mutex_unlock(&p->lock);
+        PooledDrone d;
+        bool ok = spawn_idle_drone(p->use_shm, p->mux_fd, &d);
+        if (!ok) {
+            perror("DronePool: Failed to spawn drone");
+            metrics_inc(MET_SPAWN_FAILURES);
+            sleep(1); // Don't spin on a persistent failure (e.g. fd limit)
+        }
+        pthread_mutex_lock(&p->lock);
+
+        if (ok) {
+            d.from_pool = true;
+            p->idle.push_back(d);
+            p->spawned++;
+        }
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+
+// --- Public Functions ---
+
+bool drone_pool_start(DronePool* p, int size, bool use_shm, int mux_fd) {
+    p->running = true;
+    p->target_size = size;
+    p->use_shm = use_shm;
+    p->mux_fd = mux_fd;
+    p->idle.clear();
+    p->spawned = 0;
+    p->hits = p->misses = 0;
+    p->hit_latency_total_us = p->hit_latency_max_us = 0;
+    p->miss_latency_total_us = p->miss_latency_max_us = 0;
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->refill, NULL);
+    if (pthread_create(&p->thread, NULL, spawner_loop, p) != 0) {
+        perror("DronePool: Failed to create spawner thread");
+        return false;
+    }
+    return true;
+}
+
+void drone_pool_stop(DronePool* p) {
+    pthread_mutex_lock(&p->lock);
+    p->running = false;
+    pthread_cond_signal(&p->refill);
+    pthread_mutex_unlock(&p->lock);
+    pthread_join(p->thread, NULL);
+
+    for (size_t i = 0; i < p->idle.size(); i++) retire_drone(&p->idle[i]);
+    p->idle.clear();
+}
+
+bool drone_pool_checkout(DronePool* p, int fuel, const char* jet_id, PooledDrone* out) {
+    AtcActivateMessage activate;
+    memset(&activate, 0, sizeof(activate));
+    activate.command = CMD_ACTIVATE;
+    activate.initial_fuel = fuel;
+    snprintf(activate.jet_id, sizeof(activate.jet_id), "%s", jet_id);
+
+    double t0 = now_us();
+
+    pthread_mutex_lock(&p->lock);
+    bool hit = !p->idle.empty();
+    if (hit) {
+        *out = p->idle.back();
+        p->idle.pop_back();
+    }
+    pthread_mutex_unlock(&p->lock);
+
+    if (!hit && !spawn_idle_drone(p->use_shm, p->mux_fd, out)) {
+        metrics_inc(MET_SPAWN_FAILURES);
+        return false;
+    }
+
+    if (!send_to_drone(out, &activate, sizeof(activate))) {
+        retire_drone(out);
+        metrics_inc(MET_SPAWN_FAILURES);
+        return false;
+    }
+    out->from_pool = hit;
+
+    double latency = now_us() - t0;
+    pthread_mutex_lock(&p->lock);
+    if (hit) {
+        // Refill only now: a fork in the spawner stalls this thread's page faults
+        pthread_cond_signal(&p->refill);
+        p->hits++;
+        p->hit_latency_total_us += latency;
+        if (latency > p->hit_latency_max_us) p->hit_latency_max_us = latency;
+    } else {
+        p->misses++;
+        p->miss_latency_total_us += latency;
+        if (latency > p->miss_latency_max_us) p->miss_latency_max_us = latency;
+    }
+    pthread_mutex_unlock(&p->lock);
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef DRONE_POOL_H
+#define DRONE_POOL_H
+
+#include "utils.h"
+#include "shm_ring.h"
+#include <vector>
+
+/**
+ * @brief Warm pool of pre-forked ./drone processes. Each idle drone was
+ * started with only its transport fds (two pipes, or an shm channel) and
+ * is blocked waiting for an AtcActivateMessage. A spawner thread keeps the pool topped
+ * up, so creating a jet is a checkout plus one pipe write instead of a
+ * fork + exec on the tower's I/O thread. An empty pool falls back to
+ * spawning on the spot (a miss).
+ */
+
+#define DRONE_POOL_DEFAULT_SIZE 4
+
+struct PooledDrone {
+    pid_t pid;
+    int cmd_fd;         // Tower -> drone (write end, or jet doorbell for shm)
+    int feedback_fd;    // Drone -> tower (read end, tower doorbell for shm, -1 with mux_fd)
+    ShmChannel* shm;    // Rings when the pool uses the shm transport, else NULL
+    bool from_pool;     // Set by checkout: false if it had to be spawned
+};
+
+struct DronePool {
+    pthread_mutex_t lock;
+    pthread_cond_t refill;      // Spawner waits here while the pool is full
+    pthread_t thread;
+    bool running;
+
+    int target_size;
+    bool use_shm;               // Spawn drones on shm rings instead of pipes
+    int mux_fd;                 // Shared feedback socket handed to every drone, -1 if off
+    std::vector<PooledDrone> idle;
+
+    // --- Statistics (under lock) ---
+    long spawned;               // Drones forked by the spawner thread
+    long hits, misses;
+    double hit_latency_total_us, hit_latency_max_us;
+    double miss_latency_total_us, miss_latency_max_us;
+};
+
+// mux_fd >= 0: drones send tagged feedback there instead of on their own pipe
+bool drone_pool_start(DronePool* p, int size, bool use_shm, int mux_fd);
+
+// Stops the spawner and shuts down the idle drones. Stats stay readable.
+void drone_pool_stop(DronePool* p);
+
+// Takes an idle drone (or spawns one) and activates it as jet `jet_id`
+bool drone_pool_checkout(DronePool* p, int fuel, const char* jet_id, PooledDrone* out);
+
+#endif // DRONE_POOL_H
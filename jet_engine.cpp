@@ -0,0 +1,131 @@
+#include "jet_engine.h"
+#include <sys/eventfd.h>
+#include <stdint.h>
+#include <errno.h>
+
+// --- Internal (engine lock held) ---
+
+static void schedule_jet(JetEngine* e, pid_t pid, JetEngineJet* ej) {
+    time_t next = jet_model_next_event(&ej->model);
+    if (next == ej->scheduled) return;
+    ej->generation++;
+    ej->scheduled = next;
+    if (next == 0) return;
+
+    JetEngineDue d = { next, pid, ej->generation };
+    bool new_front = e->due.empty() || next < e->due.top().time;
+    e->due.push(d);
+    if (new_front) pthread_cond_signal(&e->wakeup); // Timer thread may be sleeping too long
+}
+
+static void engine_feedback_sink(void* ctx, pid_t pid, JetFeedbackMessage msg) {
+    JetEngine* e = (JetEngine*)ctx;
+    bool was_empty = e->feedback.empty();
+    JetEngineFeedback fb = { pid, msg };
+    e->feedback.push_back(fb);
+    if (was_empty) {
+        uint64_t one = 1;
+        if (write(e->feedback_fd, &one, sizeof(one)) == -1) perror("JetEngine: eventfd write");
+    }
+}
+
+static void* engine_thread_loop(void* arg) {
+    JetEngine* e = (JetEngine*)arg;
+    pthread_mutex_lock(&e->lock);
+    while (e->running) {
+        if (e->due.empty()) {
+            pthread_cond_wait(&e->wakeup, &e->lock);
+            continue;
+        }
+
+        time_t now = time(NULL);
+        JetEngineDue d = e->due.top();
+        if (d.time > now) {
+            struct timespec until = { d.time, 0 };
+            pthread_cond_timedwait(&e->wakeup, &e->lock, &until);
+            continue;
+        }
+        e->due.pop();
+
+        auto it = e->jets.find(d.pid);
+        if (it == e->jets.end() || it->second.generation != d.generation) continue; // Stale
+        JetEngineJet* ej = &it->second;
+        ej->scheduled = 0;
+        jet_model_advance(&ej->model, now, engine_feedback_sink, e);
+
+        if (ej->model.activity == JET_DONE) e->jets.erase(it); // Landed
+        else schedule_jet(e, d.pid, ej);
+    }
+    pthread_mutex_unlock(&e->lock);
+    return NULL;
+}
+
+
+// --- Public Functions ---
+
+bool jet_engine_start(JetEngine* e) {
+    e->running = true;
+    e->next_pid = 1;
+    e->feedback_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (e->feedback_fd == -1) {
+        perror("JetEngine: Failed to create eventfd");
+        return false;
+    }
+    pthread_mutex_init(&e->lock, NULL);
+    pthread_cond_init(&e->wakeup, NULL);
+    if (pthread_create(&e->thread, NULL, engine_thread_loop, e) != 0) {
+        perror("JetEngine: Failed to create timer thread");
+        close(e->feedback_fd);
+        return false;
+    }
+    return true;
+}
+
+void jet_engine_stop(JetEngine* e) {
+    pthread_mutex_lock(&e->lock);
+    e->running = false;
+    pthread_cond_signal(&e->wakeup);
+    pthread_mutex_unlock(&e->lock);
+    pthread_join(e->thread, NULL);
+
+    pthread_cond_destroy(&e->wakeup);
+    pthread_mutex_destroy(&e->lock);
+    close(e->feedback_fd);
+    e->jets.clear();
+}
+
+pid_t jet_engine_spawn(JetEngine* e, int fuel) {
+    pthread_mutex_lock(&e->lock);
+    pid_t pid = e->next_pid++;
+    JetEngineJet& ej = e->jets[pid];
+    jet_model_init(&ej.model, pid, fuel, time(NULL));
+    ej.generation = 0;
+    ej.scheduled = 0;
+    schedule_jet(e, pid, &ej);
+    pthread_mutex_unlock(&e->lock);
+    return pid;
+}
+
+bool jet_engine_command_hook(void* ctx, SchedulerJet* jet, AtcCommand command) {
+    JetEngine* e = (JetEngine*)ctx;
+    pthread_mutex_lock(&e->lock);
+    auto it = e->jets.find(jet->pid);
+    bool found = it != e->jets.end();
+    if (found) {
+        jet_model_command(&it->second.model, command, time(NULL), engine_feedback_sink, e);
+        schedule_jet(e, jet->pid, &it->second);
+    }
+    pthread_mutex_unlock(&e->lock);
+    return found;
+}
+
+void jet_engine_drain(JetEngine* e, std::vector<JetEngineFeedback>* out) {
+    uint64_t count;
+    pthread_mutex_lock(&e->lock);
+    if (read(e->feedback_fd, &count, sizeof(count)) == -1 && errno != EAGAIN) {
+        perror("JetEngine: eventfd read");
+    }
+    out->clear();
+    out->swap(e->feedback); // Hands back the (empty) buffer for reuse
+    pthread_mutex_unlock(&e->lock);
+}
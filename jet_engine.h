@@ -0,0 +1,68 @@
+#ifndef JET_ENGINE_H
+#define JET_ENGINE_H
+
+#include "jet_model.h"
+#include "scheduler.h"
+#include <vector>
+#include <queue>
+#include <unordered_map>
+
+/**
+ * @brief In-process jet backend. Runs every jet as a JetModel driven by
+ * one shared timer thread instead of a drone process with its own fuel
+ * thread and pipes. Commands come in through the scheduler's command
+ * hook; feedback is queued and announced on an eventfd that the tower
+ * polls next to its other fds.
+ *
+ * Lock order: scheduler.lock may be held when the engine lock is taken
+ * (command hook), never the other way round.
+ */
+
+struct JetEngineFeedback {
+    pid_t pid;
+    JetFeedbackMessage msg;
+};
+
+struct JetEngineDue {
+    time_t time;
+    pid_t pid;
+    unsigned int generation;
+};
+
+struct JetEngineDueLater {
+    bool operator()(const JetEngineDue& a, const JetEngineDue& b) const { return a.time > b.time; }
+};
+
+struct JetEngineJet {
+    JetModel model;
+    unsigned int generation;
+    time_t scheduled;       // Time of the live heap entry, 0 if none
+};
+
+struct JetEngine {
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;      // Timer thread waits here for the next due jet
+    pthread_t thread;
+    bool running;
+
+    std::unordered_map<pid_t, JetEngineJet> jets;
+    std::priority_queue<JetEngineDue, std::vector<JetEngineDue>, JetEngineDueLater> due;
+    pid_t next_pid;
+
+    std::vector<JetEngineFeedback> feedback; // Waiting for the tower
+    int feedback_fd;                         // eventfd, readable while feedback is queued
+};
+
+bool jet_engine_start(JetEngine* e);
+void jet_engine_stop(JetEngine* e);
+
+// Creates a jet and returns its id (used as the scheduler pid)
+pid_t jet_engine_spawn(JetEngine* e, int fuel);
+
+// SchedulerCommandHook; ctx is the JetEngine
+bool jet_engine_command_hook(void* ctx, SchedulerJet* jet, AtcCommand command);
+
+// Moves all queued feedback into `out` and clears the eventfd
+void jet_engine_drain(JetEngine* e, std::vector<JetEngineFeedback>* out);
+
+#endif // JET_ENGINE_H
@@ -0,0 +1,131 @@
+#include "jet_model.h"
+
+static void emit(JetModel* m, JetStatus status, int data, JetFeedbackSink sink, void* ctx) {
+    JetFeedbackMessage msg;
+    msg.status = status;
+    msg.data = data;
+    sink(ctx, m->pid, msg);
+}
+
+void jet_model_init(JetModel* m, pid_t pid, int fuel, time_t now) {
+    memset(m, 0, sizeof(JetModel));
+    m->pid = pid;
+    m->fuel_base = fuel;
+    m->fuel_time = now;
+    m->checked_until = now;
+    m->fuel_burning = fuel > 0;
+    m->activity = JET_IDLE;
+}
+
+int jet_model_fuel(const JetModel* m, time_t now) {
+    if (!m->fuel_burning) return m->fuel_base;
+    long fuel = m->fuel_base - (long)(now - m->fuel_time);
+    return fuel > 0 ? (int)fuel : 0;
+}
+
+// Next fuel-thread tick that can send feedback, 0 if none
+static time_t next_fuel_check(const JetModel* m) {
+    // Every check in drone.cpp needs !is_landing and !is_emergency
+    if (!m->fuel_burning || m->is_landing || m->is_emergency) return 0;
+
+    long done = (long)(m->checked_until - m->fuel_time); // Ticks already handled
+    if (m->fuel_base - done <= 0) return 0;              // Fuel thread has exited
+
+    long best = 0;
+    const int levels[] = { FUEL_REFUEL_LEVEL, FUEL_LOW_LEVEL };
+    for (int i = 0; i < 2; i++) {
+        long k = m->fuel_base - levels[i];
+        if (k > done && (best == 0 || k < best)) best = k;
+    }
+    long k_emergency = m->fuel_base - FUEL_EMERGENCY_LEVEL;
+    if (k_emergency <= done) k_emergency = done + 1;
+    if (best == 0 || k_emergency < best) best = k_emergency;
+
+    return m->fuel_time + best;
+}
+
+static void fire_fuel_check(JetModel* m, time_t t, JetFeedbackSink sink, void* ctx) {
+    int fuel = jet_model_fuel(m, t);
+    m->checked_until = t;
+
+    if (fuel == FUEL_LOW_LEVEL) emit(m, STATUS_FUEL_LOW, fuel, sink, ctx);
+    if (fuel == FUEL_REFUEL_LEVEL) emit(m, STATUS_WAITING_FUEL, fuel, sink, ctx);
+    if (fuel <= FUEL_EMERGENCY_LEVEL) {
+        m->is_emergency = true;
+        emit(m, STATUS_EMERGENCY, fuel, sink, ctx);
+    }
+}
+
+static void start_command(JetModel* m, AtcCommand command, time_t now, JetFeedbackSink sink, void* ctx) {
+    if (command == CMD_START_LANDING) {
+        m->is_landing = true;
+        m->activity = JET_LANDING;
+        m->activity_end = now + JET_LANDING_TIME;
+    } else if (command == CMD_REFUEL) {
+        emit(m, STATUS_REFUELING, 0, sink, ctx);
+        m->activity = JET_REFUELING;
+        m->activity_end = now + JET_REFUEL_TIME;
+    }
+    // drone.cpp ignores anything else
+}
+
+static void finish_activity(JetModel* m, time_t t, JetFeedbackSink sink, void* ctx) {
+    if (m->activity == JET_LANDING) {
+        m->activity = JET_DONE;
+        emit(m, STATUS_LANDED, 0, sink, ctx);
+        return;
+    }
+
+    // Refuel done: the fuel thread ticked first, then fuel is added
+    int fuel = jet_model_fuel(m, t);
+    if (fuel == 0) m->fuel_burning = false;
+    m->fuel_base = fuel + JET_REFUEL_AMOUNT;
+    m->fuel_time = t;
+    m->checked_until = t;
+    m->activity = JET_IDLE;
+    emit(m, STATUS_REFUELED, m->fuel_base, sink, ctx);
+
+    // The drone reads its next queued command straight away
+    if (m->pending_count > 0) {
+        AtcCommand next = m->pending[m->pending_head];
+        m->pending_head = (m->pending_head + 1) % JET_MODEL_MAX_PENDING;
+        m->pending_count--;
+        start_command(m, next, t, sink, ctx);
+    }
+}
+
+time_t jet_model_next_event(const JetModel* m) {
+    if (m->activity == JET_DONE) return 0;
+    time_t next = next_fuel_check(m);
+    if (m->activity != JET_IDLE && (next == 0 || m->activity_end < next)) next = m->activity_end;
+    return next;
+}
+
+void jet_model_advance(JetModel* m, time_t now, JetFeedbackSink sink, void* ctx) {
+    for (;;) {
+        time_t fuel_at = next_fuel_check(m);
+        time_t activity_at = (m->activity == JET_LANDING || m->activity == JET_REFUELING) ? m->activity_end : 0;
+
+        time_t t = fuel_at;
+        if (activity_at != 0 && (t == 0 || activity_at < t)) t = activity_at;
+        if (t == 0 || t > now) return;
+
+        // Same second: the fuel tick goes before the activity completes
+        if (fuel_at == t) fire_fuel_check(m, t, sink, ctx);
+        if (activity_at == t) finish_activity(m, t, sink, ctx);
+    }
+}
+
+void jet_model_command(JetModel* m, AtcCommand command, time_t now, JetFeedbackSink sink, void* ctx) {
+    if (m->activity == JET_DONE) return; // Landed jets have exited
+
+    if (m->activity != JET_IDLE) {
+        // Busy: the command waits in the pipe until the drone reads it
+        if (m->pending_count < JET_MODEL_MAX_PENDING) {
+            m->pending[(m->pending_head + m->pending_count) % JET_MODEL_MAX_PENDING] = command;
+            m->pending_count++;
+        }
+        return;
+    }
+    start_command(m, command, now, sink, ctx);
+}
@@ -0,0 +1,54 @@
+#ifndef JET_MODEL_H
+#define JET_MODEL_H
+
+#include "utils.h"
+
+/**
+ * @brief A jet without a process. Reproduces drone.cpp step for step
+ * (fuel burns 1 unit per second, FUEL_LOW/WAITING_FUEL/EMERGENCY at the
+ * same levels, 12s landing, 10s refuel that queues later commands) but
+ * is driven by whoever owns the clock. Instead of ticking every second
+ * it reports the next time something happens, so a caller can sleep or
+ * jump straight to it.
+ */
+
+enum JetActivity { JET_IDLE, JET_LANDING, JET_REFUELING, JET_DONE };
+
+#define JET_MODEL_MAX_PENDING 8 // Commands queued behind a refuel
+
+// Receives the feedback a drone would have written to its pipe
+typedef void (*JetFeedbackSink)(void* ctx, pid_t pid, JetFeedbackMessage msg);
+
+struct JetModel {
+    pid_t pid;
+
+    // Fuel is fuel_base - (t - fuel_time) while the fuel thread runs
+    int fuel_base;
+    time_t fuel_time;
+    time_t checked_until;   // Fuel thresholds handled up to this time
+    bool fuel_burning;      // drone's fuel thread stops once fuel hits 0
+
+    bool is_emergency;
+    bool is_landing;
+
+    JetActivity activity;
+    time_t activity_end;
+
+    AtcCommand pending[JET_MODEL_MAX_PENDING];
+    int pending_head;
+    int pending_count;
+};
+
+void jet_model_init(JetModel* m, pid_t pid, int fuel, time_t now);
+int jet_model_fuel(const JetModel* m, time_t now);
+
+// Time of the next fuel threshold or activity completion, 0 if none
+time_t jet_model_next_event(const JetModel* m);
+
+// Fires everything due at or before `now`, in time order
+void jet_model_advance(JetModel* m, time_t now, JetFeedbackSink sink, void* ctx);
+
+// A command from the tower, as if read from the command pipe at `now`
+void jet_model_command(JetModel* m, AtcCommand command, time_t now, JetFeedbackSink sink, void* ctx);
+
+#endif // JET_MODEL_H
@@ -0,0 +1,163 @@
+#include "journal.h"
+#include "scheduler.h" // REFUEL_QUEUE
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static int journal_fd = -1;
+static char* journal_map = NULL;    // Header followed by the records
+static uint64_t journal_capacity = 0; // Records the mapping can hold
+
+static JournalHeader* header() { return (JournalHeader*)journal_map; }
+static JournalRecord* records() { return (JournalRecord*)(journal_map + sizeof(JournalHeader)); }
+
+static size_t file_size_for(uint64_t n) { return sizeof(JournalHeader) + n * sizeof(JournalRecord); }
+
+// Doubles the file and the mapping. The only syscalls after open.
+static bool journal_grow() {
+    uint64_t new_capacity = journal_capacity * 2;
+    if (ftruncate(journal_fd, file_size_for(new_capacity)) == -1) return false;
+    void* p = mremap(journal_map, file_size_for(journal_capacity), file_size_for(new_capacity), MREMAP_MAYMOVE);
+    if (p == MAP_FAILED) return false;
+    journal_map = (char*)p;
+    journal_capacity = new_capacity;
+    return true;
+}
+
+bool journal_open(const char* path, bool virtual_time) {
+    journal_fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (journal_fd == -1) return false;
+
+    struct stat st;
+    fstat(journal_fd, &st);
+    JournalHeader existing;
+    bool append = st.st_size >= (off_t)sizeof(JournalHeader) &&
+                  pread(journal_fd, &existing, sizeof(existing), 0) == (ssize_t)sizeof(existing) &&
+                  memcmp(existing.magic, JOURNAL_MAGIC, 8) == 0 &&
+                  existing.record_size == sizeof(JournalRecord);
+    uint64_t count = append ? existing.count : 0;
+
+    journal_capacity = JOURNAL_INITIAL_RECORDS;
+    while (journal_capacity < count + JOURNAL_INITIAL_RECORDS) journal_capacity *= 2;
+    // Not a journal (or a different layout): start over
+    if ((!append && ftruncate(journal_fd, 0) == -1) ||
+        ftruncate(journal_fd, file_size_for(journal_capacity)) == -1) {
+        close(journal_fd);
+        journal_fd = -1;
+        return false;
+    }
+
+    void* p = mmap(NULL, file_size_for(journal_capacity), PROT_READ | PROT_WRITE, MAP_SHARED, journal_fd, 0);
+    if (p == MAP_FAILED) {
+        close(journal_fd);
+        journal_fd = -1;
+        return false;
+    }
+    journal_map = (char*)p;
+    if (!append) {
+        memcpy(header()->magic, JOURNAL_MAGIC, 8);
+        header()->version = JOURNAL_VERSION;
+        header()->record_size = sizeof(JournalRecord);
+        header()->count = 0;
+    }
+
+    // Ties this run's clock to the wall clock for the decoder. A virtual
+    // clock starts at the wall clock, so its t_ns already is wall time.
+    time_t wall = time(NULL);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t t_ns = virtual_time ? (uint64_t)wall * 1000000000ULL : (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    journal_emit(t_ns, JEV_RUN_START, getpid(), 0, 0, virtual_time ? 1 : 0, -1, 0, (int)(uint32_t)wall);
+    return true;
+}
+
+void journal_close() {
+    if (journal_map == NULL) return;
+    uint64_t count = header()->count;
+    munmap(journal_map, file_size_for(journal_capacity));
+    journal_map = NULL;
+    if (ftruncate(journal_fd, file_size_for(count)) == -1) perror("Journal: truncate");
+    close(journal_fd);
+    journal_fd = -1;
+}
+
+bool journal_enabled() {
+    return journal_map != NULL;
+}
+
+void journal_emit(uint64_t t_ns, JournalEventType type, pid_t pid, int from_q, int to_q,
+                  int fuel, int runway, pid_t other_pid, int aux) {
+    if (journal_map == NULL) return;
+    uint64_t n = header()->count;
+    if (n == journal_capacity && !journal_grow()) return;
+
+    JournalRecord* r = &records()[n];
+    r->t_ns = t_ns;
+    r->from_q = (int8_t)from_q;
+    r->to_q = (int8_t)to_q;
+    r->runway = (int16_t)runway;
+    r->reserved = 0;
+    r->pid = pid;
+    r->other_pid = other_pid;
+    r->fuel = fuel;
+    r->aux = aux;
+    r->type = (uint16_t)type; // Last: a nonzero type marks the slot as written
+    header()->count = n + 1;
+}
+
+const char* journal_event_name(int type) {
+    static const char* names[JEV_TYPE_COUNT] = {
+        "none", "run_start", "arrival", "move", "preempt", "aging", "rr_expired",
+        "dispatch_emergency", "dispatch_landing", "dispatch_refuel", "landed",
+        "emergency", "emergency_preempt", "refuel_request", "refuel_wait", "refueled", "fuel"
+    };
+    return (type >= 0 && type < JEV_TYPE_COUNT) ? names[type] : "unknown";
+}
+
+int journal_format_text(const JournalRecord* r, char* buf, size_t size) {
+    switch (r->type) {
+    case JEV_RUN_START:
+        return snprintf(buf, size, "--- Journal: run started by tower %d%s ---\n", r->pid, r->fuel ? " (simulation)" : "");
+    case JEV_ARRIVAL:
+        return snprintf(buf, size, "[Scheduler]: Jet %d added to Q%d. (Fuel: %d)\n", r->pid, r->to_q, r->fuel);
+    case JEV_MOVE:
+        return snprintf(buf, size, "[Scheduler]: Jet %d moved from Q%d to Q%d.\n", r->pid, r->from_q, r->to_q);
+    case JEV_PREEMPT:
+        return snprintf(buf, size, "[Scheduler]: PREEMPTING runway jet %d!\n", r->pid);
+    case JEV_AGING:
+        return snprintf(buf, size, "[Scheduler]: AGING Jet %d from Q%d to Q%d.\n", r->pid, r->from_q, r->to_q);
+    case JEV_RR_EXPIRED:
+        return snprintf(buf, size, "[Scheduler]: RR QUANTUM expired for Jet %d. Demoting to Q%d.\n", r->pid, r->to_q);
+    case JEV_DISPATCH_EMERGENCY:
+        return snprintf(buf, size, "[Scheduler]: Runway assigned to EMERGENCY Jet %d (from Q%d).\n", r->pid, r->from_q);
+    case JEV_DISPATCH_LANDING:
+        return snprintf(buf, size, "[Scheduler]: Runway assigned to Jet %d for LANDING (from Q%d).\n", r->pid, r->from_q);
+    case JEV_DISPATCH_REFUEL:
+        if (r->from_q == REFUEL_QUEUE) {
+            return snprintf(buf, size, "[Scheduler]: Refuel bay %d assigned to Jet %d.\n", r->runway + 1, r->pid);
+        }
+        return snprintf(buf, size, "[Scheduler]: Runway assigned to Jet %d for REFUELING (from Q%d).\n", r->pid, r->from_q);
+    case JEV_LANDED:
+        return snprintf(buf, size, "[Scheduler]: Jet %d has landed and is being cleared.\n", r->pid);
+    case JEV_EMERGENCY:
+        return snprintf(buf, size, "[Scheduler]: Jet %d moved to Q1 (Emergency).\n", r->pid);
+    case JEV_EMERGENCY_PREEMPT:
+        if (r->aux >= 0) {
+            return snprintf(buf, size, "[Scheduler]: New emergency Jet %d (fuel %d) preempting running Jet %d (fuel %d).\n",
+                r->pid, r->fuel, r->other_pid, r->aux);
+        }
+        return snprintf(buf, size, "[Scheduler]: Emergency Jet %d preempting non-emergency Jet %d.\n", r->pid, r->other_pid);
+    case JEV_REFUEL_REQUEST:
+        if (r->to_q == REFUEL_QUEUE) return snprintf(buf, size, "[Scheduler]: Jet %d queued for a refuel bay.\n", r->pid);
+        return snprintf(buf, size, "[Scheduler]: Jet %d moved to Q3 for refueling.\n", r->pid);
+    case JEV_REFUEL_WAIT:
+        if (r->to_q == REFUEL_QUEUE) return snprintf(buf, size, "[Scheduler]: Jet %d is waiting for a refuel bay.\n", r->pid);
+        return snprintf(buf, size, "[Scheduler]: Jet %d is waiting in Q3 to refuel.\n", r->pid);
+    case JEV_REFUELED:
+        return snprintf(buf, size, "[Scheduler]: Jet %d refueled (New Fuel: %d).\n", r->pid, r->fuel);
+    case JEV_FUEL:
+        return snprintf(buf, size, "[Scheduler]: Jet %d fuel reading %d.\n", r->pid, r->fuel);
+    default:
+        return snprintf(buf, size, "[Journal]: Unknown event %u for jet %d.\n", r->type, r->pid);
+    }
+}
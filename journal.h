@@ -0,0 +1,77 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "utils.h"
+#include <stdint.h>
+
+/**
+ * @brief Binary event journal. Every scheduling decision is appended as
+ * one fixed-size JournalRecord to an mmap'd, preallocated file, so
+ * recording an event is a few stores (no syscall, no formatting). The
+ * file grows by doubling when full. Runs append to the same file; each
+ * starts with a JEV_RUN_START record.
+ *
+ * Not thread-safe: emitters hold scheduler.lock, like the _unsafe
+ * scheduler functions. Decode with journal_decode.
+ */
+
+#define JOURNAL_MAGIC "SKYJRNL1"
+#define JOURNAL_VERSION 1
+#define JOURNAL_INITIAL_RECORDS 65536
+
+enum JournalEventType {
+    JEV_NONE = 0,               // Unwritten slot
+    JEV_RUN_START,              // pid = tower, aux = wall-clock seconds at t_ns, fuel = 1 if virtual time
+    JEV_ARRIVAL,                // Added to to_q with fuel
+    JEV_MOVE,                   // from_q -> to_q
+    JEV_PREEMPT,                // Runway `runway` taken from pid
+    JEV_AGING,                  // Q3 -> Q2 after AGING_THRESHOLD
+    JEV_RR_EXPIRED,             // Q2 quantum used up, demoted to Q3
+    JEV_DISPATCH_EMERGENCY,     // Runway assigned from from_q
+    JEV_DISPATCH_LANDING,
+    JEV_DISPATCH_REFUEL,        // from_q = REFUEL_QUEUE: `runway` is the refuel bay
+    JEV_LANDED,
+    JEV_EMERGENCY,              // Moved to Q1 with fuel
+    JEV_EMERGENCY_PREEMPT,      // pid (fuel) preempts other_pid (aux = its fuel, -1 if not in Q1)
+    JEV_REFUEL_REQUEST,         // Moved to Q3 (or the refuel bay queue) to refuel
+    JEV_REFUEL_WAIT,            // Already there, waiting to refuel
+    JEV_REFUELED,               // New fuel
+    JEV_FUEL,                   // Fuel reading from the jet
+    JEV_TYPE_COUNT
+};
+
+struct JournalRecord {
+    uint64_t t_ns;      // CLOCK_MONOTONIC (virtual seconds * 1e9 in --sim)
+    uint16_t type;      // JournalEventType
+    int8_t from_q;      // 0 if not applicable
+    int8_t to_q;
+    int16_t runway;     // -1 if not applicable
+    int16_t reserved;
+    int32_t pid;
+    int32_t other_pid;
+    int32_t fuel;
+    int32_t aux;        // Type-specific, see JournalEventType
+};
+
+struct JournalHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t count;     // Records written (updated in place, no syscall)
+    char reserved[40];
+};
+
+// Opens (or creates) the journal and appends a JEV_RUN_START record
+bool journal_open(const char* path, bool virtual_time);
+void journal_close();
+bool journal_enabled();
+
+void journal_emit(uint64_t t_ns, JournalEventType type, pid_t pid, int from_q, int to_q,
+                  int fuel, int runway, pid_t other_pid, int aux);
+
+const char* journal_event_name(int type);
+
+// The record as the text log would have printed it, without timestamp
+int journal_format_text(const JournalRecord* r, char* buf, size_t size);
+
+#endif // JOURNAL_H
@@ -0,0 +1,89 @@
+#include "journal.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief Offline decoder for the binary event journal. Prints the
+ * records in the text log's format (or CSV), optionally only one jet
+ * and/or a time window measured in seconds from the start of each run.
+ *
+ * Compile: g++ -O2 journal_decode.cpp journal.cpp -o journal_decode
+ */
+
+static void print_usage(const char* prog) {
+    printf("Usage: %s <journal> [--csv] [--pid <n>] [--from <sec>] [--to <sec>]\n", prog);
+    printf("  --csv        One row per event instead of log lines\n");
+    printf("  --pid <n>    Only events for jet <n> (as subject or as the preempted jet)\n");
+    printf("  --from/--to  Time window in seconds since the start of the run\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* path = NULL;
+    bool csv = false;
+    pid_t only_pid = 0;
+    double from_s = -1, to_s = -1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0) csv = true;
+        else if (strcmp(argv[i], "--pid") == 0 && i + 1 < argc) only_pid = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) from_s = atof(argv[++i]);
+        else if (strcmp(argv[i], "--to") == 0 && i + 1 < argc) to_s = atof(argv[++i]);
+        else if (path == NULL && argv[i][0] != '-') path = argv[i];
+        else { print_usage(argv[0]); return 1; }
+    }
+    if (path == NULL) { print_usage(argv[0]); return 1; }
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) { perror("journal_decode: open"); return 1; }
+    struct stat st;
+    fstat(fd, &st);
+    if (st.st_size < (off_t)sizeof(JournalHeader)) { printf("%s: not a journal\n", path); return 1; }
+    const char* map = (const char*)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) { perror("journal_decode: mmap"); return 1; }
+
+    const JournalHeader* h = (const JournalHeader*)map;
+    if (memcmp(h->magic, JOURNAL_MAGIC, 8) != 0 || h->record_size != sizeof(JournalRecord)) {
+        printf("%s: not a journal (or version %u)\n", path, h->version);
+        return 1;
+    }
+    uint64_t count = h->count;
+    uint64_t fits = (st.st_size - sizeof(JournalHeader)) / sizeof(JournalRecord);
+    if (count > fits) count = fits; // Tower died mid-grow
+    const JournalRecord* recs = (const JournalRecord*)(map + sizeof(JournalHeader));
+
+    if (csv) printf("run,t_ns,rel_s,wall_s,event,pid,from_q,to_q,fuel,runway,other_pid,aux\n");
+
+    int run = 0;
+    uint64_t run_t_ns = 0;
+    time_t run_wall = 0;
+    char line[256];
+    for (uint64_t i = 0; i < count; i++) {
+        const JournalRecord* r = &recs[i];
+        if (r->type == JEV_NONE) continue; // Never finished writing
+        if (r->type == JEV_RUN_START) {
+            run++;
+            run_t_ns = r->t_ns;
+            run_wall = (time_t)(uint32_t)r->aux;
+        }
+
+        double rel = (r->t_ns >= run_t_ns) ? (r->t_ns - run_t_ns) / 1e9 : 0;
+        if (from_s >= 0 && rel < from_s) continue;
+        if (to_s >= 0 && rel > to_s) continue;
+        if (only_pid != 0 && r->type != JEV_RUN_START && r->pid != only_pid && r->other_pid != only_pid) continue;
+
+        time_t wall = run_wall + (time_t)rel;
+        if (csv) {
+            printf("%d,%llu,%.6f,%ld,%s,%d,%d,%d,%d,%d,%d,%d\n", run, (unsigned long long)r->t_ns, rel, (long)wall,
+                journal_event_name(r->type), r->pid, r->from_q, r->to_q, r->fuel, r->runway, r->other_pid, r->aux);
+        } else {
+            struct tm ltm;
+            localtime_r(&wall, &ltm);
+            journal_format_text(r, line, sizeof(line));
+            printf("[%02d:%02d:%02d] %s", ltm.tm_hour, ltm.tm_min, ltm.tm_sec, line);
+        }
+    }
+
+    munmap((void*)map, st.st_size);
+    close(fd);
+    return 0;
+}
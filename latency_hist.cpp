@@ -0,0 +1,80 @@
+#include "latency_hist.h"
+#include <string.h>
+
+void latency_hist_init(LatencyHistogram* h) {
+    memset(h, 0, sizeof(LatencyHistogram));
+}
+
+// Values under 128 index themselves; otherwise the top 8 bits (leading 1 + 7) pick
+// the bucket within the power of two
+static int bucket_for(uint64_t v) {
+    if (v < LATENCY_HIST_SUB_COUNT) return (int)v;
+    int exp = 63 - __builtin_clzll(v);
+    if (exp >= LATENCY_HIST_MAX_EXP) return LATENCY_HIST_BUCKETS - 1;
+    int shift = exp - LATENCY_HIST_SUB_BITS;
+    return (shift + 1) * LATENCY_HIST_SUB_COUNT + (int)(v >> shift) - LATENCY_HIST_SUB_COUNT;
+}
+
+void latency_hist_bucket_range(int i, uint64_t* low_us, uint64_t* high_us) {
+    if (i < LATENCY_HIST_SUB_COUNT) {
+        *low_us = *high_us = (uint64_t)i;
+        return;
+    }
+    int shift = i / LATENCY_HIST_SUB_COUNT - 1;
+    uint64_t top = (uint64_t)(LATENCY_HIST_SUB_COUNT + i % LATENCY_HIST_SUB_COUNT);
+    *low_us = top << shift;
+    *high_us = *low_us + (1ULL << shift) - 1;
+}
+
+void latency_hist_record(LatencyHistogram* h, uint64_t value_us) {
+    h->buckets[bucket_for(value_us)]++;
+    if (h->count == 0 || value_us < h->min_us) h->min_us = value_us;
+    h->count++;
+    h->sum_us += value_us;
+    if (value_us > h->max_us) h->max_us = value_us;
+}
+
+void latency_hist_merge(LatencyHistogram* into, const LatencyHistogram* from) {
+    if (from->count == 0) return;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) into->buckets[i] += from->buckets[i];
+    if (into->count == 0 || from->min_us < into->min_us) into->min_us = from->min_us;
+    into->count += from->count;
+    into->sum_us += from->sum_us;
+    if (from->max_us > into->max_us) into->max_us = from->max_us;
+}
+
+uint64_t latency_hist_percentile(const LatencyHistogram* h, double percentile) {
+    if (h->count == 0) return 0;
+    // Rank of the value we want, 1-based: p99 of 1000 values is the 990th
+    uint64_t rank = (uint64_t)(percentile / 100.0 * h->count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > h->count) rank = h->count;
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            uint64_t low, high;
+            latency_hist_bucket_range(i, &low, &high);
+            if (high > h->max_us) high = h->max_us;
+            return (high < h->min_us) ? h->min_us : high;
+        }
+    }
+    return h->max_us;
+}
+
+double latency_hist_mean(const LatencyHistogram* h) {
+    return h->count ? (double)h->sum_us / h->count : 0.0;
+}
+
+void latency_hist_write_csv(const LatencyHistogram* h, FILE* out, const char* label, const char* origin) {
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        if (h->buckets[i] == 0) continue;
+        seen += h->buckets[i];
+        uint64_t low, high;
+        latency_hist_bucket_range(i, &low, &high);
+        fprintf(out, "%s,%s,%llu,%llu,%llu,%.6f\n", label, origin,
+                (unsigned long long)low, (unsigned long long)high,
+                (unsigned long long)h->buckets[i], (double)seen / h->count);
+    }
+}
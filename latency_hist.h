@@ -0,0 +1,45 @@
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Log-bucketed latency histogram (HDR style) in constant memory.
+ * Values are µs. Below 128 µs every value has its own bucket; above that
+ * each power of two is split into 128 linear buckets, so a bucket is never
+ * wider than ~0.8% of its value (35 KB per histogram). Values from
+ * 2^40 µs (~12 days) on land in the last bucket. Recording is O(1) and never allocates.
+ *
+ * Not thread-safe: the tower records under stats_lock.
+ */
+
+#define LATENCY_HIST_SUB_BITS 7
+#define LATENCY_HIST_SUB_COUNT (1 << LATENCY_HIST_SUB_BITS)
+#define LATENCY_HIST_MAX_EXP 40
+#define LATENCY_HIST_BUCKETS ((LATENCY_HIST_MAX_EXP - LATENCY_HIST_SUB_BITS + 1) * LATENCY_HIST_SUB_COUNT)
+
+struct LatencyHistogram {
+    uint64_t count;
+    uint64_t sum_us;
+    uint64_t min_us;
+    uint64_t max_us;
+    uint64_t buckets[LATENCY_HIST_BUCKETS];
+};
+
+void latency_hist_init(LatencyHistogram* h); // A zeroed histogram is also empty and valid
+void latency_hist_record(LatencyHistogram* h, uint64_t value_us);
+void latency_hist_merge(LatencyHistogram* into, const LatencyHistogram* from);
+
+// Smallest recorded value v such that `percentile` % of values are <= v,
+// to bucket precision (the bucket's upper bound, capped at max). 0 if empty.
+uint64_t latency_hist_percentile(const LatencyHistogram* h, double percentile);
+double latency_hist_mean(const LatencyHistogram* h);
+
+// Bounds of bucket i in µs, both inclusive
+void latency_hist_bucket_range(int i, uint64_t* low_us, uint64_t* high_us);
+
+// One CSV row per non-empty bucket: label,origin,low_us,high_us,count,cumulative (0..1)
+void latency_hist_write_csv(const LatencyHistogram* h, FILE* out, const char* label, const char* origin);
+
+#endif // LATENCY_HIST_H
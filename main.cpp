@@ -1,12 +1,25 @@
 #include "utils.h"
 #include "scheduler.h" 
+#include "tower.h"
+#include "sim.h"
+#include "replay.h"
+#include "session.h"
+#include "jet_engine.h"
+#include "drone_pool.h"
+#include "async_log.h"
+#include "journal.h"
+#include "metrics.h"
+#include "traffic.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h> 
-#include <vector>     // --- NEW: For stats
 #include <time.h>     // --- NEW: For stats
 #include <fcntl.h>    // --- NEW: For console loop
 #include <errno.h>    // --- NEW: For console loop
+#include <sys/epoll.h> // --- NEW: Tower event loop
+#include <sys/socket.h> // --- NEW: Shared feedback socket
+
+#define TOWER_MAX_EVENTS 256 // Ready fds handled per epoll_wait
 
 // --- Student Information ---
 const char* STUDENT_NAME = "Student Name";
@@ -17,87 +30,67 @@ const char* ROLLNO_LAST_TWO = "35";
 int generator_pipe_write_end;
 int console_pipe[2]; 
 bool keep_running = true;
-int active_jet_count = 0;
 static int jet_counter = 0; 
-SchedulerState scheduler;
-FILE* log_file = NULL;
-
-// --- NEW: Global state for statistics ---
-time_t simulation_start_time;
-struct JetStats {
-    pid_t pid;
-    double turnaround_time;
-    double waiting_time;
-    double response_time;
-};
-std::vector<JetStats> completed_jet_stats;
-pthread_mutex_t stats_lock; // To protect the stats vector
 
-
-/**
- * @brief MODIFIED: Reverted - prints to console AND log file
- */
-void log_event(const char* format, ...) {
-    va_list args;
-    va_start(args, format);
-    vprintf(format, args); // Print to console
-    va_end(args);
-    
-    if (log_file) {
-        time_t now = time(0);
-        tm *ltm = localtime(&now);
-        char time_buf[20];
-        snprintf(time_buf, 20, "[%02d:%02d:%02d] ", ltm->tm_hour, ltm->tm_min, ltm->tm_sec);
-        fprintf(log_file, "%s", time_buf);
-        va_start(args, format);
-        vfprintf(log_file, format, args); // Print to log file
-        va_end(args);
-        fflush(log_file);
-    }
+// --- NEW: How jets are run ---
+enum JetBackend {
+    BACKEND_PROCESS,    // fork + exec ./drone per jet (default)
+    BACKEND_INPROC      // In-process state machines on one timer thread
+};
+static JetBackend jet_backend = BACKEND_PROCESS;
+static JetEngine jet_engine;
+static DronePool drone_pool;
+static int drone_pool_size = DRONE_POOL_DEFAULT_SIZE;
+static bool use_shm_transport = false; // --transport shm: rings instead of pipes
+static bool use_mux_feedback = false;  // --feedback mux: one socket for all drones
+static int mux_socket[2] = { -1, -1 }; // [0] tower reads, [1] shared by the drones
+static SectorSet sectors;              // --sectors n: sharded scheduler (tower_sectors)
+static SchedulerState* metrics_schedulers[MAX_SECTORS]; // Scraped by the metrics server
+
+// --- NEW: Scheduler k of the tower: the only one, or sector k when sharded ---
+static int scheduler_shard_count() { return tower_sectors ? tower_sectors->count : 1; }
+static SchedulerState* scheduler_shard(int k) { return tower_sectors ? tower_sectors->sectors[k].s : &scheduler; }
+
+// --- NEW: Locks and returns the scheduler holding `pid` ---
+static SchedulerState* lock_scheduler_for(pid_t pid) {
+    if (tower_sectors) return sectors_lock_jet(tower_sectors, pid);
+    pthread_mutex_lock(&scheduler.lock);
+    return &scheduler;
 }
 
 
 /**
- * @brief MODIFIED: Creates 8 jets
- * MODIFIED: Removed all cout statements
+ * @brief MODIFIED: Streams arrivals from the traffic generator (traffic.h),
+ * each written when its time comes. The default config is the old 8 jets,
+ * one per second. Arrivals are never buffered: a slow tower just blocks
+ * the pipe write.
  */
-void run_jet_generator() {
-    // --- REMOVED cout ---
-    
-    // --- MODIFIED: Create a "traffic jam" to test all queues ---
-    
-    // Total 8 jets, 1 per second
-    int fuel_levels[] = {
-        60, // Standard jet
-        20, // EMERGENCY jet (will hit 10 fuel while waiting)
-        60, // Standard jet
-        40, // REFUEL jet (will hit 25 fuel while waiting)
-        60, // Standard jet (will be demoted by RR)
-        60, // Standard jet (will be demoted by RR)
-        18, // EMERGENCY jet
-        50  // REFUEL jet
-    };
-    
-    for (int i = 0; i < 8; i++) {
-        sleep(1); // Spawn a jet every second
-        int initial_fuel = fuel_levels[i];
-
-        if (initial_fuel <= 20) { 
-            // --- REMOVED cout ---
-        } 
-        else if (initial_fuel <= 40) { 
-            // --- REMOVED cout ---
-        }
-
-        JetMessage new_jet_request = { initial_fuel };
-        // --- REMOVED cout ---
-             
+void run_jet_generator(const TrafficConfig* config) {
+    TrafficGenerator traffic;
+    if (!traffic_init(&traffic, config)) {
+        perror("Generator: Failed to open the trace");
+        close(generator_pipe_write_end);
+        return;
+    }
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    TrafficArrival arrival;
+    while (traffic_next(&traffic, &arrival)) {
+        // Absolute deadlines, so the rate does not drift with write and wakeup latency
+        double at = start.tv_sec + start.tv_nsec / 1e9 + arrival.time_s;
+        struct timespec due;
+        due.tv_sec = (time_t)at;
+        due.tv_nsec = (long)((at - (double)due.tv_sec) * 1e9);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR) {}
+
+        JetMessage new_jet_request = { arrival.fuel, arrival.jet_id };
         if (write(generator_pipe_write_end, &new_jet_request, sizeof(JetMessage)) == -1) {
             perror("Generator: Pipe write error");
+            break;
         }
     }
-
-    // --- REMOVED cout ---
+    traffic_close(&traffic);
     close(generator_pipe_write_end);
 }
 
@@ -106,10 +99,10 @@ void run_jet_generator() {
  */
 void* display_loop(void* arg) {
     log_event("[ATC Display Thread]: Display started.\n");
-    SchedulerState* s = (SchedulerState*)arg;
+    (void)arg;
     while (keep_running) {
         // --- MODIFIED: `scheduler_print_queues` now prints to console by default ---
-        scheduler_print_queues(s, log_file);
+        for (int k = 0; k < scheduler_shard_count(); k++) scheduler_print_queues(scheduler_shard(k), log_file);
         sleep(2);
     }
     log_event("[ATC Display Thread]: Display shutting down.\n");
@@ -120,10 +113,22 @@ void* display_loop(void* arg) {
 void* scheduler_loop(void* arg) {
     log_event("[Scheduler Thread]: Clock started.\n");
     SchedulerState* s = (SchedulerState*)arg;
+    // --- MODIFIED: Deadlines on a tick_ms timerfd, dispatch as soon as an event asks for it ---
+    int tick_fd = scheduler_open_tick_timer(s->tick_ms);
+    if (tick_fd == -1 || !scheduler_enable_dispatch_events(s)) {
+        log_event("[Scheduler Thread]: ERROR: Could not create tick timer or dispatch eventfd.\n");
+        keep_running = false;
+        if (tick_fd != -1) close(tick_fd);
+        return NULL;
+    }
     while (keep_running) {
-        sleep(1); // 1-second tick
-        scheduler_tick(s, log_file);
+        int ticks;
+        bool dispatch;
+        scheduler_wait_events(s, tick_fd, s->tick_ms, &ticks, &dispatch);
+        for (int t = 0; t < ticks; t++) scheduler_tick(s, log_file);
+        if (dispatch) scheduler_dispatch(s, log_file);
     }
+    close(tick_fd);
     log_event("[Scheduler Thread]: Clock shutting down.\n");
     return NULL;
 }
@@ -136,9 +141,9 @@ void* scheduler_loop(void* arg) {
 void* console_loop(void* arg) {
     // --- MODIFIED: Print initial messages to console directly ---
     printf("[Console Thread]: Ready for commands.\n");
-    printf("Commands: status, new_jet <fuel>, force_emergency <pid>, boost_priority <pid>, change_quantum <val>, pause_sim, resume_sim, exit\n");
+    printf("Commands: status, new_jet <fuel>, force_emergency <pid>, boost_priority <pid>, change_quantum <s | ms>, pause_sim, resume_sim, exit\n");
     log_event("[Console Thread]: Ready for commands.\n");
-    SchedulerState* s = (SchedulerState*)arg;
+    (void)arg;
     
     cout << "\nATC-CMD> "; // Print initial prompt
     fflush(stdout);
@@ -177,7 +182,7 @@ void* console_loop(void* arg) {
                 if (arg1 > 0) {
                     printf("[Console]: Requesting new jet with %d fuel.\n", arg1);
                     log_event("[Console]: Requesting new jet with %d fuel.\n", arg1);
-                    JetMessage new_jet_request = { arg1 };
+                    JetMessage new_jet_request = { arg1, 0 };
                     if (write(console_pipe[1], &new_jet_request, sizeof(JetMessage)) == -1) {
                         printf("[Console]: ERROR: Failed to send new_jet request to main thread.\n");
                         log_event("[Console]: ERROR: Failed to send new_jet request to main thread.\n");
@@ -190,23 +195,28 @@ void* console_loop(void* arg) {
             else if (sscanf(buffer, "force_emergency %d", &arg1) == 1) {
                 printf("[Console]: Executing 'force_emergency %d'\n", arg1);
                 log_event("[Console]: Executing 'force_emergency %d'\n", arg1);
-                pthread_mutex_lock(&s->lock);
+                SchedulerState* s = lock_scheduler_for((pid_t)arg1);
+                session_input(SREC_FORCE_EMERGENCY, (pid_t)arg1, 0, 1);
                 scheduler_handle_emergency_unsafe(s, (pid_t)arg1, 1, log_file);
                 pthread_mutex_unlock(&s->lock);
             
             } else if (sscanf(buffer, "boost_priority %d", &arg1) == 1) {
                 printf("[Console]: Executing 'boost_priority %d'\n", arg1);
                 log_event("[Console]: Executing 'boost_priority %d'\n", arg1);
-                pthread_mutex_lock(&s->lock);
-                int q, idx;
-                SchedulerJet* jet = scheduler_find_jet_unsafe(s, (pid_t)arg1, &q, &idx);
+                SchedulerState* s = lock_scheduler_for((pid_t)arg1);
+                int q;
+                SchedulerJet* jet = scheduler_find_jet_unsafe(s, (pid_t)arg1, &q);
                 if (jet) {
                     if (q == 3) {
                         printf("[Console]: Jet %d boosted from Q3 to Q2.\n", arg1);
-                        scheduler_move_jet_unsafe(s, 3, idx, 2, log_file);
+                        session_input(SREC_BOOST, jet->pid, 0, 2);
+                        scheduler_move_jet_unsafe(s, jet, 2, log_file);
                     } else if (q == 2) {
                         printf("[Console]: Jet %d boosted from Q2 to Q1.\n", arg1);
-                        scheduler_move_jet_unsafe(s, 2, idx, 1, log_file);
+                        session_input(SREC_BOOST, jet->pid, 0, 1);
+                        scheduler_move_jet_unsafe(s, jet, 1, log_file);
+                    } else if (q == REFUEL_QUEUE) {
+                        printf("[Console]: Jet %d is waiting to refuel.\n", arg1);
                     } else {
                         printf("[Console]: Jet %d already in Q1.\n", arg1);
                     }
@@ -216,12 +226,20 @@ void* console_loop(void* arg) {
                 pthread_mutex_unlock(&s->lock);
             
             } else if (sscanf(buffer, "change_quantum %d", &arg1) == 1) {
+                // --- MODIFIED: Seconds as before, or ms with a suffix ("change_quantum 250ms") ---
+                char unit[3] = "";
+                sscanf(buffer, "change_quantum %*d%2s", unit);
+                int quantum_ms = (strcmp(unit, "ms") == 0) ? arg1 : arg1 * 1000;
                 if (arg1 > 0) {
-                    printf("[Console]: Executing 'change_quantum %d'\n", arg1);
-                    log_event("[Console]: Executing 'change_quantum %d'\n", arg1);
-                    pthread_mutex_lock(&s->lock);
-                    s->q2_rr_quantum = arg1;
-                    pthread_mutex_unlock(&s->lock);
+                    printf("[Console]: Executing 'change_quantum %d ms'\n", quantum_ms);
+                    log_event("[Console]: Executing 'change_quantum %d ms'\n", quantum_ms);
+                    for (int k = 0; k < scheduler_shard_count(); k++) {
+                        SchedulerState* s = scheduler_shard(k);
+                        pthread_mutex_lock(&s->lock);
+                        session_input(SREC_SET_QUANTUM, 0, 0, quantum_ms);
+                        scheduler_set_quantum_ms(s, quantum_ms);
+                        pthread_mutex_unlock(&s->lock);
+                    }
                 } else {
                     printf("[Console]: Quantum must be > 0.\n");
                     log_event("[Console]: Quantum must be > 0.\n");
@@ -230,22 +248,32 @@ void* console_loop(void* arg) {
             } else if (strcmp(buffer, "pause_sim") == 0) {
                 printf("[Console]: Executing 'pause_sim'\n");
                 log_event("[Console]: Executing 'pause_sim'\n");
-                pthread_mutex_lock(&s->lock);
-                s->is_paused = true;
-                pthread_mutex_unlock(&s->lock);
+                for (int k = 0; k < scheduler_shard_count(); k++) {
+                    SchedulerState* s = scheduler_shard(k);
+                    pthread_mutex_lock(&s->lock);
+                    session_input(SREC_SET_PAUSED, 0, 0, 1);
+                    s->is_paused = true;
+                    scheduler_publish_radar_unsafe(s);
+                    pthread_mutex_unlock(&s->lock);
+                }
 
             } else if (strcmp(buffer, "resume_sim") == 0) {
                 printf("[Console]: Executing 'resume_sim'\n");
                 log_event("[Console]: Executing 'resume_sim'\n");
-                pthread_mutex_lock(&s->lock);
-                s->is_paused = false;
-                pthread_mutex_unlock(&s->lock);
+                for (int k = 0; k < scheduler_shard_count(); k++) {
+                    SchedulerState* s = scheduler_shard(k);
+                    pthread_mutex_lock(&s->lock);
+                    session_input(SREC_SET_PAUSED, 0, 0, 0);
+                    s->is_paused = false;
+                    scheduler_publish_radar_unsafe(s);
+                    pthread_mutex_unlock(&s->lock);
+                }
             
             } else if (strcmp(buffer, "status") == 0) {
                 printf("[Console]: Forcing display refresh.\n");
                 log_event("[Console]: Forcing display refresh.\n");
                 // --- MODIFIED: `scheduler_print_queues` prints to console ---
-                scheduler_print_queues(s, log_file); 
+                for (int k = 0; k < scheduler_shard_count(); k++) scheduler_print_queues(scheduler_shard(k), log_file);
             
             } else if (strcmp(buffer, "exit") == 0) {
                 printf("[Console]: Exit command received. Shutting down.\n");
@@ -270,79 +298,175 @@ void* console_loop(void* arg) {
 }
 
 
-/**
- * @brief NEW: Prints the final statistics summary
- * --- MODIFIED: Now also prints to console
- */
-void print_final_summary()
-{
-    time_t simulation_end_time = time(NULL);
-    double total_simulation_time = difftime(simulation_end_time, simulation_start_time);
-    if (total_simulation_time < 1) total_simulation_time = 1; // Avoid division by zero
-
-    char buffer[2048]; // Buffer to hold the summary string
-    char* buf_ptr = buffer;
-    int len = 0;
-
-    len += snprintf(buf_ptr + len, sizeof(buffer) - len, "\n\n========================================================\n");
-    len += snprintf(buf_ptr + len, sizeof(buffer) - len, "           FINAL SIMULATION SUMMARY\n");
-    len += snprintf(buf_ptr + len, sizeof(buffer) - len, "========================================================\n\n");
-    
-    len += snprintf(buf_ptr + len, sizeof(buffer) - len, "Total Simulation Time: %.0f seconds\n", total_simulation_time);
-    
-    double avg_turnaround = 0, avg_wait = 0, avg_response = 0;
+static void print_usage(const char* prog) {
+    printf("Usage: %s [--seed <n>] [--runways <n>] [--refuel-bays <n>] [--sectors <n>] [--backend process|inproc] [--pool <n>] [--transport pipe|shm] [--feedback per-jet|mux]\n"
+           "       [--log-sync] [--log-flush-ms <n>] [--log-full block|drop] [--journal <file>]\n"
+           "       [--tick-ms <n>] [--quantum-ms <n>] [--latency-csv <file>] [--metrics-socket <path>]\n"
+           "       [--record <file> | --replay <file>] [--sim] [--jets <n>]\n"
+           "       [--arrivals fixed|poisson|mmpp] [--rate <r>] [--burst <r:calm_s:burst_s>]\n"
+           "       [--fuel mix|uniform:<min>:<max>|normal:<mean>:<sd>] [--surge <start_s:duration_s:x>]\n"
+           "       [--trace <file>] [--trace-speed <x>] [--trace-loop]\n", prog);
+    printf("  --seed <n>   Seed the simulation (skips the roll number prompt)\n");
+    printf("  --runways <n>  Parallel runways (default %d, max %d)\n", DEFAULT_RUNWAYS, MAX_RUNWAYS);
+    printf("  --refuel-bays <n>  Refuel bays (default %d, max %d, 0 = refuels take a runway)\n", DEFAULT_REFUEL_BAYS, MAX_REFUEL_BAYS);
+    printf("  --tick-ms <n>     Tick period in ms: resolution of the RR quantum and aging (default %d)\n", TICK_PERIOD_MS);
+    printf("  --quantum-ms <n>  Q2 round-robin quantum in ms (default %d)\n", RR_QUANTUM_MS);
+    printf("  --sectors <n>  Shard the scheduler into n sectors with their own lock and tick thread\n"
+           "               (max %d; needs --backend inproc or --feedback mux)\n", MAX_SECTORS);
+    printf("  --backend    process: one ./drone per jet (default)\n");
+    printf("               inproc:  jets run inside the tower on one timer thread\n");
+    printf("  --pool <n>   Idle drones kept pre-forked for the process backend (default %d, 0 = off)\n", DRONE_POOL_DEFAULT_SIZE);
+    printf("  --transport  pipe: two pipes per drone (default)\n");
+    printf("               shm:  shared-memory rings per drone, eventfd doorbells\n");
+    printf("  --feedback   per-jet: one feedback pipe per drone (default)\n");
+    printf("               mux:     all drones share one SOCK_SEQPACKET socket (pipe transport only)\n");
+    printf("  --log-sync   Write log lines on the calling thread (default: background writer)\n");
+    printf("  --log-flush-ms <n>  Batch log writes for up to n ms (default 0: write when queued)\n");
+    printf("  --log-full   block: wait when the log ring is full (default), drop: drop the line\n");
+    printf("  --journal <file>  Also append every scheduling event to a binary journal (see journal_decode)\n");
+    printf("  --latency-csv <file>  Write the latency histograms as CSV at the end of the run\n");
+    printf("  --metrics-socket <path>  Serve live metrics (Prometheus text) on a Unix socket\n");
+    printf("  --record <file>   Record every scheduler input and decision for --replay\n");
+    printf("  --replay <file>   Re-run a recording at CPU speed and check every decision matches\n");
+    printf("  --sim        Discrete-event mode: virtual clock, no drone processes\n");
+    printf("  --jets <n>   Number of jets the generator sends (default %d)\n", TRAFFIC_FUEL_MIX_COUNT);
+    printf("  --arrivals   fixed: one jet every 1/rate s (default), poisson, or mmpp (Poisson with bursts)\n");
+    printf("  --rate <r>   Mean arrivals per second (mmpp: outside bursts; default 1)\n");
+    printf("  --burst <r:calm_s:burst_s>  mmpp: rate during bursts and mean time in each state (default 10:60:10)\n");
+    printf("  --fuel       mix: the 8-jet traffic jam (default), uniform:<min>:<max>, normal:<mean>:<sd>\n");
+    printf("  --surge <start_s:duration_s:x>  Multiply the rate by x for a window (up to %d)\n", TRAFFIC_MAX_SURGES);
+    printf("  --trace <file>    Replay arrivals (time_s,fuel,jet_id) from a CSV or trace_convert file;\n"
+           "                    --jets then defaults to the whole trace\n");
+    printf("  --trace-speed <x> Replay the trace x times faster (default 1)\n");
+    printf("  --trace-loop      Start the trace over when it ends\n");
+}
+
+// --- Main function for the ATC Tower ---
+int main(int argc, char* argv[]) {
     
-    pthread_mutex_lock(&stats_lock);
-    int jet_count = completed_jet_stats.size();
+    // --- NEW: Command line options ---
+    bool sim_mode = false;
+    bool have_seed = false;
+    int roll_no_seed = 0;
+    TrafficConfig traffic; // --- NEW: Arrivals, for the generator process and --sim
+    traffic_default_config(&traffic);
+    bool jets_given = false;
+    bool async_logging = true;
+    AsyncLogConfig log_config;
+    async_log_default_config(&log_config);
+    const char* journal_path = NULL;
+    const char* record_path = NULL;
+    const char* replay_path = NULL;
+    const char* metrics_path = NULL;
+    int runway_count = DEFAULT_RUNWAYS;
+    int refuel_bays = DEFAULT_REFUEL_BAYS;
+    int sector_count = 1;
+    int tick_ms = TICK_PERIOD_MS;
+    int quantum_ms = RR_QUANTUM_MS;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sim") == 0) {
+            sim_mode = true;
+        } else if (strcmp(argv[i], "--jets") == 0 && i + 1 < argc) {
+            traffic.jet_count = atol(argv[++i]);
+            jets_given = true;
+        } else if (strcmp(argv[i], "--trace-loop") == 0) {
+            traffic.trace_loop = true;
+        } else if (traffic_is_option(argv[i]) && i + 1 < argc) {
+            if (!traffic_parse_option(&traffic, argv[i], argv[i + 1])) {
+                printf("Invalid %s value: %s\n", argv[i], argv[i + 1]);
+                return 1;
+            }
+            i++;
+        } else if (strcmp(argv[i], "--backend") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "process") == 0) jet_backend = BACKEND_PROCESS;
+            else if (strcmp(argv[i], "inproc") == 0) jet_backend = BACKEND_INPROC;
+            else { print_usage(argv[0]); return 1; }
+        } else if (strcmp(argv[i], "--transport") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "pipe") == 0) use_shm_transport = false;
+            else if (strcmp(argv[i], "shm") == 0) use_shm_transport = true;
+            else { print_usage(argv[0]); return 1; }
+        } else if (strcmp(argv[i], "--feedback") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "per-jet") == 0) use_mux_feedback = false;
+            else if (strcmp(argv[i], "mux") == 0) use_mux_feedback = true;
+            else { print_usage(argv[0]); return 1; }
+        } else if (strcmp(argv[i], "--log-sync") == 0) {
+            async_logging = false;
+        } else if (strcmp(argv[i], "--log-flush-ms") == 0 && i + 1 < argc) {
+            log_config.flush_interval_ms = atoi(argv[++i]);
+            if (log_config.flush_interval_ms < 0) log_config.flush_interval_ms = 0;
+        } else if (strcmp(argv[i], "--log-full") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "block") == 0) log_config.full_policy = LOG_FULL_BLOCK;
+            else if (strcmp(argv[i], "drop") == 0) log_config.full_policy = LOG_FULL_DROP;
+            else { print_usage(argv[0]); return 1; }
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            journal_path = argv[++i];
+        } else if (strcmp(argv[i], "--latency-csv") == 0 && i + 1 < argc) {
+            tower_latency_csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--metrics-socket") == 0 && i + 1 < argc) {
+            metrics_path = argv[++i];
+        } else if (strcmp(argv[i], "--runways") == 0 && i + 1 < argc) {
+            runway_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tick-ms") == 0 && i + 1 < argc) {
+            tick_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--quantum-ms") == 0 && i + 1 < argc) {
+            quantum_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sectors") == 0 && i + 1 < argc) {
+            sector_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--refuel-bays") == 0 && i + 1 < argc) {
+            refuel_bays = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--pool") == 0 && i + 1 < argc) {
+            drone_pool_size = atoi(argv[++i]);
+            if (drone_pool_size < 0) drone_pool_size = 0;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            roll_no_seed = atoi(argv[++i]);
+            have_seed = true;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
     
-    if (jet_count > 0) {
-        len += snprintf(buf_ptr + len, sizeof(buffer) - len, "\n--- Individual Jet Stats ---\n");
-        for (const auto& stats : completed_jet_stats) {
-            len += snprintf(buf_ptr + len, sizeof(buffer) - len, "  - Jet %d: Turnaround=%.0fs, Wait=%.0fs, Response=%.0fs\n", 
-                (int)stats.pid, stats.turnaround_time, stats.waiting_time, stats.response_time);
-            avg_turnaround += stats.turnaround_time;
-            avg_wait += stats.waiting_time;
-            avg_response += stats.response_time;
+    if (use_mux_feedback && use_shm_transport) {
+        printf("--feedback mux needs --transport pipe (shm jets have their own feedback ring)\n");
+        return 1;
+    }
+    if (record_path && replay_path) {
+        printf("--record and --replay cannot be combined\n");
+        return 1;
+    }
+    // --- NEW: Sharded jets move between sectors, so feedback must be routed by pid ---
+    if (sector_count > 1) {
+        if (jet_backend != BACKEND_INPROC && !use_mux_feedback) {
+            printf("--sectors needs --backend inproc or --feedback mux\n");
+            return 1;
+        }
+        if (sim_mode || record_path || replay_path || journal_path) {
+            printf("--sectors cannot be combined with --sim, --record, --replay or --journal (one clock, one lock)\n");
+            return 1;
         }
-        
-        avg_turnaround /= jet_count;
-        avg_wait /= jet_count;
-        avg_response /= jet_count;
-
-        len += snprintf(buf_ptr + len, sizeof(buffer) - len, "\n--- Average Stats ---\n");
-        len += snprintf(buf_ptr + len, sizeof(buffer) - len, "Average Turnaround Time: %.2f s\n", avg_turnaround);
-        len += snprintf(buf_ptr + len, sizeof(buffer) - len, "Average Waiting Time:    %.2f s\n", avg_wait);
-        len += snprintf(buf_ptr + len, sizeof(buffer) - len, "Average Response Time:   %.2f s\n", avg_response);
-
-    } else {
-        len += snprintf(buf_ptr + len, sizeof(buffer) - len, "\nNo jets completed simulation.\n");
     }
-    pthread_mutex_unlock(&stats_lock);
-
-    pthread_mutex_lock(&scheduler.lock);
-    int context_switches = scheduler.total_context_switches;
-    double runway_busy_time = scheduler.total_runway_busy_time;
-    pthread_mutex_unlock(&scheduler.lock);
-
-    double cpu_utilization = (runway_busy_time / total_simulation_time) * 100.0;
-
-    len += snprintf(buf_ptr + len, sizeof(buffer) - len, "\n--- System Stats ---\n");
-    len += snprintf(buf_ptr + len, sizeof(buffer) - len, "Total Context Switches:  %d\n", context_switches);
-    len += snprintf(buf_ptr + len, sizeof(buffer) - len, "Runway Utilization (CPU): %.2f %% (%.0f / %.0f s)\n", 
-        cpu_utilization, runway_busy_time, total_simulation_time);
-    len += snprintf(buf_ptr + len, sizeof(buffer) - len, "\n========================================================\n");
-
-    // --- NEW: Print the entire buffer to console and log file ---
-    printf("%s", buffer);
-    if (log_file) {
-        fprintf(log_file, "%s", buffer);
-        fflush(log_file);
+    // --- NEW: A trace is checked here, so a bad path fails before anything starts ---
+    if (traffic.arrivals == ARRIVALS_TRACE) {
+        if (!jets_given) traffic.jet_count = -1; // The whole trace
+        TrafficGenerator probe;
+        if (!traffic_init(&probe, &traffic)) {
+            printf("Cannot open trace %s: %s\n", traffic.trace_path, strerror(errno));
+            return 1;
+        }
+        traffic_close(&probe);
+        if (sim_mode && traffic.trace_loop && !jets_given) {
+            printf("--sim with --trace-loop needs --jets (the run would never end)\n");
+            return 1;
+        }
     }
-}
-
-
-// --- Main function for the ATC Tower ---
-int main() {
     
     // ... (Step 1: Init, Get Seed, Open Log is unchanged) ...
     cout << "======================================" << endl;
@@ -350,26 +474,67 @@ int main() {
     cout << "    Name: " << STUDENT_NAME << endl;
     cout << "    Roll No: " << STUDENT_ROLLNO << endl;
     cout << "======================================" << endl;
-    int roll_no_seed;
-    cout << "Enter your 4-digit roll number (e.g., 2035) to seed simulation: ";
-    cin >> roll_no_seed;
-    cin.ignore(1000, '\n'); 
+    if (!have_seed) {
+        cout << "Enter your 4-digit roll number (e.g., 2035) to seed simulation: ";
+        cin >> roll_no_seed;
+        cin.ignore(1000, '\n'); 
+    }
     srand(roll_no_seed);
+    traffic.seed = (uint64_t)roll_no_seed; // --- NEW: Same seed, same traffic
     
     char log_filename[100];
-    snprintf(log_filename, 100, "%s_skywatch_log.txt", STUDENT_ROLLNO);
+    // --- NEW: A replay keeps the recorded session's log intact ---
+    snprintf(log_filename, 100, replay_path ? "%s_replay_log.txt" : "%s_skywatch_log.txt", STUDENT_ROLLNO);
     log_file = fopen(log_filename, "w"); // Use "w" to overwrite old logs
     if (log_file == NULL) {
         perror("Failed to open log file"); return 1;
     }
-    
+    // --- NEW: Log lines go through a ring to a writer thread ---
+    if (async_logging && !async_log_start(log_file, &log_config)) {
+        printf("Failed to start the log writer, logging synchronously.\n");
+    }
+    // --- NEW: Binary event journal next to the text log ---
+    if (journal_path && !journal_open(journal_path, sim_mode)) {
+        perror("Failed to open journal"); return 1;
+    }
     // --- MODIFIED: Reverted - use log_event to print to console ---
     log_event("\n--- Simulation Started by %s (%s) ---\n", STUDENT_NAME, STUDENT_ROLLNO);
     log_event("Seed set to %d.\n", roll_no_seed);
+    log_event("Scheduling policy: %s.\n", scheduler_policy_name()); // --- NEW: Fixed at build time
+    if (!replay_path) {
+        char traffic_desc[256];
+        traffic_describe(&traffic, traffic_desc, sizeof(traffic_desc));
+        log_event("Traffic: %s.\n", traffic_desc);
+    }
     
     scheduler_init(&scheduler);
+    scheduler_set_runway_count(&scheduler, runway_count); // --- NEW: N runways
+    scheduler_set_refuel_bays(&scheduler, refuel_bays);   // --- NEW: Separate refuel bays
+    scheduler_set_tick_ms(&scheduler, tick_ms);           // --- NEW: Sub-second ticks
+    scheduler_set_quantum_ms(&scheduler, quantum_ms);     // Copied to every sector
     pthread_mutex_init(&stats_lock, NULL); // --- NEW: Init stats lock
-    simulation_start_time = time(NULL);    // --- NEW: Record start time
+    if (sector_count > 1) {
+        // --- NEW: `scheduler` becomes sector 1; the runways and bays are split between sectors ---
+        if (!sectors_init(&sectors, &scheduler, sector_count, runway_count, refuel_bays)) {
+            perror("Failed to create sectors"); return 1;
+        }
+        tower_sectors = &sectors;
+        log_event("[ATC Tower]: Scheduler sharded into %d sectors.\n", sectors.count);
+    }
+    // --- NEW: Session recording for --replay ---
+    if (record_path && !session_record_open(record_path, sim_mode, scheduler.runway_count, scheduler.bay_count,
+                                                 scheduler.q2_quantum_ms)) {
+        perror("Failed to open session recording"); return 1;
+    }
+    simulation_start_ns = scheduler_now_ns(); // --- MODIFIED: Start time on the monotonic clock
+    // --- NEW: Live metrics; a scrape reads counters and radar snapshots, never a scheduler lock ---
+    if (metrics_path) {
+        for (int k = 0; k < scheduler_shard_count(); k++) metrics_schedulers[k] = scheduler_shard(k);
+        if (!metrics_server_start(metrics_path, metrics_schedulers, scheduler_shard_count())) {
+            perror("Failed to open metrics socket"); return 1;
+        }
+        log_event("[ATC Tower]: Serving metrics on %s.\n", metrics_path);
+    }
     
     // ... (Seed explanation comment) ...
     // Using the roll number as a seed (srand) ensures that
@@ -377,6 +542,39 @@ int main() {
     // This makes my simulation's output (jet arrival times, fuel)
     // different from other students' but repeatable for debugging.
 
+    // --- NEW: Replay runs like the discrete-event mode, from a recording ---
+    if (replay_path) {
+        int result = run_replay(replay_path);
+        metrics_server_stop();
+        async_log_stop();
+        journal_close();
+        print_final_summary();
+        scheduler_destroy(&scheduler);
+        pthread_mutex_destroy(&stats_lock);
+        if (log_file) fclose(log_file);
+        if (result != 0) {
+            cout << "[ATC Tower]: Replay FAILED (see the log). Exiting." << endl;
+            return 1;
+        }
+        cout << "[ATC Tower]: Replay finished. Log file created. Exiting." << endl;
+        return 0;
+    }
+
+    // --- NEW: Discrete-event mode runs here and skips the processes and threads ---
+    if (sim_mode) {
+        SimConfig sim_config = { traffic };
+        run_simulation(&sim_config);
+        metrics_server_stop();
+        async_log_stop();
+        journal_close();
+        session_record_close();
+        print_final_summary();
+        scheduler_destroy(&scheduler);
+        pthread_mutex_destroy(&stats_lock);
+        if (log_file) fclose(log_file);
+        cout << "[ATC Tower]: Simulation finished. Log file created. Exiting." << endl;
+        return 0;
+    }
     
     // ... (Step 2: Create Pipes is unchanged) ...
     int generator_pipe[2]; 
@@ -402,7 +600,7 @@ int main() {
         close(generator_pipe[0]);
         close(console_pipe[0]); 
         close(console_pipe[1]);
-        run_jet_generator();
+        run_jet_generator(&traffic);
         exit(0); 
     } 
     log_event("[ATC Tower %d]: Jet Generator process started (PID: %d).\n", getpid(), generator_pid);
@@ -413,7 +611,12 @@ int main() {
     if (pthread_create(&display_thread_id, NULL, display_loop, &scheduler) != 0) {
         log_event("FATAL: Failed to create ATC Display thread.\n"); return 1;
     }
-    if (pthread_create(&scheduler_thread_id, NULL, scheduler_loop, &scheduler) != 0) {
+    if (tower_sectors) {
+        // --- NEW: One pinned tick thread per sector instead of scheduler_loop ---
+        if (!sectors_start(&sectors, &keep_running, log_file)) {
+            log_event("FATAL: Failed to create sector threads.\n"); return 1;
+        }
+    } else if (pthread_create(&scheduler_thread_id, NULL, scheduler_loop, &scheduler) != 0) {
         log_event("FATAL: Failed to create Scheduler Clock thread.\n"); return 1;
     }
     if (pthread_create(&console_thread_id, NULL, console_loop, &scheduler) != 0) {
@@ -421,187 +624,200 @@ int main() {
     }
     close(console_pipe[1]);
 
+    // --- NEW: In-process jets: commands go to the engine instead of pipes ---
+    if (jet_backend == BACKEND_INPROC) {
+        if (!jet_engine_start(&jet_engine)) {
+            log_event("FATAL: Failed to start in-process jet engine.\n"); return 1;
+        }
+        if (tower_sectors) {
+            sectors_set_command_hook(&sectors, jet_engine_command_hook, &jet_engine);
+        } else {
+            pthread_mutex_lock(&scheduler.lock);
+            scheduler.command_hook = jet_engine_command_hook;
+            scheduler.command_hook_ctx = &jet_engine;
+            pthread_mutex_unlock(&scheduler.lock);
+        }
+        tower_reap_jets = false;
+        log_event("[ATC Tower]: Using in-process jets.\n");
+    } else {
+        // --- NEW: Shared feedback socket; records stay whole with many writers ---
+        if (use_mux_feedback && 
+            socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, mux_socket) == -1) {
+            log_event("FATAL: Failed to create feedback socket.\n"); return 1;
+        }
+
+        // --- NEW: Drones are checked out of a warm pool refilled in the background ---
+        if (!drone_pool_start(&drone_pool, drone_pool_size, use_shm_transport, mux_socket[1])) {
+            log_event("FATAL: Failed to start drone pool.\n"); return 1;
+        }
+        tower_drone_pool = &drone_pool;
+        log_event("[ATC Tower]: Drone pool started (%d idle drones, %s transport%s).\n", 
+                  drone_pool_size, use_shm_transport ? "shm" : "pipe", 
+                  use_mux_feedback ? ", shared feedback socket" : "");
+    }
+
 
     
-    // --- Step 5: Main I/O Loop (Unchanged) ---
+    // --- Step 5: Main I/O Loop ---
     log_event("[ATC Tower]: Main I/O loop started.\n");
     
+    // --- NEW: Tower event loop on epoll. Jet feedback fds are registered once
+    // by scheduler_add_jet (data.ptr = jet record) and removed on landing.
+    static int generator_tag, console_tag, engine_tag, mux_tag; // data.ptr markers for the non-jet fds
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &generator_tag;
+    epoll_ctl(scheduler.epoll_fd, EPOLL_CTL_ADD, generator_pipe[0], &ev);
+    ev.data.ptr = &console_tag;
+    epoll_ctl(scheduler.epoll_fd, EPOLL_CTL_ADD, console_pipe[0], &ev);
+    if (jet_backend == BACKEND_INPROC) {
+        ev.data.ptr = &engine_tag;
+        epoll_ctl(scheduler.epoll_fd, EPOLL_CTL_ADD, jet_engine.feedback_fd, &ev);
+    }
+    if (use_mux_feedback) {
+        ev.data.ptr = &mux_tag;
+        epoll_ctl(scheduler.epoll_fd, EPOLL_CTL_ADD, mux_socket[0], &ev);
+    }
+    std::vector<JetEngineFeedback> engine_feedback;
+    std::vector<JetTaggedFeedback> mux_feedback;
+
+    struct epoll_event events[TOWER_MAX_EVENTS];
+    
     while (keep_running) 
     {
-        fd_set read_fds;
-        FD_ZERO(&read_fds);
-        int max_fd = 0;
-        
-        if (!generator_is_done) {
-            FD_SET(generator_pipe[0], &read_fds);
-            max_fd = generator_pipe[0];
-        }
-        
-        FD_SET(console_pipe[0], &read_fds);
-        if (console_pipe[0] > max_fd) max_fd = console_pipe[0];
-        
-        pthread_mutex_lock(&scheduler.lock);
-        for (int q = 0; q < 3; q++) {
-            SchedulerJet* queue = (q == 0) ? scheduler.queue1 : (q == 1) ? scheduler.queue2 : scheduler.queue3;
-            for (int i = 0; i < MAX_JETS; i++) {
-                if (queue[i].pid != 0) {
-                    int fd = queue[i].atc_read_fd;
-                    FD_SET(fd, &read_fds);
-                    if (fd > max_fd) max_fd = fd;
-                }
-            }
-        }
-        pthread_mutex_unlock(&scheduler.lock);
-
-        
-        struct timeval timeout = { 0, 100000 }; 
-        int activity = select(max_fd + 1, &read_fds, NULL, NULL, &timeout);
+        int activity = epoll_wait(scheduler.epoll_fd, events, TOWER_MAX_EVENTS, 100);
         
         if (activity < 0) {
             if (errno == EINTR) continue;
-            log_event("ERROR: select() error.\n");
+            log_event("ERROR: epoll_wait() error.\n");
             continue;
         }
         
         // Helper lambda (unchanged)
-        auto create_new_jet = [&](int initial_fuel) {
-            log_event("[ATC Tower]: Creating new jet with %d fuel.\n", initial_fuel);
-            int atc_to_jet_pipe[2], jet_to_atc_pipe[2];
-            // --- FIX 1: Typo jet_to_ata_pipe -> jet_to_atc_pipe ---
-            if (pipe(atc_to_jet_pipe) == -1 || pipe(jet_to_atc_pipe) == -1) {
-                log_event("ERROR: Failed to create jet pipes.\n");
+        auto create_new_jet = [&](int initial_fuel, int trace_jet_id) {
+            if (trace_jet_id) log_event("[ATC Tower]: Creating new jet with %d fuel (trace jet %d).\n", initial_fuel, trace_jet_id);
+            else log_event("[ATC Tower]: Creating new jet with %d fuel.\n", initial_fuel);
+            if (jet_backend == BACKEND_INPROC) {
+                pid_t jet_pid = jet_engine_spawn(&jet_engine, initial_fuel);
+                log_event("[ATC Tower]: Started in-process jet (PID %d)\n", jet_pid);
+                if (tower_sectors) sectors_add_jet(&sectors, jet_pid, -1, -1, initial_fuel, log_file);
+                else scheduler_add_jet(&scheduler, jet_pid, -1, -1, initial_fuel, log_file);
+                active_jet_count++;
                 return;
             }
-            
-            pid_t jet_pid = fork();
-            if (jet_pid < 0) {
-                log_event("ERROR: Failed to fork jet process.\n");
+            // --- MODIFIED: Fork + exec moved to the drone pool; this is a checkout ---
+            char jet_id_str[20];
+            snprintf(jet_id_str, 20, "%s-%02d", ROLLNO_LAST_TWO, trace_jet_id ? trace_jet_id : jet_counter);
+            PooledDrone drone;
+            if (!drone_pool_checkout(&drone_pool, initial_fuel, jet_id_str, &drone)) {
+                log_event("ERROR: Failed to start jet process.\n");
                 return;
             }
             
-            if (jet_pid == 0) {
-                if (log_file) fclose(log_file);
-                close(generator_pipe[0]);
-                close(console_pipe[0]);
-                close(atc_to_jet_pipe[1]);
-                close(jet_to_atc_pipe[0]);
-                
-                char read_fd_str[10], write_fd_str[10], fuel_str[10], jet_id_str[20];
-                snprintf(read_fd_str, 10, "%d", atc_to_jet_pipe[0]);
-                snprintf(write_fd_str, 10, "%d", jet_to_atc_pipe[1]);
-                snprintf(fuel_str, 10, "%d", initial_fuel);
-                snprintf(jet_id_str, 20, "%s-%02d", ROLLNO_LAST_TWO, jet_counter);
-                
-                execlp("./drone", "drone", read_fd_str, write_fd_str, fuel_str, jet_id_str, (char*)NULL);
-                perror("ATC: execlp failed");
-                exit(1);
+            if (drone.from_pool) log_event("[ATC Tower]: Activated pooled jet (PID %d)\n", drone.pid);
+            else log_event("[ATC Tower]: Forked new jet (PID %d)\n", drone.pid);
+            if (tower_sectors) {
+                sectors_add_jet(&sectors, drone.pid, drone.feedback_fd, drone.cmd_fd, initial_fuel, log_file);
+            } else {
+                scheduler_add_shm_jet(&scheduler, drone.pid, drone.feedback_fd, 
+                                      drone.cmd_fd, drone.shm, initial_fuel, log_file);
             }
-            
-            close(atc_to_jet_pipe[0]);
-            close(jet_to_atc_pipe[1]);
-            log_event("[ATC Tower]: Forked new jet (PID %d)\n", jet_pid);
-            scheduler_add_jet(&scheduler, jet_pid, jet_to_atc_pipe[0], 
-                              atc_to_jet_pipe[1], initial_fuel, log_file);
             active_jet_count++;
         };
         
-        // Check generator (unchanged)
-        if (!generator_is_done && FD_ISSET(generator_pipe[0], &read_fds)) {
-            JetMessage received_jet_request;
-            ssize_t bytes_read = read(generator_pipe[0], &received_jet_request, sizeof(JetMessage));
-            if (bytes_read > 0) {
-                jet_counter++; 
-                create_new_jet(received_jet_request.initial_fuel);
-            } else if (bytes_read == 0) {
-                log_event("[ATC Tower]: Jet Generator has shut down.\n");
-                close(generator_pipe[0]);
-                generator_is_done = true;
+        // Generator and console first, then all jet feedback under one lock
+        int jet_events = 0;
+        for (int e = 0; e < activity; e++) {
+            if (events[e].data.ptr == &generator_tag) {
+                JetMessage received_jet_request;
+                ssize_t bytes_read = read(generator_pipe[0], &received_jet_request, sizeof(JetMessage));
+                if (bytes_read > 0) {
+                    jet_counter++; 
+                    create_new_jet(received_jet_request.initial_fuel, received_jet_request.jet_id);
+                } else if (bytes_read == 0) {
+                    log_event("[ATC Tower]: Jet Generator has shut down.\n");
+                    epoll_ctl(scheduler.epoll_fd, EPOLL_CTL_DEL, generator_pipe[0], NULL);
+                    close(generator_pipe[0]);
+                    generator_is_done = true;
+                }
+            } else if (events[e].data.ptr == &console_tag) {
+                JetMessage received_jet_request;
+                ssize_t bytes_read = read(console_pipe[0], &received_jet_request, sizeof(JetMessage));
+                if (bytes_read > 0) {
+                    jet_counter++; 
+                    // --- FIX 2: Typo initial_ael -> initial_fuel ---
+                    create_new_jet(received_jet_request.initial_fuel, received_jet_request.jet_id);
+                }
+            } else if (events[e].data.ptr == &engine_tag) {
+                jet_engine_drain(&jet_engine, &engine_feedback);
+            } else if (events[e].data.ptr == &mux_tag) {
+                tower_read_mux_feedback(mux_socket[0], &mux_feedback);
+            } else {
+                events[jet_events++] = events[e]; // Compact jet events to the front
             }
         }
         
-        // Check console pipe (unchanged)
-        if (FD_ISSET(console_pipe[0], &read_fds)) {
-            JetMessage received_jet_request;
-            ssize_t bytes_read = read(console_pipe[0], &received_jet_request, sizeof(JetMessage));
-            if (bytes_read > 0) {
-                jet_counter++; 
-                // --- FIX 2: Typo initial_ael -> initial_fuel ---
-                create_new_jet(received_jet_request.initial_fuel);
+        // --- NEW: Sharded: each message under the lock of the sector holding its jet ---
+        if (tower_sectors) {
+            for (size_t f = 0; f < engine_feedback.size(); f++) {
+                pid_t pid = engine_feedback[f].pid;
+                SchedulerState* s = sectors_lock_jet(&sectors, pid);
+                SchedulerJet* jet = scheduler_find_jet_unsafe(s, pid, NULL);
+                if (jet) tower_handle_feedback_unsafe(s, jet, engine_feedback[f].msg);
+                pthread_mutex_unlock(&s->lock);
+                if (engine_feedback[f].msg.status == STATUS_LANDED) sectors_forget_jet(&sectors, pid);
+            }
+            engine_feedback.clear();
+            for (size_t f = 0; f < mux_feedback.size(); f++) {
+                SchedulerState* s = sectors_lock_jet(&sectors, mux_feedback[f].pid);
+                tower_handle_tagged_feedback_unsafe(s, mux_feedback[f]);
+                pthread_mutex_unlock(&s->lock);
+                if (mux_feedback[f].msg.status == STATUS_LANDED) sectors_forget_jet(&sectors, mux_feedback[f].pid);
             }
+            mux_feedback.clear();
         }
-        
+
         // Check jet feedback
         pthread_mutex_lock(&scheduler.lock);
-        for (int q = 0; q < 3; q++) {
-            SchedulerJet* queue = (q == 0) ? scheduler.queue1 : (q == 1) ? scheduler.queue2 : scheduler.queue3;
-            for (int i = 0; i < MAX_JETS; i++) {
-                SchedulerJet* jet = &queue[i];
-                if (jet->pid != 0 && FD_ISSET(jet->atc_read_fd, &read_fds)) {
+        for (size_t f = 0; f < engine_feedback.size(); f++) {
+            SchedulerJet* jet = scheduler_find_jet_unsafe(&scheduler, engine_feedback[f].pid, NULL);
+            if (jet) tower_handle_feedback_unsafe(&scheduler, jet, engine_feedback[f].msg);
+        }
+        engine_feedback.clear();
+        for (size_t f = 0; f < mux_feedback.size(); f++) {
+            tower_handle_tagged_feedback_unsafe(&scheduler, mux_feedback[f]);
+        }
+        mux_feedback.clear();
+        for (int e = 0; e < jet_events; e++) {
+            SchedulerJet* jet = (SchedulerJet*)events[e].data.ptr;
+            if (jet->pid == 0) continue; // Record already released
+
+            // --- NEW: shm jets: the fd is a doorbell, drain the whole ring ---
+            if (jet->shm) {
+                ShmRing* ring = &jet->shm->to_tower;
+                shm_ring_finish_wait(ring, jet->atc_read_fd);
+                bool landed = false;
+                do {
                     JetFeedbackMessage feedback;
-                    ssize_t bytes = read(jet->atc_read_fd, &feedback, sizeof(JetFeedbackMessage));
-                    
-                    if (bytes > 0) {
-                        if (feedback.status == STATUS_LANDED) {
-                            pid_t landed_pid = jet->pid;
-
-                            // --- NEW: Capture stats BEFORE clearing jet data ---
-                            SchedulerJet* landed_jet = scheduler_find_jet_unsafe(&scheduler, landed_pid, NULL, NULL);
-                            if (landed_jet) {
-                                time_t completion_time = time(NULL);
-                                JetStats stats;
-                                stats.pid = landed_pid;
-                                stats.turnaround_time = difftime(completion_time, landed_jet->arrival_time);
-                                stats.waiting_time = landed_jet->total_wait_time;
-                                
-                                if (landed_jet->first_run_time != 0) {
-                                    stats.response_time = difftime(landed_jet->first_run_time, landed_jet->arrival_time);
-                                } else {
-                                    // Should not happen if it landed, but as a fallback:
-                                    stats.response_time = stats.turnaround_time;
-                                }
-                                
-                                pthread_mutex_lock(&stats_lock);
-                                completed_jet_stats.push_back(stats);
-                                pthread_mutex_unlock(&stats_lock);
-                            }
-                            // --- End of stats capture ---
-
-                            scheduler_jet_landed_unsafe(&scheduler, landed_pid, log_file); 
-                            waitpid(landed_pid, NULL, 0); 
-                            active_jet_count--;
-                            log_event("[ATC Tower]: Cleaned up jet %d. %d jets remaining.\n", landed_pid, active_jet_count);
-                        } 
-                        else if (feedback.status == STATUS_EMERGENCY) {
-                            log_event("[ATC Tower]: EMERGENCY from Jet %d! (Fuel: %d)\n", jet->pid, feedback.data);
-                            scheduler_handle_emergency_unsafe(&scheduler, jet->pid, feedback.data, log_file);
-                        } 
-                        else if (feedback.status == STATUS_FUEL_LOW) {
-                            log_event("[ATC Tower]: Low fuel warning from Jet %d (Fuel: %d).\n", jet->pid, feedback.data);
-                            jet->fuel = feedback.data; 
-                        }
-                        else if (feedback.status == STATUS_WAITING_FUEL) {
-                            log_event("[ATC Tower]: Refuel request from Jet %d (Fuel: %d).\n", jet->pid, feedback.data);
-                            scheduler_handle_refuel_request_unsafe(&scheduler, jet->pid, feedback.data, log_file);
-                        }
-                        else if (feedback.status == STATUS_REFUELED) {
-                            log_event("[ATC Tower]: Jet %d finished refueling (New Fuel: %d).\n", jet->pid, feedback.data);
-                            jet->fuel = feedback.data;
-                            jet->status = STATUS_IN_QUEUE; 
-                            if (scheduler.runway_jet_pid == jet->pid) {
-                                scheduler.is_runway_busy = false;
-                                scheduler.runway_jet_pid = 0;
-                                scheduler.runway_jet_q = 0;
-                            }
-                        }
-                        
-                    } else if (bytes == 0) {
-                        pid_t crashed_pid = jet->pid;
-                        log_event("[ATC Tower]: Jet %d pipe closed unexpectedly.\n", crashed_pid);
-                        scheduler_jet_landed_unsafe(&scheduler, crashed_pid, log_file); 
-                        waitpid(crashed_pid, NULL, 0);
-                        active_jet_count--;
+                    while (!landed && shm_ring_recv(ring, &feedback, sizeof(feedback))) {
+                        landed = (feedback.status == STATUS_LANDED);
+                        tower_handle_feedback_unsafe(&scheduler, jet, feedback); // Frees the record on landing
                     }
-                }
+                } while (!landed && !shm_ring_prepare_wait(ring));
+                continue;
+            }
+
+            JetFeedbackMessage feedback;
+            ssize_t bytes = read(jet->atc_read_fd, &feedback, sizeof(JetFeedbackMessage));
+            
+            if (bytes > 0) {
+                tower_handle_feedback_unsafe(&scheduler, jet, feedback);
+            } else if (bytes == 0) {
+                pid_t crashed_pid = jet->pid;
+                log_event("[ATC Tower]: Jet %d pipe closed unexpectedly.\n", crashed_pid);
+                scheduler_jet_landed_unsafe(&scheduler, crashed_pid, log_file); 
+                waitpid(crashed_pid, NULL, 0);
+                active_jet_count--;
             }
         }
         pthread_mutex_unlock(&scheduler.lock);
@@ -619,7 +835,9 @@ int main() {
     keep_running = false; 
     
     pthread_join(display_thread_id, NULL);
-    pthread_join(scheduler_thread_id, NULL);
+    if (tower_sectors) sectors_stop(&sectors);
+    else pthread_join(scheduler_thread_id, NULL);
+    metrics_server_stop(); // Before the schedulers it reads are destroyed
     
     // Send a newline to console thread to unblock fgets
     write(STDIN_FILENO, "\n", 1); 
@@ -627,16 +845,37 @@ int main() {
     pthread_join(console_thread_id, NULL);
     
     waitpid(generator_pid, NULL, 0); 
+
+    if (jet_backend == BACKEND_INPROC) {
+        if (tower_sectors) sectors_set_command_hook(&sectors, NULL, NULL);
+        pthread_mutex_lock(&scheduler.lock);
+        scheduler.command_hook = NULL;
+        pthread_mutex_unlock(&scheduler.lock);
+        jet_engine_stop(&jet_engine);
+    } else {
+        drone_pool_stop(&drone_pool);
+        if (use_mux_feedback) {
+            close(mux_socket[0]);
+            close(mux_socket[1]);
+        }
+    }
     
     if (!generator_is_done) close(generator_pipe[0]);
     close(console_pipe[0]); 
     
+    // --- NEW: Print final summary before closing log ---
+    async_log_stop(); // Every logging thread has been joined
+    journal_close();
+    session_record_close();
+    print_final_summary(); // Takes the scheduler and stats locks, so before they are destroyed
+    if (tower_sectors) {
+        sectors_destroy(&sectors);
+        tower_sectors = NULL;
+    }
+
     scheduler_destroy(&scheduler);
     pthread_mutex_destroy(&stats_lock); // --- NEW: Destroy stats lock
 
-    // --- NEW: Print final summary before closing log ---
-    print_final_summary();
-
     if (log_file) fclose(log_file);
 
     cout << "[ATC Tower]: Simulation finished. Log file created. Exiting." << endl;
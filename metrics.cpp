@@ -0,0 +1,253 @@
+#include "metrics.h"
+#include "journal.h"
+#include "async_log.h"
+#include "sector.h"
+#include <errno.h>
+#include <poll.h>
+#include <stddef.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define METRICS_POLL_MS 200         // Server checks for stop this often
+#define METRICS_REQUEST_WAIT_MS 100 // How long a client has to send its request
+
+// --- Per-thread counter shards ---
+
+struct alignas(64) MetricsShard {
+    uint64_t counters[MET_COUNTERS];
+};
+
+static MetricsShard metric_shards[METRICS_MAX_SHARDS];
+static int metric_shards_claimed = 0;
+static __thread MetricsShard* thread_shard = NULL;
+
+#define SHARED_SHARD (&metric_shards[METRICS_MAX_SHARDS - 1])
+
+void metrics_add(MetricCounter counter, uint64_t n) {
+    MetricsShard* shard = thread_shard;
+    if (shard == NULL) {
+        int i = __atomic_fetch_add(&metric_shards_claimed, 1, __ATOMIC_RELAXED);
+        shard = thread_shard = (i < METRICS_MAX_SHARDS - 1) ? &metric_shards[i] : SHARED_SHARD;
+    }
+    uint64_t* value = &shard->counters[counter];
+    if (shard == SHARED_SHARD) {
+        __atomic_fetch_add(value, n, __ATOMIC_RELAXED);
+        return;
+    }
+    // Only this thread writes it: a plain add, made atomic so a scrape never sees a torn value
+    __atomic_store_n(value, __atomic_load_n(value, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+uint64_t metrics_read(MetricCounter counter) {
+    uint64_t sum = 0;
+    for (int i = 0; i < METRICS_MAX_SHARDS; i++) {
+        sum += __atomic_load_n(&metric_shards[i].counters[counter], __ATOMIC_RELAXED);
+    }
+    return sum;
+}
+
+void metrics_count_decision(int journal_type) {
+    switch (journal_type) {
+        case JEV_ARRIVAL:               metrics_inc(MET_ARRIVALS); break;
+        case JEV_DISPATCH_EMERGENCY:    metrics_inc(MET_DISPATCH_EMERGENCY); break;
+        case JEV_DISPATCH_LANDING:      metrics_inc(MET_DISPATCH_LANDING); break;
+        case JEV_DISPATCH_REFUEL:       metrics_inc(MET_DISPATCH_REFUEL); break;
+        case JEV_PREEMPT:               metrics_inc(MET_PREEMPTIONS); break;
+        case JEV_EMERGENCY_PREEMPT:     metrics_inc(MET_EMERGENCY_PREEMPTIONS); break;
+        case JEV_RR_EXPIRED:            metrics_inc(MET_DEMOTIONS); break;
+        case JEV_AGING:                 metrics_inc(MET_AGINGS); break;
+        case JEV_EMERGENCY:             metrics_inc(MET_EMERGENCIES); break;
+        case JEV_REFUEL_REQUEST:        metrics_inc(MET_REFUEL_REQUESTS); break;
+        case JEV_LANDED:                metrics_inc(MET_LANDINGS); break;
+        default: break;
+    }
+}
+
+void metrics_count_feedback(int status) {
+    if (status < 0 || status >= METRICS_FEEDBACK_STATUSES) return;
+    metrics_add((MetricCounter)(MET_FEEDBACK + status), 1);
+}
+
+// --- Prometheus text format ---
+
+struct CounterInfo {
+    MetricCounter counter;
+    const char* name;
+    const char* labels;     // NULL, or the labels of this series
+    const char* help;       // Once per metric family: NULL for the family's later series
+};
+
+static const CounterInfo COUNTERS[] = {
+    { MET_ARRIVALS, "skywatch_arrivals_total", NULL, "Jets added to the scheduler" },
+    { MET_DISPATCH_EMERGENCY, "skywatch_dispatches_total", "kind=\"emergency\"", "Runway and refuel bay dispatches" },
+    { MET_DISPATCH_LANDING, "skywatch_dispatches_total", "kind=\"landing\"", NULL },
+    { MET_DISPATCH_REFUEL, "skywatch_dispatches_total", "kind=\"refuel\"", NULL },
+    { MET_PREEMPTIONS, "skywatch_preemptions_total", NULL, "Runways taken from a jet" },
+    { MET_EMERGENCY_PREEMPTIONS, "skywatch_emergency_preemptions_total", NULL, "Emergencies that preempted a runway" },
+    { MET_DEMOTIONS, "skywatch_demotions_total", NULL, "Q2 jets demoted to Q3 when their RR quantum expired" },
+    { MET_AGINGS, "skywatch_agings_total", NULL, "Q3 jets promoted to Q2 by aging" },
+    { MET_EMERGENCIES, "skywatch_emergencies_total", NULL, "Jets moved to Q1" },
+    { MET_REFUEL_REQUESTS, "skywatch_refuel_requests_total", NULL, "Jets sent to refuel" },
+    { MET_LANDINGS, "skywatch_landings_total", NULL, "Jets landed" },
+    { MET_CONTEXT_SWITCHES, "skywatch_context_switches_total", NULL, "Dispatches, preemptions and RR demotions" },
+    { MET_STEALS, "skywatch_sector_steals_total", NULL, "Jets moved between sectors by work stealing" },
+    { MET_SPAWN_FAILURES, "skywatch_spawn_failures_total", NULL, "Drones that could not be forked or activated" },
+};
+
+static const char* FEEDBACK_LABELS[METRICS_FEEDBACK_STATUSES] = {
+    "in_queue", "fuel_low", "emergency", "landed", "waiting_fuel", "landing_cmd", "refueling", "refueled"
+};
+
+static void write_family(FILE* out, const char* name, const char* type, const char* help) {
+    fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void write_gauges(FILE* out, SchedulerState* const* schedulers, int count) {
+    static const char* QUEUE_NAMES[4] = { "q1", "q2", "q3", "refuel" };
+    // One snapshot per scheduler, taken once so every gauge of a sector agrees
+    RadarSnapshot snaps[MAX_SECTORS];
+    if (count > MAX_SECTORS) count = MAX_SECTORS;
+    for (int k = 0; k < count; k++) scheduler_read_radar(schedulers[k], &snaps[k]);
+
+    write_family(out, "skywatch_queue_depth", "gauge", "Jets in each queue");
+    for (int k = 0; k < count; k++) {
+        for (int q = 0; q < 4; q++) {
+            fprintf(out, "skywatch_queue_depth{sector=\"%d\",queue=\"%s\"} %d\n",
+                    k + 1, QUEUE_NAMES[q], snaps[k].queues[q].count);
+        }
+    }
+    write_family(out, "skywatch_runways", "gauge", "Runways");
+    for (int k = 0; k < count; k++) fprintf(out, "skywatch_runways{sector=\"%d\"} %d\n", k + 1, snaps[k].runway_count);
+    write_family(out, "skywatch_runways_busy", "gauge", "Runways held by a jet");
+    for (int k = 0; k < count; k++) fprintf(out, "skywatch_runways_busy{sector=\"%d\"} %d\n", k + 1, snaps[k].runways_busy);
+    write_family(out, "skywatch_refuel_bays", "gauge", "Refuel bays");
+    for (int k = 0; k < count; k++) fprintf(out, "skywatch_refuel_bays{sector=\"%d\"} %d\n", k + 1, snaps[k].bay_count);
+    write_family(out, "skywatch_refuel_bays_busy", "gauge", "Refuel bays in use");
+    for (int k = 0; k < count; k++) fprintf(out, "skywatch_refuel_bays_busy{sector=\"%d\"} %d\n", k + 1, snaps[k].bays_busy);
+    write_family(out, "skywatch_refuel_waiting", "gauge", "Jets waiting for a refuel bay");
+    for (int k = 0; k < count; k++) fprintf(out, "skywatch_refuel_waiting{sector=\"%d\"} %d\n", k + 1, snaps[k].bays_waiting);
+    write_family(out, "skywatch_paused", "gauge", "1 while the scheduler is paused from the console");
+    for (int k = 0; k < count; k++) fprintf(out, "skywatch_paused{sector=\"%d\"} %d\n", k + 1, snaps[k].paused ? 1 : 0);
+}
+
+void metrics_write(FILE* out, SchedulerState* const* schedulers, int count) {
+    for (size_t i = 0; i < sizeof(COUNTERS) / sizeof(COUNTERS[0]); i++) {
+        const CounterInfo* c = &COUNTERS[i];
+        if (c->help) write_family(out, c->name, "counter", c->help);
+        if (c->labels) fprintf(out, "%s{%s} %llu\n", c->name, c->labels, (unsigned long long)metrics_read(c->counter));
+        else fprintf(out, "%s %llu\n", c->name, (unsigned long long)metrics_read(c->counter));
+    }
+    write_family(out, "skywatch_feedback_messages_total", "counter", "Feedback messages from jets, by status");
+    for (int st = 0; st < METRICS_FEEDBACK_STATUSES; st++) {
+        fprintf(out, "skywatch_feedback_messages_total{status=\"%s\"} %llu\n", FEEDBACK_LABELS[st],
+                (unsigned long long)metrics_read((MetricCounter)(MET_FEEDBACK + st)));
+    }
+    write_family(out, "skywatch_log_lines_dropped_total", "counter", "Log lines dropped by --log-full drop");
+    fprintf(out, "skywatch_log_lines_dropped_total %ld\n", async_log_dropped());
+    write_gauges(out, schedulers, count);
+}
+
+// --- Scrape server ---
+
+struct MetricsServer {
+    int listen_fd;
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    SchedulerState* const* schedulers;
+    int count;
+    bool running;       // Atomic: cleared by metrics_server_stop
+    bool started;
+    pthread_t thread;
+};
+
+static MetricsServer server = { -1, "", NULL, 0, false, false, 0 };
+
+static void send_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        data += n;
+        len -= n;
+    }
+}
+
+static void serve_client(int fd) {
+    // An HTTP client speaks first; a plain reader (nc -U, socat) may not send anything
+    char request[512];
+    ssize_t got = 0;
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    if (poll(&pfd, 1, METRICS_REQUEST_WAIT_MS) > 0) got = recv(fd, request, sizeof(request) - 1, 0);
+    bool http = (got >= 4 && memcmp(request, "GET ", 4) == 0);
+
+    char* body = NULL;
+    size_t body_len = 0;
+    FILE* out = open_memstream(&body, &body_len);
+    if (out == NULL) return;
+    metrics_write(out, server.schedulers, server.count);
+    fclose(out);
+
+    if (http) {
+        char header[160];
+        int len = snprintf(header, sizeof(header),
+                           "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                           "Content-Length: %zu\r\nConnection: close\r\n\r\n", body_len);
+        send_all(fd, header, len);
+    }
+    send_all(fd, body, body_len);
+    free(body);
+}
+
+static void* server_loop(void* arg) {
+    (void)arg;
+    while (__atomic_load_n(&server.running, __ATOMIC_RELAXED)) {
+        struct pollfd pfd = { server.listen_fd, POLLIN, 0 };
+        if (poll(&pfd, 1, METRICS_POLL_MS) <= 0) continue;
+        int fd = accept4(server.listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        serve_client(fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+bool metrics_server_start(const char* socket_path, SchedulerState* const* schedulers, int count) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+    unlink(socket_path); // Left behind by a tower that did not exit cleanly
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == -1 || listen(fd, 16) == -1) {
+        close(fd);
+        return false;
+    }
+    server.listen_fd = fd;
+    strcpy(server.path, socket_path);
+    server.schedulers = schedulers;
+    server.count = count;
+    server.running = true;
+    if (pthread_create(&server.thread, NULL, server_loop, NULL) != 0) {
+        close(fd);
+        unlink(socket_path);
+        server.listen_fd = -1;
+        return false;
+    }
+    server.started = true;
+    return true;
+}
+
+void metrics_server_stop() {
+    if (!server.started) return;
+    __atomic_store_n(&server.running, false, __ATOMIC_RELAXED);
+    pthread_join(server.thread, NULL);
+    close(server.listen_fd);
+    unlink(server.path);
+    server.listen_fd = -1;
+    server.started = false;
+}
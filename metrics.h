@@ -0,0 +1,59 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "utils.h"
+#include "scheduler.h"
+#include <stdint.h>
+
+/**
+ * @brief Live tower metrics in Prometheus text format.
+ *
+ * Counters are sharded per thread: each thread that counts gets its own
+ * cache line of counters on first use and is its only writer, so
+ * counting is a relaxed load and store with no lock and no shared line.
+ * Threads past METRICS_MAX_SHARDS share the last shard with atomic adds.
+ * A scrape sums the shards.
+ *
+ * Gauges (queue depths, runways and bays in use) come from each
+ * scheduler's radar snapshot, so a scrape never takes s->lock.
+ */
+
+#define METRICS_MAX_SHARDS 64
+#define METRICS_FEEDBACK_STATUSES (STATUS_REFUELED + 1) // One counter per JetStatus
+
+enum MetricCounter {
+    MET_ARRIVALS,
+    MET_DISPATCH_EMERGENCY,     // Runway dispatches, by kind
+    MET_DISPATCH_LANDING,
+    MET_DISPATCH_REFUEL,        // Refuel bay (or a runway with no bays)
+    MET_PREEMPTIONS,            // Runway taken from a jet
+    MET_EMERGENCY_PREEMPTIONS,
+    MET_DEMOTIONS,              // RR quantum expired, Q2 -> Q3
+    MET_AGINGS,                 // Q3 -> Q2
+    MET_EMERGENCIES,
+    MET_REFUEL_REQUESTS,
+    MET_LANDINGS,
+    MET_CONTEXT_SWITCHES,
+    MET_STEALS,                 // Jets moved between sectors
+    MET_SPAWN_FAILURES,         // Drones that could not be forked or activated
+    MET_FEEDBACK,               // First of METRICS_FEEDBACK_STATUSES, indexed by JetStatus
+    MET_COUNTERS = MET_FEEDBACK + METRICS_FEEDBACK_STATUSES
+};
+
+// --- Counting (any thread, lock-free) ---
+void metrics_add(MetricCounter counter, uint64_t n);
+inline void metrics_inc(MetricCounter counter) { metrics_add(counter, 1); }
+void metrics_count_decision(int journal_type); // A JournalEventType from record_decision
+void metrics_count_feedback(int status);       // A JetStatus
+uint64_t metrics_read(MetricCounter counter);  // Summed over every thread
+
+// Writes every counter, and the gauges of `schedulers`, in Prometheus text format
+void metrics_write(FILE* out, SchedulerState* const* schedulers, int count);
+
+// --- Scrape endpoint: its own thread serving a Unix domain socket ---
+// A client that sends an HTTP GET gets an HTTP response (curl --unix-socket),
+// anything else just gets the text. `schedulers` must outlive the server.
+bool metrics_server_start(const char* socket_path, SchedulerState* const* schedulers, int count);
+void metrics_server_stop(); // Joins the thread and removes the socket; no-op if not started
+
+#endif // METRICS_H
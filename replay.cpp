@@ -0,0 +1,183 @@
+#include "replay.h"
+#include "session.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stddef.h>
+
+static uint32_t replay_version; // Header version of the recording being replayed
+
+// SchedulerCommandHook: the jets are gone, so a command is "delivered" if it was in the recording
+static bool replay_command_hook(void*, SchedulerJet*, AtcCommand) {
+    return session_verify_command_ok();
+}
+
+static void apply_input(const SessionRecord* r) {
+    switch (r->kind) {
+    case SREC_ARRIVAL:
+        scheduler_add_jet(&scheduler, r->pid, -1, -1, r->a, log_file);
+        active_jet_count++;
+        break;
+    case SREC_TICK:
+        scheduler_tick(&scheduler, log_file);
+        break;
+    case SREC_DISPATCH:
+        scheduler_dispatch(&scheduler, log_file);
+        break;
+    case SREC_FEEDBACK: {
+        pthread_mutex_lock(&scheduler.lock);
+        SchedulerJet* jet = scheduler_find_jet_unsafe(&scheduler, r->pid, NULL);
+        JetFeedbackMessage msg = { (JetStatus)r->code, r->a };
+        if (jet) tower_handle_feedback_unsafe(&scheduler, jet, msg);
+        pthread_mutex_unlock(&scheduler.lock);
+        break;
+    }
+    case SREC_FORCE_EMERGENCY:
+        pthread_mutex_lock(&scheduler.lock);
+        scheduler_handle_emergency_unsafe(&scheduler, r->pid, r->a, log_file);
+        pthread_mutex_unlock(&scheduler.lock);
+        break;
+    case SREC_BOOST: {
+        pthread_mutex_lock(&scheduler.lock);
+        SchedulerJet* jet = scheduler_find_jet_unsafe(&scheduler, r->pid, NULL);
+        if (jet) scheduler_move_jet_unsafe(&scheduler, jet, r->a, log_file);
+        pthread_mutex_unlock(&scheduler.lock);
+        break;
+    }
+    case SREC_SET_QUANTUM:
+        pthread_mutex_lock(&scheduler.lock);
+        scheduler_set_quantum_ms(&scheduler, (replay_version >= 4) ? r->a : r->a * 1000);
+        pthread_mutex_unlock(&scheduler.lock);
+        break;
+    case SREC_SET_PAUSED:
+        pthread_mutex_lock(&scheduler.lock);
+        scheduler.is_paused = (r->a != 0);
+        scheduler_publish_radar_unsafe(&scheduler);
+        pthread_mutex_unlock(&scheduler.lock);
+        break;
+    default:
+        break;
+    }
+}
+
+static void report_divergence(uint64_t pos, const SessionRecord* input, uint64_t input_pos,
+                              const SessionRecord* expected, const SessionRecord* actual) {
+    char in_buf[128], exp_buf[128], act_buf[128];
+    session_format_record(input, in_buf, sizeof(in_buf));
+    session_format_record(expected, exp_buf, sizeof(exp_buf));
+    session_format_record(actual, act_buf, sizeof(act_buf));
+    log_event("[Replay]: DIVERGED at record %llu, while applying record %llu (%s, t=%lld).\n",
+              (unsigned long long)pos, (unsigned long long)input_pos, in_buf, (long long)input->time);
+    log_event("[Replay]:   recorded: %s\n", exp_buf);
+    log_event("[Replay]:   replayed: %s\n", act_buf);
+}
+
+int run_replay(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        perror("Replay: open");
+        return 1;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    if (st.st_size < (off_t)sizeof(SessionHeader)) {
+        log_event("[Replay]: ERROR: %s is not a session recording.\n", path);
+        close(fd);
+        return 1;
+    }
+    const char* map = (const char*)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("Replay: mmap");
+        return 1;
+    }
+    const SessionHeader* h = (const SessionHeader*)map;
+    // Version 1 recordings predate refuel bays: shorter header, refuels took a runway.
+    // Versions 2 and 3 end before start_ns and count time in seconds.
+    size_t header_size = (h->version >= 4) ? sizeof(SessionHeader) :
+                         (h->version >= 2) ? offsetof(SessionHeader, start_ns) : offsetof(SessionHeader, refuel_bays);
+    if (memcmp(h->magic, SESSION_MAGIC, 8) != 0 || h->record_size != sizeof(SessionRecord) ||
+        (size_t)st.st_size < header_size) {
+        log_event("[Replay]: ERROR: %s is not a session recording (or version %u).\n", path, h->version);
+        munmap((void*)map, st.st_size);
+        return 1;
+    }
+    // --- NEW: Decisions only match under the policy they were made by ---
+    int policy = (h->version >= 2) ? h->policy : SCHED_POLICY_MLFQ;
+    if (policy != SCHEDULER_POLICY) {
+        log_event("[Replay]: ERROR: %s was recorded under policy %d, this build schedules with %s (%d).\n",
+                  path, policy, scheduler_policy_name(), SCHEDULER_POLICY);
+        munmap((void*)map, st.st_size);
+        return 1;
+    }
+    const SessionRecord* records = (const SessionRecord*)(map + header_size);
+    uint64_t count = (st.st_size - header_size) / sizeof(SessionRecord);
+
+    replay_version = h->version;
+    int64_t wall_offset_ns = 0;
+    if (h->version >= 4) {
+        wall_offset_ns = h->start_time * (int64_t)NS_PER_SEC - h->start_ns;
+        scheduler_set_virtual_time_ns(h->start_ns, wall_offset_ns);
+    } else {
+        scheduler_set_virtual_time(h->start_time);
+    }
+    simulation_start_ns = scheduler_now_ns();
+    scheduler_set_runway_count(&scheduler, h->runway_count);
+    scheduler_set_refuel_bays(&scheduler, (h->version >= 2) ? h->refuel_bays : 0);
+    scheduler_set_quantum_ms(&scheduler, (h->version >= 4) ? h->q2_quantum_ms : RR_QUANTUM_MS);
+    scheduler.command_hook = replay_command_hook;
+    scheduler.command_hook_ctx = NULL;
+    tower_reap_jets = false;
+    log_event("[Replay]: Replaying %s (%s clock, %d runway(s), %d refuel bay(s), %llu records).\n", path,
+              h->virtual_clock ? "virtual" : "wall", scheduler.runway_count, scheduler.bay_count,
+              (unsigned long long)count);
+
+    session_verify_begin(records, count);
+    uint64_t inputs = 0, decisions = 0;
+    int result = 0;
+    uint64_t i = 0;
+    while (i < count) {
+        const SessionRecord* r = &records[i];
+        if (!session_is_input(r->kind)) {
+            // Only a recording that does not start with an input gets here
+            SessionRecord none;
+            memset(&none, 0, sizeof(none));
+            report_divergence(i, r, i, r, &none);
+            result = 1;
+            break;
+        }
+        if (h->version >= 4) scheduler_set_virtual_time_ns(r->time, wall_offset_ns);
+        else scheduler_set_virtual_time(r->time);
+        session_verify_seek(i + 1);
+        apply_input(r);
+        inputs++;
+
+        uint64_t next = session_verify_pos();
+        if (session_verify_failed()) {
+            SessionRecord expected, actual;
+            uint64_t pos = session_verify_mismatch(&expected, &actual);
+            report_divergence(pos, r, i, &expected, &actual);
+            result = 1;
+            break;
+        }
+        if (next < count && !session_is_input(records[next].kind)) {
+            // The recorded run decided more in response to this input
+            SessionRecord none;
+            memset(&none, 0, sizeof(none));
+            report_divergence(next, r, i, &records[next], &none);
+            result = 1;
+            break;
+        }
+        decisions += next - (i + 1);
+        i = next;
+    }
+    session_verify_end();
+
+    if (result == 0) {
+        log_event("[Replay]: Replay matched: %llu inputs, %llu decisions identical.\n",
+                  (unsigned long long)inputs, (unsigned long long)decisions);
+    }
+    scheduler.command_hook = NULL;
+    munmap((void*)map, st.st_size);
+    return result;
+}
@@ -0,0 +1,16 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "tower.h"
+
+/**
+ * @brief Replays a session recorded with --record. The recorded inputs
+ * go through the same scheduler and tower functions on a virtual clock,
+ * with no drone processes and no sleeps, and every decision is checked
+ * against the recording. Stops at the first divergence.
+ */
+
+// Returns 0 if every decision matched. scheduler and log_file must be set up.
+int run_replay(const char* path);
+
+#endif // REPLAY_H
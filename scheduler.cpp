@@ -1,10 +1,72 @@
 #include "scheduler.h"
+#include "async_log.h"
+#include "journal.h"
+#include "session.h"
+#include "metrics.h"
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <poll.h>
+
+// --- Scheduler Clock ---
+// --- MODIFIED: The virtual clock is in ns. A recording on the real clock
+// also runs on it, stepped at each input (session.cpp), so that a replay
+// sees exactly the times the recorded run did ---
+static bool use_virtual_time = false;
+static uint64_t virtual_ns = 0;           // Read by other threads (display)
+static int64_t virtual_wall_offset_ns = 0; // Wall clock = virtual_ns + offset, for log stamps
+
+time_t scheduler_now() {
+    if (!use_virtual_time) return time(NULL);
+    int64_t wall_ns = (int64_t)__atomic_load_n(&virtual_ns, __ATOMIC_RELAXED) + virtual_wall_offset_ns;
+    return (time_t)(wall_ns / (int64_t)NS_PER_SEC);
+}
+
+// Switches the clock to virtual time (simulation mode) and sets it
+void scheduler_set_virtual_time(time_t now) {
+    scheduler_set_virtual_time_ns((uint64_t)now * NS_PER_SEC, 0);
+}
+
+void scheduler_set_virtual_time_ns(uint64_t now_ns, int64_t wall_offset_ns) {
+    virtual_wall_offset_ns = wall_offset_ns;
+    __atomic_store_n(&virtual_ns, now_ns, __ATOMIC_RELAXED);
+    use_virtual_time = true;
+}
+
+uint64_t scheduler_monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+uint64_t scheduler_now_ns() {
+    if (use_virtual_time) return __atomic_load_n(&virtual_ns, __ATOMIC_RELAXED);
+    return scheduler_monotonic_ns();
+}
+
+// --- NEW: One scheduling decision, for the binary journal, the session recording and the live metrics ---
+static void record_decision(JournalEventType type, pid_t pid, int from_q, int to_q, int fuel,
+                            int runway = -1, pid_t other_pid = 0, int aux = 0) {
+    metrics_count_decision(type);
+    session_decision(SREC_DECISION, type, pid, from_q, to_q, fuel, other_pid);
+    if (!journal_enabled()) return;
+    journal_emit(scheduler_now_ns(), type, pid, from_q, to_q, fuel, runway, other_pid, aux);
+}
 
 // Helper function for logging within the scheduler
 static void log_scheduler_event(FILE* log_file, const char* format, ...) {
-    if (log_file) {
-        time_t now = time(0);
+    if (log_file && async_log_running()) {
+        // --- NEW: Queued for the writer thread, no I/O under s->lock ---
+        va_list args;
+        va_start(args, format);
+        async_log_vwrite(LOG_TO_FILE, scheduler_now(), format, args);
+        va_end(args);
+    } else if (log_file) {
+        time_t now = scheduler_now();
         tm *ltm = localtime(&now);
         char time_buf[20];
         snprintf(time_buf, 20, "[%02d:%02d:%02d] ", ltm->tm_hour, ltm->tm_min, ltm->tm_sec);
@@ -18,384 +80,1313 @@ static void log_scheduler_event(FILE* log_file, const char* format, ...) {
 }
 
 
+// --- NEW: Scheduling policies (interface in scheduler.h, definitions below the helpers) ---
+
+// The assignment's MLFQ: emergencies by least fuel (Q1 heap), arrivals RR (Q2),
+// demoted and refueling jets FCFS in Q3 until they age back to Q2
+struct MlfqPolicy {
+    static const char* name() { return "mlfq"; }
+    static int on_arrival(SchedulerState* s, SchedulerJet* jet);
+    static bool ready(const SchedulerJet* jet);
+    static bool before(const SchedulerJet* a, const SchedulerJet* b);
+    static SchedulerJet* select_next(SchedulerState* s);
+    static bool on_dispatch(SchedulerState* s, SchedulerJet* jet, int from_q);
+    static bool ages(const SchedulerJet* jet);
+    static void on_tick_aging(SchedulerState* s, SchedulerJet* jet, FILE* log_file);
+    static void on_tick_quantum(SchedulerState* s, SchedulerJet* jet, int r, FILE* log_file);
+    static void on_feedback(SchedulerState* s, SchedulerJet* jet);
+    static int should_preempt(SchedulerState* s, SchedulerJet* jet, FILE* log_file);
+};
+
+// Every waiting jet in one heap on fuel (its deadline), no quantum, no aging.
+// Queues only label jets (emergency, refuel); they do not change the order.
+struct EdfPolicy {
+    static const char* name() { return "edf"; }
+    static int on_arrival(SchedulerState* s, SchedulerJet* jet);
+    static bool ready(const SchedulerJet* jet);
+    static bool before(const SchedulerJet* a, const SchedulerJet* b);
+    static SchedulerJet* select_next(SchedulerState* s);
+    static bool on_dispatch(SchedulerState* s, SchedulerJet* jet, int from_q);
+    static bool ages(const SchedulerJet* jet);
+    static void on_tick_aging(SchedulerState* s, SchedulerJet* jet, FILE* log_file);
+    static void on_tick_quantum(SchedulerState* s, SchedulerJet* jet, int r, FILE* log_file);
+    static void on_feedback(SchedulerState* s, SchedulerJet* jet);
+    static int should_preempt(SchedulerState* s, SchedulerJet* jet, FILE* log_file);
+};
+
+// Stride scheduling: every dispatch is a grant charged to the jet's pass at
+// STRIDE_ONE / tickets, lowest pass goes next. Emergencies (Q1) go first.
+struct StridePolicy {
+    static const char* name() { return "stride"; }
+    static int on_arrival(SchedulerState* s, SchedulerJet* jet);
+    static bool ready(const SchedulerJet* jet);
+    static bool before(const SchedulerJet* a, const SchedulerJet* b);
+    static SchedulerJet* select_next(SchedulerState* s);
+    static bool on_dispatch(SchedulerState* s, SchedulerJet* jet, int from_q);
+    static bool ages(const SchedulerJet* jet);
+    static void on_tick_aging(SchedulerState* s, SchedulerJet* jet, FILE* log_file);
+    static void on_tick_quantum(SchedulerState* s, SchedulerJet* jet, int r, FILE* log_file);
+    static void on_feedback(SchedulerState* s, SchedulerJet* jet);
+    static int should_preempt(SchedulerState* s, SchedulerJet* jet, FILE* log_file);
+};
+
+#if SCHEDULER_POLICY == SCHED_POLICY_EDF
+typedef EdfPolicy SchedulerPolicy;
+#elif SCHEDULER_POLICY == SCHED_POLICY_STRIDE
+typedef StridePolicy SchedulerPolicy;
+#else
+typedef MlfqPolicy SchedulerPolicy;
+#endif
+
+const char* scheduler_policy_name() {
+    return SchedulerPolicy::name();
+}
+
+
 // --- Helper Functions (Internal) ---
 
-static int find_empty_slot(SchedulerJet queue[]) {
-    for (int i = 0; i < MAX_JETS; i++) {
-        if (queue[i].pid == 0) { return i; }
+// --- NEW: Ask the scheduler thread to dispatch now instead of at the next tick ---
+static void request_dispatch(SchedulerState* s) {
+    if (s->dispatch_pending) return; // Already rung, one wakeup is enough
+    s->dispatch_pending = true;
+    if (s->dispatch_fd >= 0) eventfd_write(s->dispatch_fd, 1);
+}
+
+// --- MODIFIED: Wait time from timestamps ---
+
+// --- NEW: Q3 aging runs off the timer wheel ---
+// Armed while the jet waits in Q3 (if the policy ages it), due once it has waited more than aging_ms
+static void aging_timer_sync(SchedulerState* s, SchedulerJet* jet) {
+    if (!SchedulerPolicy::ages(jet) || jet->queued_ns == 0) {
+        timer_wheel_cancel(&s->timers, &jet->aging_timer);
+        return;
     }
-    return -1;
+    uint64_t deadline = jet->queued_ns + (uint64_t)s->aging_ms * NS_PER_MS + 1;
+    if (jet->aging_timer.armed && jet->aging_timer.deadline_ns == deadline) return;
+    timer_wheel_arm(&s->timers, &jet->aging_timer, deadline, scheduler_now_ns());
 }
 
-SchedulerJet* scheduler_find_jet_unsafe(SchedulerState* s, pid_t pid, int* out_q, int* out_idx) {
-    SchedulerJet* queues[] = { s->queue1, s->queue2, s->queue3 };
-    for (int q = 0; q < 3; q++) {
-        for (int i = 0; i < MAX_JETS; i++) {
-            if (queues[q][i].pid == pid) {
-                if (out_q) *out_q = q + 1;
-                if (out_idx) *out_idx = i;
-                return &queues[q][i];
-            }
+// Adds the jet's current wait (if it is waiting) to its total
+static inline void wait_end(SchedulerState* s, SchedulerJet* jet, uint64_t now) {
+    if (jet->queued_ns == 0) return;
+    jet->total_wait_ns += now - jet->queued_ns;
+    jet->queued_ns = 0;
+    aging_timer_sync(s, jet);
+}
+
+// The jet (re)starts waiting for a runway or bay, unless it holds one
+static inline void mark_queued(SchedulerState* s, SchedulerJet* jet) {
+    uint64_t now = scheduler_now_ns();
+    wait_end(s, jet, now);
+    if (jet->runway < 0 && jet->bay < 0) jet->queued_ns = now;
+    aging_timer_sync(s, jet);
+}
+
+static void queue_push_back(JetQueue* q, SchedulerJet* jet) {
+    jet->prev = q->tail;
+    jet->next = NULL;
+    if (q->tail) q->tail->next = jet;
+    else q->head = jet;
+    q->tail = jet;
+    q->count++;
+}
+
+static void queue_unlink(JetQueue* q, SchedulerJet* jet) {
+    if (jet->prev) jet->prev->next = jet->next;
+    else q->head = jet->next;
+    if (jet->next) jet->next->prev = jet->prev;
+    else q->tail = jet->prev;
+    jet->prev = jet->next = NULL;
+    q->count--;
+}
+
+// Carves a new slab into the free list. Existing records never move.
+static bool pool_grow(SchedulerState* s) {
+    // The Q1 heap can hold every record in the pool
+    int new_capacity = (s->slab_count + 1) * JET_SLAB_SIZE;
+    SchedulerJet** heap = (SchedulerJet**)realloc(s->q1_heap, new_capacity * sizeof(SchedulerJet*));
+    if (heap == NULL) return false;
+    s->q1_heap = heap;
+
+    JetSlab* slab = (JetSlab*)malloc(sizeof(JetSlab));
+    if (slab == NULL) return false;
+    memset(slab, 0, sizeof(JetSlab));
+
+    slab->next = s->slabs;
+    s->slabs = slab;
+    s->slab_count++;
+
+    // Push in reverse so records are handed out in address order
+    for (int i = JET_SLAB_SIZE - 1; i >= 0; i--) {
+        slab->jets[i].next = s->free_list;
+        s->free_list = &slab->jets[i];
+    }
+    return true;
+}
+
+static SchedulerJet* pool_alloc(SchedulerState* s) {
+    if (s->free_list == NULL && !pool_grow(s)) return NULL;
+    SchedulerJet* jet = s->free_list;
+    s->free_list = jet->next;
+    memset(jet, 0, sizeof(SchedulerJet));
+    jet->heap_idx = -1;
+    timer_entry_init(&jet->aging_timer, TIMER_AGING);
+    return jet;
+}
+
+static void pool_free(SchedulerState* s, SchedulerJet* jet) {
+    timer_wheel_cancel(&s->timers, &jet->aging_timer);
+    jet->pid = 0;
+    jet->queue = 0;
+    jet->prev = NULL;
+    jet->next = s->free_list;
+    s->free_list = jet;
+}
+
+// --- PID Index (Internal) ---
+
+static inline int index_slot_for(const JetIndex* idx, pid_t pid) {
+    // Fibonacci hashing spreads sequential pids across the table
+    return (int)(((uint32_t)pid * 2654435769u) & (uint32_t)(idx->capacity - 1));
+}
+
+static bool index_init(JetIndex* idx, int capacity) {
+    idx->slots = (JetIndexSlot*)calloc(capacity, sizeof(JetIndexSlot));
+    idx->capacity = (idx->slots != NULL) ? capacity : 0;
+    idx->size = 0;
+    return idx->slots != NULL;
+}
+
+static SchedulerJet* index_lookup(const JetIndex* idx, pid_t pid) {
+    if (idx->capacity == 0 || pid == 0) return NULL;
+    int mask = idx->capacity - 1;
+    for (int i = index_slot_for(idx, pid); idx->slots[i].pid != 0; i = (i + 1) & mask) {
+        if (idx->slots[i].pid == pid) return idx->slots[i].jet;
+    }
+    return NULL;
+}
+
+static void index_put_unchecked(JetIndex* idx, pid_t pid, SchedulerJet* jet) {
+    int mask = idx->capacity - 1;
+    int i = index_slot_for(idx, pid);
+    while (idx->slots[i].pid != 0 && idx->slots[i].pid != pid) i = (i + 1) & mask;
+    if (idx->slots[i].pid == 0) idx->size++;
+    idx->slots[i].pid = pid;
+    idx->slots[i].jet = jet;
+}
+
+static bool index_insert(JetIndex* idx, pid_t pid, SchedulerJet* jet) {
+    if ((idx->size + 1) * 2 > idx->capacity) {
+        JetIndex bigger;
+        if (!index_init(&bigger, idx->capacity > 0 ? idx->capacity * 2 : JET_INDEX_INITIAL_CAPACITY)) return false;
+        for (int i = 0; i < idx->capacity; i++) {
+            if (idx->slots[i].pid != 0) index_put_unchecked(&bigger, idx->slots[i].pid, idx->slots[i].jet);
+        }
+        free(idx->slots);
+        *idx = bigger;
+    }
+    index_put_unchecked(idx, pid, jet);
+    return true;
+}
+
+// Backward-shift deletion keeps probe chains intact without tombstones
+static void index_remove(JetIndex* idx, pid_t pid) {
+    if (idx->capacity == 0 || pid == 0) return;
+    int mask = idx->capacity - 1;
+    int i = index_slot_for(idx, pid);
+    while (idx->slots[i].pid != pid) {
+        if (idx->slots[i].pid == 0) return; // Not present
+        i = (i + 1) & mask;
+    }
+
+    int hole = i;
+    for (int j = (hole + 1) & mask; idx->slots[j].pid != 0; j = (j + 1) & mask) {
+        int home = index_slot_for(idx, idx->slots[j].pid);
+        // Move j into the hole unless its home lies cyclically in (hole, j]
+        bool stays = (hole <= j) ? (hole < home && home <= j) : (hole < home || home <= j);
+        if (!stays) {
+            idx->slots[hole] = idx->slots[j];
+            hole = j;
         }
     }
+    idx->slots[hole].pid = 0;
+    idx->slots[hole].jet = NULL;
+    idx->size--;
+}
+
+// --- Q1 SRTF Heap (Internal) ---
+
+// --- MODIFIED: The order is the policy's (MLFQ: lower fuel first, ties by Q1 entry)
+static inline bool heap_before(const SchedulerJet* a, const SchedulerJet* b) {
+    return SchedulerPolicy::before(a, b);
+}
+
+static inline void heap_place(SchedulerState* s, int i, SchedulerJet* jet) {
+    s->q1_heap[i] = jet;
+    jet->heap_idx = i;
+}
+
+static void heap_sift_up(SchedulerState* s, int i) {
+    SchedulerJet* jet = s->q1_heap[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!heap_before(jet, s->q1_heap[parent])) break;
+        heap_place(s, i, s->q1_heap[parent]);
+        i = parent;
+    }
+    heap_place(s, i, jet);
+}
+
+static void heap_sift_down(SchedulerState* s, int i) {
+    SchedulerJet* jet = s->q1_heap[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= s->q1_heap_size) break;
+        if (child + 1 < s->q1_heap_size && heap_before(s->q1_heap[child + 1], s->q1_heap[child])) child++;
+        if (!heap_before(s->q1_heap[child], jet)) break;
+        heap_place(s, i, s->q1_heap[child]);
+        i = child;
+    }
+    heap_place(s, i, jet);
+}
+
+static void heap_remove(SchedulerState* s, SchedulerJet* jet) {
+    int i = jet->heap_idx;
+    jet->heap_idx = -1;
+    SchedulerJet* last = s->q1_heap[--s->q1_heap_size];
+    if (last == jet) return;
+    heap_place(s, i, last);
+    heap_sift_up(s, i);
+    heap_sift_down(s, last->heap_idx);
+}
+
+// --- NEW: Keeps s->q2_waiting_fuel in step with the jet's queue and status ---
+static void q2_refuel_sync(SchedulerState* s, SchedulerJet* jet) {
+    bool waiting = (jet->queue == 2 && jet->status == STATUS_WAITING_FUEL);
+    if (waiting == jet->q2_refuel_counted) return;
+    jet->q2_refuel_counted = waiting;
+    s->q2_waiting_fuel += waiting ? 1 : -1;
+}
+
+/**
+ * @brief Puts a jet in, takes it out of, or re-keys it in the Q1 heap
+ * to match its current queue, status, fuel and runway state. Called
+ * after anything that changes one of those for a jet.
+ * --- MODIFIED: Which jets belong in it is up to the policy. Also keeps
+ * the count of Q2 jets waiting to refuel ---
+ */
+static void q1_heap_sync(SchedulerState* s, SchedulerJet* jet) {
+    q2_refuel_sync(s, jet);
+    bool ready = SchedulerPolicy::ready(jet);
+
+    if (!ready) {
+        if (jet->heap_idx >= 0) heap_remove(s, jet);
+    } else if (jet->heap_idx < 0) {
+        heap_place(s, s->q1_heap_size++, jet);
+        heap_sift_up(s, jet->heap_idx);
+    } else {
+        heap_sift_up(s, jet->heap_idx);   // Decrease-key (fuel went down)
+        heap_sift_down(s, jet->heap_idx); // Increase-key (e.g. after refuel)
+    }
+}
+
+bool scheduler_send_command_unsafe(SchedulerState* s, SchedulerJet* jet, AtcCommand command) {
+    bool sent;
+    AtcCommandMessage cmd = { command };
+    if (s->command_hook) sent = s->command_hook(s->command_hook_ctx, jet, command);
+    else if (jet->shm) sent = shm_ring_send(&jet->shm->to_jet, jet->atc_write_fd, &cmd, sizeof(cmd));
+    else sent = write(jet->atc_write_fd, &cmd, sizeof(cmd)) != -1;
+    session_decision(SREC_COMMAND, command, jet->pid, sent ? 1 : 0);
+    return sent;
+}
+
+JetQueue* scheduler_get_queue(SchedulerState* s, int q) {
+    if (q == 1) return &s->queue1;
+    if (q == 2) return &s->queue2;
+    if (q == 3) return &s->queue3;
+    if (q == REFUEL_QUEUE) return &s->refuel_queue;
     return NULL;
 }
 
-bool scheduler_move_jet_unsafe(SchedulerState* s, int from_q, int from_idx, int to_q, FILE* log_file) {
-    SchedulerJet* from_queue_arr[] = { s->queue1, s->queue2, s->queue3 };
-    SchedulerJet* to_queue_arr[] = { s->queue1, s->queue2, s->queue3 };
-    int* from_count[] = { &s->q1_count, &s->q2_count, &s->q3_count };
-    int* to_count[] = { &s->q1_count, &s->q2_count, &s->q3_count };
+SchedulerJet* scheduler_find_jet_unsafe(SchedulerState* s, pid_t pid, int* out_q) {
+    SchedulerJet* jet = index_lookup(&s->index, pid);
+    if (jet && out_q) *out_q = jet->queue;
+    return jet;
+}
 
-    SchedulerJet* jet_to_move = &from_queue_arr[from_q - 1][from_idx];
-    pid_t pid = jet_to_move->pid;
-    
-    int to_slot = find_empty_slot(to_queue_arr[to_q - 1]);
-    if (to_slot == -1) {
-        log_scheduler_event(log_file, "[Scheduler]: ERROR: Queue %d is full. Cannot move jet %d.\n", to_q, pid);
+// Internal move: callers inside the scheduler publish the radar once they are done
+static bool move_jet(SchedulerState* s, SchedulerJet* jet, int to_q, FILE* log_file) {
+    int from_q = jet->queue;
+    JetQueue* to_queue = scheduler_get_queue(s, to_q);
+    if (to_queue == NULL) {
+        log_scheduler_event(log_file, "[Scheduler]: ERROR: Queue %d does not exist. Cannot move jet %d.\n", to_q, jet->pid);
         return false;
     }
 
-    // Use memcpy to move all data, including new stats
-    memcpy(&to_queue_arr[to_q - 1][to_slot], jet_to_move, sizeof(SchedulerJet));
-    memset(jet_to_move, 0, sizeof(SchedulerJet));
-    
-    (*from_count[from_q - 1])--;
-    (*to_count[to_q - 1])++;
+    queue_unlink(scheduler_get_queue(s, from_q), jet);
+    queue_push_back(to_queue, jet);
+    jet->queue = to_q;
+    mark_queued(s, jet);
+    if (to_q == 1) jet->q1_seq = s->q1_seq_counter++;
     
     // IMPORTANT: Reset status and timer when moving
-    to_queue_arr[to_q - 1][to_slot].status = (to_q == 3) ? jet_to_move->status : STATUS_IN_QUEUE; // Preserve refuel status if moving to Q3
-    if (to_q != 3) to_queue_arr[to_q - 1][to_slot].status = STATUS_IN_QUEUE; // Always reset when promoting
-    
-    to_queue_arr[to_q - 1][to_slot].time_in_q3 = 0; // Reset Q3 timer
-    to_queue_arr[to_q - 1][to_slot].time_on_runway = 0;
+    bool refuel_q = (to_q == 3 || to_q == REFUEL_QUEUE);
+    if (!refuel_q || jet->status != STATUS_WAITING_FUEL) {
+        jet->status = STATUS_IN_QUEUE; // Preserve refuel status if moving to Q3 or a bay queue
+    }
+    q1_heap_sync(s, jet);
     
-    log_scheduler_event(log_file, "[Scheduler]: Jet %d moved from Q%d to Q%d.\n", pid, from_q, to_q);
+    log_scheduler_event(log_file, "[Scheduler]: Jet %d moved from Q%d to Q%d.\n", jet->pid, from_q, to_q);
+    record_decision(JEV_MOVE, jet->pid, from_q, to_q, jet->fuel);
+    request_dispatch(s);
     return true;
 }
 
-static void scheduler_preempt_runway_unsafe(SchedulerState* s, FILE* log_file) {
-    if (!s->is_runway_busy) return;
+bool scheduler_move_jet_unsafe(SchedulerState* s, SchedulerJet* jet, int to_q, FILE* log_file) {
+    bool moved = move_jet(s, jet, to_q, log_file);
+    scheduler_publish_radar_unsafe(s);
+    return moved;
+}
+
+// --- NEW: Runway bookkeeping ---
+static int runway_find_free(SchedulerState* s) {
+    for (int r = 0; r < s->runway_count; r++) {
+        if (!s->runways[r].busy) return r;
+    }
+    return -1;
+}
+
+static void runway_assign(SchedulerState* s, int r, SchedulerJet* jet, int from_q, AtcCommand command) {
+    Runway* rw = &s->runways[r];
+    rw->busy = true;
+    rw->jet_pid = jet->pid;
+    rw->jet_q = from_q;
+    rw->landing = (command == CMD_START_LANDING);
+    rw->dispatches++;
+    jet->runway = r;
+    s->runways_busy++;
+    s->runway_dispatches++;
+
+    uint64_t now = scheduler_now_ns();
+    rw->busy_since_ns = now;
+    if (jet->first_run_ns == 0) jet->first_run_ns = now; // Response time
+    jet->dispatched_from = from_q;
+    if (jet->emergency_ns != 0) { // --- NEW: Emergency-to-runway latency
+        jet->emergency_latency_ns = (int64_t)(now - jet->emergency_ns);
+        jet->emergency_ns = 0;
+    }
+
+    // --- NEW: Idle gap, from whichever came last: the runway freeing up or the jet queueing ---
+    uint64_t since = (rw->idle_since_ns > jet->queued_ns) ? rw->idle_since_ns : jet->queued_ns;
+    uint64_t gap = (now > since) ? now - since : 0;
+    s->runway_idle_gap_ns += gap;
+    if (gap > s->runway_idle_gap_max_ns) s->runway_idle_gap_max_ns = gap;
+
+    if (jet->queued_ns != 0) s->runway_queue_delay_ns += now - jet->queued_ns;
+    wait_end(s, jet, now);
+
+    // --- MODIFIED: RR quantum expiry, for the dispatches the policy gives one (MLFQ: Q2).
+    // A landing cannot be called back, so it never gets one ---
+    if (SchedulerPolicy::on_dispatch(s, jet, from_q) && !rw->landing) {
+        timer_wheel_arm(&s->timers, &rw->quantum_timer, now + (uint64_t)s->q2_quantum_ms * NS_PER_MS, now);
+    }
+}
+
+static void runway_release(SchedulerState* s, int r) {
+    Runway* rw = &s->runways[r];
+    if (!rw->busy) return;
+    SchedulerJet* jet = scheduler_find_jet_unsafe(s, rw->jet_pid, NULL);
+    if (jet && jet->runway == r) jet->runway = -1;
+    rw->busy = false;
+    rw->jet_pid = 0;
+    rw->jet_q = 0;
+    rw->landing = false;
+    timer_wheel_cancel(&s->timers, &rw->quantum_timer);
+    uint64_t now = scheduler_now_ns();
+    rw->busy_ns += now - rw->busy_since_ns;
+    s->total_runway_busy_ns += now - rw->busy_since_ns;
+    rw->idle_since_ns = now;
+    s->runways_busy--;
+    request_dispatch(s);
+}
+
+// --- NEW: Refuel bay bookkeeping (same shape as the runways) ---
+static int bay_find_free(SchedulerState* s) {
+    for (int b = 0; b < s->bay_count; b++) {
+        if (!s->bays[b].busy) return b;
+    }
+    return -1;
+}
+
+static void bay_assign(SchedulerState* s, int b, SchedulerJet* jet) {
+    RefuelBay* bay = &s->bays[b];
+    bay->busy = true;
+    bay->jet_pid = jet->pid;
+    bay->dispatches++;
+    jet->bay = b;
+    s->bays_busy++;
+    s->bay_dispatches++;
+
+    uint64_t now = scheduler_now_ns();
+    bay->busy_since_ns = now;
+    if (jet->queued_ns != 0) s->bay_queue_delay_ns += now - jet->queued_ns;
+    wait_end(s, jet, now);
+}
+
+static void bay_release(SchedulerState* s, int b) {
+    RefuelBay* bay = &s->bays[b];
+    if (!bay->busy) return;
+    SchedulerJet* jet = scheduler_find_jet_unsafe(s, bay->jet_pid, NULL);
+    if (jet && jet->bay == b) jet->bay = -1;
+    bay->busy = false;
+    bay->jet_pid = 0;
+    uint64_t now = scheduler_now_ns();
+    bay->busy_ns += now - bay->busy_since_ns;
+    s->total_bay_busy_ns += now - bay->busy_since_ns;
+    s->bays_busy--;
+    request_dispatch(s);
+}
+
+static void scheduler_preempt_runway_unsafe(SchedulerState* s, int r, FILE* log_file) {
+    if (!s->runways[r].busy) return;
     
-    pid_t pid = s->runway_jet_pid;
+    pid_t pid = s->runways[r].jet_pid;
     log_scheduler_event(log_file, "[Scheduler]: PREEMPTING runway jet %d!\n", pid);
+    record_decision(JEV_PREEMPT, pid, s->runways[r].jet_q, 0, 0, r);
     
-    SchedulerJet* jet = scheduler_find_jet_unsafe(s, pid, NULL, NULL);
+    SchedulerJet* jet = scheduler_find_jet_unsafe(s, pid, NULL);
+    runway_release(s, r);
+
     if (jet) {
         jet->status = STATUS_IN_QUEUE;
-        jet->time_on_runway = 0;
+        mark_queued(s, jet);
+        q1_heap_sync(s, jet); // A preempted emergency jet is ready again
     }
-    
-    s->is_runway_busy = false;
-    s->runway_jet_pid = 0;
-    s->runway_jet_q = 0;
 
     s->total_context_switches++; // Count preemption as a context switch
+    metrics_inc(MET_CONTEXT_SWITCHES);
+}
+
+
+// --- NEW: Scheduling policies ---
+
+// Waiting for a runway to land or refuel on, holding nothing (not in the bay queue)
+static inline bool waiting_for_runway(const SchedulerJet* jet) {
+    return jet->queue >= 1 && jet->queue <= 3 && jet->runway < 0 && jet->bay < 0 &&
+           (jet->status == STATUS_IN_QUEUE || jet->status == STATUS_WAITING_FUEL);
+}
+
+// -- MLFQ --
+
+inline int MlfqPolicy::on_arrival(SchedulerState* s, SchedulerJet* jet) {
+    (void)s; (void)jet;
+    return 2;
+}
+
+inline bool MlfqPolicy::ready(const SchedulerJet* jet) {
+    return jet->queue == 1 && jet->status == STATUS_IN_QUEUE && jet->runway < 0 && jet->bay < 0;
+}
+
+// Lower fuel runs first; ties go to whichever jet entered Q1 first
+inline bool MlfqPolicy::before(const SchedulerJet* a, const SchedulerJet* b) {
+    if (a->fuel != b->fuel) return a->fuel < b->fuel;
+    return a->q1_seq < b->q1_seq;
+}
+
+// Q1 by least fuel, then Q2 in order (promoted refuel requests first). Q3 is standby/aging only.
+// With refuel bays no jet waits to refuel in Q2, so that scan is skipped on the count.
+inline SchedulerJet* MlfqPolicy::select_next(SchedulerState* s) {
+    if (s->q1_heap_size > 0) return s->q1_heap[0];
+    if (s->q2_waiting_fuel > 0) {
+        for (SchedulerJet* j = s->queue2.head; j != NULL; j = j->next) {
+            if (j->status == STATUS_WAITING_FUEL) return j;
+        }
+    }
+    for (SchedulerJet* j = s->queue2.head; j != NULL; j = j->next) {
+        if (j->status == STATUS_IN_QUEUE) return j;
+    }
+    return NULL;
+}
+
+inline bool MlfqPolicy::on_dispatch(SchedulerState* s, SchedulerJet* jet, int from_q) {
+    (void)s; (void)jet;
+    return from_q == 2;
+}
+
+inline bool MlfqPolicy::ages(const SchedulerJet* jet) {
+    return jet->queue == 3;
+}
+
+// Q3 -> Q2 once it has waited aging_ms
+inline void MlfqPolicy::on_tick_aging(SchedulerState* s, SchedulerJet* jet, FILE* log_file) {
+    if (jet->status != STATUS_IN_QUEUE && jet->status != STATUS_WAITING_FUEL) return;
+    log_scheduler_event(log_file, "[Scheduler]: AGING Jet %d from Q3 to Q2.\n", jet->pid);
+    record_decision(JEV_AGING, jet->pid, 3, 2, jet->fuel);
+    JetStatus old_status = jet->status;
+    if (move_jet(s, jet, 2, log_file)) {
+        jet->status = old_status;
+        q1_heap_sync(s, jet);
+    }
+}
+
+// RR demotion: Q2 -> Q3
+inline void MlfqPolicy::on_tick_quantum(SchedulerState* s, SchedulerJet* jet, int r, FILE* log_file) {
+    log_scheduler_event(log_file, "[Scheduler]: RR QUANTUM expired for Jet %d. Demoting to Q3.\n", jet->pid);
+    record_decision(JEV_RR_EXPIRED, jet->pid, 2, 3, jet->fuel, r);
+
+    runway_release(s, r);
+    s->total_context_switches++; // Count RR demotion as context switch
+    metrics_inc(MET_CONTEXT_SWITCHES);
+
+    move_jet(s, jet, 3, log_file);
+}
+
+inline void MlfqPolicy::on_feedback(SchedulerState* s, SchedulerJet* jet) {
+    if (jet->heap_idx >= 0) q1_heap_sync(s, jet);
+}
+
+// --- MODIFIED: Preempt only when every runway is taken, and pick the runway ---
+// A non-emergency jet is preempted before an emergency one; among those,
+// the one with the most fuel (it can best afford to wait).
+inline int MlfqPolicy::should_preempt(SchedulerState* s, SchedulerJet* jet, FILE* log_file) {
+    int victim = -1;
+    SchedulerJet* running_jet = NULL;
+    for (int r = 0; r < s->runway_count; r++) {
+        if (s->runways[r].landing) continue; // Cannot be called back
+        SchedulerJet* rj = scheduler_find_jet_unsafe(s, s->runways[r].jet_pid, NULL);
+        if (!rj) continue;
+        if (running_jet != NULL) {
+            bool rj_emergency = (s->runways[r].jet_q == 1);
+            bool best_emergency = (s->runways[victim].jet_q == 1);
+            bool better = (rj_emergency != best_emergency) ? !rj_emergency : rj->fuel > running_jet->fuel;
+            if (!better) continue;
+        }
+        victim = r;
+        running_jet = rj;
+    }
+    if (!running_jet) return -1;
+
+    if (s->runways[victim].jet_q == 1) {
+        if (jet->fuel >= running_jet->fuel) return -1;
+        log_scheduler_event(log_file, "[Scheduler]: New emergency Jet %d (fuel %d) preempting running Jet %d (fuel %d).\n",
+             jet->pid, jet->fuel, running_jet->pid, running_jet->fuel);
+        record_decision(JEV_EMERGENCY_PREEMPT, jet->pid, 0, 0, jet->fuel, victim, running_jet->pid, running_jet->fuel);
+    } else {
+        log_scheduler_event(log_file, "[Scheduler]: Emergency Jet %d preempting non-emergency Jet %d.\n",
+             jet->pid, running_jet->pid);
+        record_decision(JEV_EMERGENCY_PREEMPT, jet->pid, 0, 0, jet->fuel, victim, running_jet->pid, -1);
+    }
+    return victim;
+}
+
+// -- EDF on fuel --
+
+inline int EdfPolicy::on_arrival(SchedulerState* s, SchedulerJet* jet) {
+    (void)s; (void)jet;
+    return 2;
+}
+
+inline bool EdfPolicy::ready(const SchedulerJet* jet) {
+    return waiting_for_runway(jet);
+}
+
+// Least fuel is the earliest deadline; ties in arrival (or Q1 entry) order
+inline bool EdfPolicy::before(const SchedulerJet* a, const SchedulerJet* b) {
+    if (a->fuel != b->fuel) return a->fuel < b->fuel;
+    return a->q1_seq < b->q1_seq;
+}
+
+inline SchedulerJet* EdfPolicy::select_next(SchedulerState* s) {
+    return (s->q1_heap_size > 0) ? s->q1_heap[0] : NULL;
+}
+
+inline bool EdfPolicy::on_dispatch(SchedulerState* s, SchedulerJet* jet, int from_q) {
+    (void)s; (void)jet; (void)from_q;
+    return false; // Runs to completion
+}
+
+inline bool EdfPolicy::ages(const SchedulerJet* jet) {
+    (void)jet;
+    return false;
+}
+
+inline void EdfPolicy::on_tick_aging(SchedulerState* s, SchedulerJet* jet, FILE* log_file) {
+    (void)s; (void)jet; (void)log_file; // No aging timers are armed
+}
+
+inline void EdfPolicy::on_tick_quantum(SchedulerState* s, SchedulerJet* jet, int r, FILE* log_file) {
+    (void)s; (void)jet; (void)r; (void)log_file; // No quantum timers are armed
+}
+
+inline void EdfPolicy::on_feedback(SchedulerState* s, SchedulerJet* jet) {
+    if (jet->heap_idx >= 0) q1_heap_sync(s, jet); // New deadline
+}
+
+// The running jet with the latest deadline, if it is later than the emergency's
+inline int EdfPolicy::should_preempt(SchedulerState* s, SchedulerJet* jet, FILE* log_file) {
+    int victim = -1;
+    SchedulerJet* running_jet = NULL;
+    for (int r = 0; r < s->runway_count; r++) {
+        if (s->runways[r].landing) continue; // Cannot be called back
+        SchedulerJet* rj = scheduler_find_jet_unsafe(s, s->runways[r].jet_pid, NULL);
+        if (!rj || (running_jet != NULL && rj->fuel <= running_jet->fuel)) continue;
+        victim = r;
+        running_jet = rj;
+    }
+    if (!running_jet || running_jet->fuel <= jet->fuel) return -1;
+    log_scheduler_event(log_file, "[Scheduler]: Emergency Jet %d (fuel %d) preempting Jet %d (fuel %d), earlier deadline.\n",
+         jet->pid, jet->fuel, running_jet->pid, running_jet->fuel);
+    record_decision(JEV_EMERGENCY_PREEMPT, jet->pid, 0, 0, jet->fuel, victim, running_jet->pid, running_jet->fuel);
+    return victim;
+}
+
+// -- Stride --
+
+// Less fuel, more tickets, a shorter stride
+static inline uint64_t stride_of(const SchedulerJet* jet) {
+    int tickets = 1 + (jet->fuel < STRIDE_FUEL_CAP ? STRIDE_FUEL_CAP - jet->fuel : 0);
+    return STRIDE_ONE / (uint64_t)tickets;
+}
+
+// Joins at the current pass, so it neither jumps the line nor waits for everyone's history
+inline int StridePolicy::on_arrival(SchedulerState* s, SchedulerJet* jet) {
+    jet->pass = s->stride_pass;
+    return 2;
+}
+
+inline bool StridePolicy::ready(const SchedulerJet* jet) {
+    return waiting_for_runway(jet);
+}
+
+inline bool StridePolicy::before(const SchedulerJet* a, const SchedulerJet* b) {
+    bool a_emergency = (a->queue == 1), b_emergency = (b->queue == 1);
+    if (a_emergency != b_emergency) return a_emergency;
+    if (a->pass != b->pass) return a->pass < b->pass;
+    return a->q1_seq < b->q1_seq;
+}
+
+inline SchedulerJet* StridePolicy::select_next(SchedulerState* s) {
+    return (s->q1_heap_size > 0) ? s->q1_heap[0] : NULL;
+}
+
+// Charges one grant to the jet's pass; the grant runs to completion
+inline bool StridePolicy::on_dispatch(SchedulerState* s, SchedulerJet* jet, int from_q) {
+    (void)from_q;
+    if (jet->pass > s->stride_pass) s->stride_pass = jet->pass;
+    jet->pass += stride_of(jet);
+    return false;
+}
+
+inline bool StridePolicy::ages(const SchedulerJet* jet) {
+    (void)jet;
+    return false; // Passes catch up on their own
+}
+
+inline void StridePolicy::on_tick_aging(SchedulerState* s, SchedulerJet* jet, FILE* log_file) {
+    (void)s; (void)jet; (void)log_file; // No aging timers are armed
+}
+
+inline void StridePolicy::on_tick_quantum(SchedulerState* s, SchedulerJet* jet, int r, FILE* log_file) {
+    (void)s; (void)jet; (void)r; (void)log_file; // No quantum timers are armed
+}
+
+inline void StridePolicy::on_feedback(SchedulerState* s, SchedulerJet* jet) {
+    (void)s; (void)jet; // Fuel only sets the next stride, charged at dispatch
+}
+
+// An emergency takes the runway of the non-emergency jet furthest ahead in pass
+inline int StridePolicy::should_preempt(SchedulerState* s, SchedulerJet* jet, FILE* log_file) {
+    int victim = -1;
+    SchedulerJet* running_jet = NULL;
+    for (int r = 0; r < s->runway_count; r++) {
+        if (s->runways[r].jet_q == 1 || s->runways[r].landing) continue;
+        SchedulerJet* rj = scheduler_find_jet_unsafe(s, s->runways[r].jet_pid, NULL);
+        if (!rj || (running_jet != NULL && rj->pass <= running_jet->pass)) continue;
+        victim = r;
+        running_jet = rj;
+    }
+    if (!running_jet) return -1;
+    log_scheduler_event(log_file, "[Scheduler]: Emergency Jet %d preempting non-emergency Jet %d.\n",
+         jet->pid, running_jet->pid);
+    record_decision(JEV_EMERGENCY_PREEMPT, jet->pid, 0, 0, jet->fuel, victim, running_jet->pid, -1);
+    return victim;
 }
 
 
 // --- Public Functions ---
 
 void scheduler_init(SchedulerState* s) {
-    memset(s->queue1, 0, sizeof(SchedulerJet) * MAX_JETS);
-    memset(s->queue2, 0, sizeof(SchedulerJet) * MAX_JETS);
-    memset(s->queue3, 0, sizeof(SchedulerJet) * MAX_JETS);
+    memset(&s->queue1, 0, sizeof(JetQueue));
+    memset(&s->queue2, 0, sizeof(JetQueue));
+    memset(&s->queue3, 0, sizeof(JetQueue));
+    memset(&s->refuel_queue, 0, sizeof(JetQueue));
+
+    s->slabs = NULL;
+    s->free_list = NULL;
+    s->slab_count = 0;
+
+    s->q1_heap = NULL;
+    s->q1_heap_size = 0;
+    s->q1_seq_counter = 0;
+    s->stride_pass = 0;
+    s->q2_waiting_fuel = 0;
+
+    if (!index_init(&s->index, JET_INDEX_INITIAL_CAPACITY)) {
+        perror("Scheduler: Failed to allocate jet index");
+        exit(1);
+    }
 
-    s->q1_count = 0;
-    s->q2_count = 0;
-    s->q3_count = 0;
+    s->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (s->epoll_fd == -1) {
+        perror("Scheduler: Failed to create epoll instance");
+        exit(1);
+    }
     
-    s->is_runway_busy = false;
-    s->runway_jet_pid = 0;
-    s->runway_jet_q = 0;
+    memset(s->runways, 0, sizeof(s->runways));
+    for (int r = 0; r < MAX_RUNWAYS; r++) timer_entry_init(&s->runways[r].quantum_timer, TIMER_QUANTUM);
+    timer_wheel_init(&s->timers, scheduler_now_ns());
+    s->runway_count = DEFAULT_RUNWAYS;
+    s->runways_busy = 0;
+
+    memset(s->bays, 0, sizeof(s->bays));
+    s->bay_count = DEFAULT_REFUEL_BAYS;
+    s->bays_busy = 0;
 
-    s->q2_rr_quantum = RR_QUANTUM;
+    s->command_hook = NULL;
+    s->command_hook_ctx = NULL;
+
+    s->q2_quantum_ms = RR_QUANTUM_MS;
+    s->aging_ms = AGING_THRESHOLD_MS;
+    s->tick_ms = TICK_PERIOD_MS;
     s->is_paused = false;
+    s->sector = -1;
+    s->dispatch_fd = -1;
+    s->dispatch_pending = false;
 
     // --- NEW: Init stats ---
     s->total_context_switches = 0;
-    s->total_runway_busy_time = 0;
+    s->total_runway_busy_ns = 0;
+    s->total_bay_busy_ns = 0;
+    s->runway_queue_delay_ns = 0;
+    s->bay_queue_delay_ns = 0;
+    s->runway_dispatches = 0;
+    s->bay_dispatches = 0;
+    s->runway_idle_gap_ns = 0;
+    s->runway_idle_gap_max_ns = 0;
 
     if (pthread_mutex_init(&s->lock, NULL) != 0) {
         perror("Scheduler: Failed to initialize mutex");
         exit(1);
     }
+
+    s->radar_seq = 0;
+    scheduler_publish_radar_unsafe(s);
+}
+
+void scheduler_set_quantum_ms(SchedulerState* s, int quantum_ms) {
+    s->q2_quantum_ms = (quantum_ms < 1) ? 1 : quantum_ms;
+    // Jets already on a runway expire against the new quantum, as before
+    for (int r = 0; r < s->runway_count; r++) {
+        Runway* rw = &s->runways[r];
+        if (!rw->quantum_timer.armed) continue;
+        timer_wheel_arm(&s->timers, &rw->quantum_timer,
+                        rw->busy_since_ns + (uint64_t)s->q2_quantum_ms * NS_PER_MS, scheduler_now_ns());
+    }
+    scheduler_publish_radar_unsafe(s);
+}
+
+void scheduler_set_aging_ms(SchedulerState* s, int aging_ms) {
+    s->aging_ms = (aging_ms < 1) ? 1 : aging_ms;
+    for (SchedulerJet* jet = s->queue3.head; jet != NULL; jet = jet->next) aging_timer_sync(s, jet);
+}
+
+void scheduler_set_tick_ms(SchedulerState* s, int tick_ms) {
+    s->tick_ms = (tick_ms < 1) ? 1 : tick_ms;
+}
+
+uint64_t scheduler_runway_busy_ns_unsafe(const SchedulerState* s, int r) {
+    const Runway* rw = &s->runways[r];
+    return rw->busy_ns + (rw->busy ? scheduler_now_ns() - rw->busy_since_ns : 0);
+}
+
+uint64_t scheduler_bay_busy_ns_unsafe(const SchedulerState* s, int b) {
+    const RefuelBay* bay = &s->bays[b];
+    return bay->busy_ns + (bay->busy ? scheduler_now_ns() - bay->busy_since_ns : 0);
+}
+
+void scheduler_set_runway_count(SchedulerState* s, int count) {
+    if (count < 1) count = 1;
+    if (count > MAX_RUNWAYS) count = MAX_RUNWAYS;
+    s->runway_count = count;
+    scheduler_publish_radar_unsafe(s);
+}
+
+void scheduler_set_refuel_bays(SchedulerState* s, int count) {
+    if (count < 0) count = 0;
+    if (count > MAX_REFUEL_BAYS) count = MAX_REFUEL_BAYS;
+    s->bay_count = count;
+    scheduler_publish_radar_unsafe(s);
 }
 
 void scheduler_destroy(SchedulerState* s) {
+    while (s->slabs) {
+        JetSlab* next = s->slabs->next;
+        free(s->slabs);
+        s->slabs = next;
+    }
+    s->free_list = NULL;
+    s->slab_count = 0;
+    close(s->epoll_fd);
+    s->epoll_fd = -1;
+    if (s->dispatch_fd >= 0) close(s->dispatch_fd);
+    s->dispatch_fd = -1;
+    free(s->q1_heap);
+    s->q1_heap = NULL;
+    s->q1_heap_size = 0;
+    free(s->index.slots);
+    s->index.slots = NULL;
+    s->index.capacity = s->index.size = 0;
     pthread_mutex_destroy(&s->lock);
 }
 
 void scheduler_add_jet(SchedulerState* s, pid_t pid, int read_fd, int write_fd, int fuel, FILE* log_file) {
+    scheduler_add_shm_jet(s, pid, read_fd, write_fd, NULL, fuel, log_file);
+}
+
+void scheduler_add_shm_jet(SchedulerState* s, pid_t pid, int read_fd, int write_fd, ShmChannel* shm, int fuel, FILE* log_file) {
     pthread_mutex_lock(&s->lock);
+    session_input(SREC_ARRIVAL, pid, 0, fuel);
 
-    int slot = find_empty_slot(s->queue2);
+    SchedulerJet* jet = pool_alloc(s);
+    if (jet != NULL && !index_insert(&s->index, pid, jet)) {
+        pool_free(s, jet);
+        jet = NULL;
+    }
     
-    if (slot != -1) {
-        s->queue2[slot].pid = pid;
-        s->queue2[slot].atc_read_fd = read_fd;
-        s->queue2[slot].atc_write_fd = write_fd;
-        s->queue2[slot].fuel = fuel;
-        s->queue2[slot].status = STATUS_IN_QUEUE;
-        s->queue2[slot].time_on_runway = 0;
-        s->queue2[slot].time_in_q3 = 0;
+    if (jet != NULL) {
+        jet->pid = pid;
+        jet->atc_read_fd = read_fd;
+        jet->atc_write_fd = write_fd;
+        jet->shm = shm;
+        jet->fuel = fuel;
+        jet->status = STATUS_IN_QUEUE;
+        jet->runway = -1;
+        jet->bay = -1;
         
         // --- NEW: Init stats for jet ---
-        s->queue2[slot].arrival_time = time(NULL);
-        s->queue2[slot].first_run_time = 0; // 0 indicates not run yet
-        s->queue2[slot].total_wait_time = 0;
+        jet->arrival_ns = scheduler_now_ns();
+        jet->queued_ns = jet->arrival_ns;
+        jet->first_run_ns = 0; // 0 indicates not run yet
+        jet->total_wait_ns = 0;
+        jet->emergency_ns = 0;
+        jet->emergency_latency_ns = -1;
+
+        if (read_fd >= 0) {
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.ptr = jet;
+            if (epoll_ctl(s->epoll_fd, EPOLL_CTL_ADD, read_fd, &ev) == -1) {
+                log_scheduler_event(log_file, "[Scheduler]: ERROR: Could not watch feedback pipe of jet %d.\n", pid);
+            }
+        }
 
-        s->q2_count++;
-        log_scheduler_event(log_file, "[Scheduler]: Jet %d added to Q2. (Fuel: %d)\n", pid, fuel);
+        // --- MODIFIED: The policy picks the queue (MLFQ: Q2) ---
+        jet->q1_seq = s->q1_seq_counter++; // Arrival order, for policies that order all jets
+        jet->queue = SchedulerPolicy::on_arrival(s, jet);
+        queue_push_back(scheduler_get_queue(s, jet->queue), jet);
+        q1_heap_sync(s, jet);
+        log_scheduler_event(log_file, "[Scheduler]: Jet %d added to Q%d. (Fuel: %d)\n", pid, jet->queue, fuel);
+        record_decision(JEV_ARRIVAL, pid, 0, jet->queue, fuel);
+        request_dispatch(s);
     } else {
-        log_scheduler_event(log_file, "[Scheduler]: ERROR: Q2 is full. Jet %d rejected.\n", pid);
+        log_scheduler_event(log_file, "[Scheduler]: ERROR: Out of memory. Jet %d rejected.\n", pid);
         close(read_fd);
         close(write_fd);
+        if (shm) shm_channel_unmap(shm);
     }
 
+    scheduler_publish_radar_unsafe(s);
     pthread_mutex_unlock(&s->lock);
 }
 
-// --- MODIFIED: Reverted - 2 arguments, console print is back on
+// --- NEW: Radar snapshot (seqlock) ---
+
+// Copies up to RADAR_MAX_LISTED jets of a queue
+static void radar_list_queue(RadarQueue* rq, const JetQueue* q, uint64_t now) {
+    rq->count = q->count;
+    rq->listed = 0;
+    for (SchedulerJet* jet = q->head; jet != NULL && rq->listed < RADAR_MAX_LISTED; jet = jet->next) {
+        RadarJet* rj = &rq->jets[rq->listed++];
+        rj->pid = jet->pid;
+        rj->fuel = jet->fuel;
+        rj->wait_ms = jet->queued_ns ? (int)((now - jet->queued_ns) / NS_PER_MS) : 0;
+        rj->status = jet->status;
+        rj->refueling = (jet->bay >= 0);
+    }
+}
+
+void scheduler_publish_radar_unsafe(SchedulerState* s) {
+    // Sectors looking for a victim read this without our lock
+    __atomic_store_n(&s->backlog, s->queue2.count + s->queue3.count, __ATOMIC_RELAXED);
+
+    // Odd sequence: readers that overlap this publish retry
+    unsigned seq = s->radar_seq;
+    __atomic_store_n(&s->radar_seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    RadarSnapshot* r = &s->radar;
+    r->paused = s->is_paused;
+    r->sector = s->sector;
+    r->q2_quantum_ms = s->q2_quantum_ms;
+    r->runway_count = s->runway_count;
+    r->runways_busy = s->runways_busy;
+    memcpy(r->runways, s->runways, sizeof(Runway) * s->runway_count);
+    r->bay_count = s->bay_count;
+    r->bays_busy = s->bays_busy;
+    memcpy(r->bays, s->bays, sizeof(RefuelBay) * s->bay_count);
+    // Jets in the bay queue minus those already in a bay (O(bays), not O(queue))
+    r->bays_waiting = s->refuel_queue.count;
+    for (int b = 0; b < s->bay_count; b++) {
+        if (!s->bays[b].busy) continue;
+        SchedulerJet* jet = scheduler_find_jet_unsafe(s, s->bays[b].jet_pid, NULL);
+        if (jet && jet->queue == REFUEL_QUEUE) r->bays_waiting--;
+    }
+    uint64_t now = scheduler_now_ns();
+    for (int q = 1; q <= 4; q++) radar_list_queue(&r->queues[q - 1], scheduler_get_queue(s, q), now);
+
+    __atomic_store_n(&s->radar_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+void scheduler_read_radar(SchedulerState* s, RadarSnapshot* out) {
+    unsigned seq;
+    do {
+        seq = __atomic_load_n(&s->radar_seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) continue; // Publish in progress
+        memcpy(out, &s->radar, sizeof(RadarSnapshot));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || __atomic_load_n(&s->radar_seq, __ATOMIC_RELAXED) != seq);
+}
+
+// Bounded append into the display buffer
+static void radar_append(char* buf, size_t cap, size_t* len, const char* format, ...) {
+    if (*len >= cap) return;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf + *len, cap - *len, format, args);
+    va_end(args);
+    if (n > 0) *len += ((size_t)n < cap - *len) ? (size_t)n : cap - *len - 1;
+}
+
+static void radar_append_queue(char* buf, size_t cap, size_t* len, const RadarQueue* rq, int q) {
+    if (rq->count == 0) {
+        radar_append(buf, cap, len, "  [Empty]\n");
+        return;
+    }
+    for (int i = 0; i < rq->listed; i++) {
+        const RadarJet* rj = &rq->jets[i];
+        if (q == 3) {
+            radar_append(buf, cap, len, "  - Jet PID: %d (Wait: %d ms, Status: %d)\n", rj->pid, rj->wait_ms, rj->status);
+        } else {
+            radar_append(buf, cap, len, "  - Jet PID: %d (Fuel: %d%s)\n", rj->pid, rj->fuel,
+                         (q == REFUEL_QUEUE && rj->refueling) ? ", REFUELING" : "");
+        }
+    }
+    if (rq->count > rq->listed) radar_append(buf, cap, len, "  ... and %d more\n", rq->count - rq->listed);
+}
+
+// --- MODIFIED: Renders the radar snapshot into one buffer and writes it
+// with a single write(). s->lock is never taken, so a slow terminal
+// cannot hold up dispatch or feedback.
 void scheduler_print_queues(SchedulerState* s, FILE* log_file) {
-    pthread_mutex_lock(&s->lock);
-    
-    time_t now = time(0);
-    tm *ltm = localtime(&now);
+    RadarSnapshot r;
+    scheduler_read_radar(s, &r);
     
-    char time_str[20];
-    snprintf(time_str, 20, "%02d:%02d:%02d", ltm->tm_hour, ltm->tm_min, ltm->tm_sec);
+    time_t now = scheduler_now();
+    tm ltm;
+    localtime_r(&now, &ltm);
+
+    static const char* RULE = "--------------------------------------------------------\n";
+    char buf[16384];
+    size_t len = 0;
+    const size_t cap = sizeof(buf);
 
     // --- Print to Console ---
-    cout << "\n========================================================" << endl;
-    cout << "           OPERATION SKYWATCH - RADAR DISPLAY" << endl;
-    cout << "           Time: " << time_str << (s->is_paused ? " (PAUSED)" : "") << endl;
-    cout << "--------------------------------------------------------" << endl;
-    
-    if (s->is_runway_busy) {
-        cout << "RUNWAY STATUS: [BUSY - Jet " << s->runway_jet_pid << " (from Q" << s->runway_jet_q << ")]" << endl;
-    } else {
-        cout << "RUNWAY STATUS: [IDLE]" << endl;
+    radar_append(buf, cap, &len, "\n========================================================\n");
+    radar_append(buf, cap, &len, "           OPERATION SKYWATCH - RADAR DISPLAY\n");
+    radar_append(buf, cap, &len, "           Time: %02d:%02d:%02d%s\n", ltm.tm_hour, ltm.tm_min, ltm.tm_sec,
+                 r.paused ? " (PAUSED)" : "");
+    if (r.sector >= 0) radar_append(buf, cap, &len, "           Sector: %d\n", r.sector + 1);
+    radar_append(buf, cap, &len, "%s", RULE);
+
+    for (int i = 0; i < r.runway_count; i++) {
+        const Runway* rw = &r.runways[i];
+        if (r.runway_count == 1) radar_append(buf, cap, &len, "RUNWAY STATUS: ");
+        else radar_append(buf, cap, &len, "RUNWAY %d STATUS: ", i + 1);
+        if (rw->busy) radar_append(buf, cap, &len, "[BUSY - Jet %d (from Q%d)]\n", rw->jet_pid, rw->jet_q);
+        else radar_append(buf, cap, &len, "[IDLE]\n");
     }
-    cout << "--------------------------------------------------------" << endl;
-    
-    cout << "Q1 (SRTF - Emergency): [" << s->q1_count << " jets]" << endl;
-    if (s->q1_count == 0) cout << "  [Empty]" << endl;
-    else {
-        for (int i = 0; i < MAX_JETS; i++)
-            if (s->queue1[i].pid != 0)
-                cout << "  - Jet PID: " << s->queue1[i].pid << " (Fuel: " << s->queue1[i].fuel << ")" << endl;
+    for (int b = 0; b < r.bay_count; b++) {
+        const RefuelBay* bay = &r.bays[b];
+        if (bay->busy) radar_append(buf, cap, &len, "REFUEL BAY %d:    [BUSY - Jet %d]\n", b + 1, bay->jet_pid);
+        else radar_append(buf, cap, &len, "REFUEL BAY %d:    [IDLE]\n", b + 1);
     }
+    radar_append(buf, cap, &len, "%s", RULE);
 
-    cout << "Q2 (RR - Q=" << s->q2_rr_quantum << "):    [" << s->q2_count << " jets]" << endl;
-    if (s->q2_count == 0) cout << "  [Empty]" << endl;
-    else {
-        for (int i = 0; i < MAX_JETS; i++)
-            if (s->queue2[i].pid != 0)
-                cout << "  - Jet PID: " << s->queue2[i].pid << " (Fuel: " << s->queue2[i].fuel << ")" << endl;
+    radar_append(buf, cap, &len, "Q1 (SRTF - Emergency): [%d jets]\n", r.queues[0].count);
+    radar_append_queue(buf, cap, &len, &r.queues[0], 1);
+    radar_append(buf, cap, &len, "Q2 (RR - Q=%d ms):    [%d jets]\n", r.q2_quantum_ms, r.queues[1].count);
+    radar_append_queue(buf, cap, &len, &r.queues[1], 2);
+    radar_append(buf, cap, &len, "Q3 (FCFS - Standby):   [%d jets]\n", r.queues[2].count);
+    radar_append_queue(buf, cap, &len, &r.queues[2], 3);
+    if (r.bay_count > 0) {
+        radar_append(buf, cap, &len, "Refuel Queue (FCFS):   [%d jets]\n", r.queues[3].count);
+        radar_append_queue(buf, cap, &len, &r.queues[3], REFUEL_QUEUE);
     }
-    
-    cout << "Q3 (FCFS - Standby):   [" << s->q3_count << " jets]" << endl;
-    if (s->q3_count == 0) cout << "  [Empty]" << endl;
-    else {
-        for (int i = 0; i < MAX_JETS; i++)
-            if (s->queue3[i].pid != 0) {
-                cout << "  - Jet PID: " << s->queue3[i].pid 
-                     << " (Wait: " << s->queue3[i].time_in_q3 << "s"
-                     << ", Status: " << s->queue3[i].status << ")" << endl;
-            }
+    radar_append(buf, cap, &len, "========================================================\n");
+
+    size_t off = 0;
+    while (off < len) {
+        ssize_t n = write(STDOUT_FILENO, buf + off, len - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        off += (size_t)n;
     }
-    cout << "========================================================" << endl;
 
 
     // --- Log to File (a snapshot) ---
-    log_scheduler_event(log_file, "[Status]: Q1=%d, Q2=%d, Q3=%d, Runway=%s (Jet %d)\n",
-        s->q1_count, s->q2_count, s->q3_count,
-        s->is_runway_busy ? "BUSY" : "IDLE",
-        s->is_runway_busy ? s->runway_jet_pid : 0);
-
-    pthread_mutex_unlock(&s->lock);
+    if (r.runway_count == 1) {
+        log_scheduler_event(log_file, "[Status]: Q1=%d, Q2=%d, Q3=%d, Runway=%s (Jet %d)\n",
+            r.queues[0].count, r.queues[1].count, r.queues[2].count,
+            r.runways[0].busy ? "BUSY" : "IDLE", r.runways[0].jet_pid);
+    } else {
+        log_scheduler_event(log_file, "[Status]: Q1=%d, Q2=%d, Q3=%d, Runways=%d/%d BUSY\n",
+            r.queues[0].count, r.queues[1].count, r.queues[2].count, r.runways_busy, r.runway_count);
+    }
+    if (r.bay_count > 0) {
+        log_scheduler_event(log_file, "[Status]: Refuel Bays=%d/%d BUSY, %d waiting\n",
+            r.bays_busy, r.bay_count, r.bays_waiting);
+    }
 }
 
 
-void scheduler_tick(SchedulerState* s, FILE* log_file) {
-    pthread_mutex_lock(&s->lock);
-    
-    if (s->is_paused) {
-        pthread_mutex_unlock(&s->lock);
-        return;
-    }
+// A command could not be sent: try again on the next tick, not in a busy loop
+static inline void retry_dispatch(SchedulerState* s) {
+    s->dispatch_pending = true;
+}
 
-    // --- 1. UPDATE STATS (Wait Time, Runway Time) ---
-    if (s->is_runway_busy) {
-        s->total_runway_busy_time++;
-    }
+// --- NEW: Dispatch on its own, for scheduler_tick and event wakeups ---
+static void dispatch_unsafe(SchedulerState* s, FILE* log_file) {
+    s->dispatch_pending = false;
 
-    SchedulerJet* queues[] = { s->queue1, s->queue2, s->queue3 };
-    for (int q = 0; q < 3; q++) {
-        for (int i = 0; i < MAX_JETS; i++) {
-            SchedulerJet* jet = &queues[q][i];
-            // Increment wait time if in any queue and not currently landing/refueling
-            if (jet->pid != 0 && (jet->status == STATUS_IN_QUEUE || jet->status == STATUS_WAITING_FUEL)) {
-                jet->total_wait_time++; // Increment wait time if in queue
-            }
+    // --- 1. RUNWAYS (fill every free runway) ---
+    // --- MODIFIED: The policy picks the jet (MLFQ: Q1 by SRTF, then Q2 RR) ---
+    int r;
+    while ((r = runway_find_free(s)) >= 0) {
+        SchedulerJet* jet = SchedulerPolicy::select_next(s);
+        if (jet == NULL) break; // Nothing left to dispatch
+        int from_q = jet->queue;
+
+        // 1a. Emergencies (Q1)
+        if (from_q == 1) {
+            if (!scheduler_send_command_unsafe(s, jet, CMD_START_LANDING)) { retry_dispatch(s); break; }
+            runway_assign(s, r, jet, 1, CMD_START_LANDING);
+            jet->status = STATUS_LANDING_CMD; 
+            q1_heap_sync(s, jet);
+            s->total_context_switches++; // Count dispatch
+            metrics_inc(MET_CONTEXT_SWITCHES);
+            log_scheduler_event(log_file, "[Scheduler]: Runway assigned to EMERGENCY Jet %d (from Q1).\n", jet->pid);
+            record_decision(JEV_DISPATCH_EMERGENCY, jet->pid, 1, 0, jet->fuel, r);
+            continue;
         }
-    }
 
+        // 1b. Everyone else (MLFQ: Q2), landing or refueling on the runway
+        AtcCommand cmd;
+        JetStatus old_status = jet->status;
+        if (jet->status == STATUS_WAITING_FUEL) {
+            cmd = CMD_REFUEL;
+            jet->status = STATUS_REFUELING;
+            log_scheduler_event(log_file, "[Scheduler]: Runway assigned to Jet %d for REFUELING (from Q%d).\n", jet->pid, from_q);
+            record_decision(JEV_DISPATCH_REFUEL, jet->pid, from_q, 0, jet->fuel, r);
+        } else {
+            cmd = CMD_START_LANDING;
+            jet->status = STATUS_LANDING_CMD;
+            log_scheduler_event(log_file, "[Scheduler]: Runway assigned to Jet %d for LANDING (from Q%d).\n", jet->pid, from_q);
+            record_decision(JEV_DISPATCH_LANDING, jet->pid, from_q, 0, jet->fuel, r);
+        }
 
-    // --- 2. AGING (Q3 -> Q2) ---
-    for (int i = 0; i < MAX_JETS; i++) {
-        SchedulerJet* jet = &s->queue3[i];
-        
-        if (jet->pid != 0 && (jet->status == STATUS_IN_QUEUE || jet->status == STATUS_WAITING_FUEL)) {
-            jet->time_in_q3++;
-            if (jet->time_in_q3 > AGING_THRESHOLD) {
-                log_scheduler_event(log_file, "[Scheduler]: AGING Jet %d from Q3 to Q2.\n", jet->pid);
-                JetStatus old_status = jet->status;
-                if (scheduler_move_jet_unsafe(s, 3, i, 2, log_file)) {
-                    int q_new, idx_new;
-                    SchedulerJet* jet_in_q2 = scheduler_find_jet_unsafe(s, jet->pid, &q_new, &idx_new);
-                    if (jet_in_q2) {
-                        jet_in_q2->status = old_status; 
-                    }
-                }
-            }
+        if (!scheduler_send_command_unsafe(s, jet, cmd)) {
+            jet->status = old_status; // Still waiting, so the next try picks it again
+            retry_dispatch(s);
+            break;
         }
+        runway_assign(s, r, jet, from_q, cmd);
+        q1_heap_sync(s, jet); // Out of the ready heap, if the policy keeps it there
+        s->total_context_switches++; // Count dispatch
+        metrics_inc(MET_CONTEXT_SWITCHES);
     }
+    
+    // Q3 is standby/aging only. No dispatch from Q3.
 
-
-    // --- 3. RUNWAY CHECK (RR Demotion) ---
-    if (s->is_runway_busy && s->runway_jet_q == 2) {
-        SchedulerJet* jet = scheduler_find_jet_unsafe(s, s->runway_jet_pid, NULL, NULL);
-        if (jet) {
-            jet->time_on_runway++;
-            if (jet->time_on_runway >= s->q2_rr_quantum) {
-                log_scheduler_event(log_file, "[Scheduler]: RR QUANTUM expired for Jet %d. Demoting to Q3.\n", jet->pid);
-                
-                s->is_runway_busy = false;
-                s->runway_jet_pid = 0;
-                s->runway_jet_q = 0;
-                s->total_context_switches++; // Count RR demotion as context switch
-                
-                int q, idx;
-                if (scheduler_find_jet_unsafe(s, jet->pid, &q, &idx)) {
-                    scheduler_move_jet_unsafe(s, q, idx, 3, log_file);
-                }
+    // --- 2. REFUEL BAYS (FCFS, independent of the runways) ---
+    int b;
+    while ((b = bay_find_free(s)) >= 0) {
+        SchedulerJet* jet = NULL;
+        for (SchedulerJet* j = s->refuel_queue.head; j != NULL; j = j->next) {
+            if (j->status == STATUS_WAITING_FUEL && j->bay < 0 && j->runway < 0) {
+                jet = j;
+                break;
             }
         }
+        if (jet == NULL) break;
+
+        if (!scheduler_send_command_unsafe(s, jet, CMD_REFUEL)) { retry_dispatch(s); break; }
+        bay_assign(s, b, jet);
+        jet->status = STATUS_REFUELING;
+        log_scheduler_event(log_file, "[Scheduler]: Refuel bay %d assigned to Jet %d.\n", b + 1, jet->pid);
+        record_decision(JEV_DISPATCH_REFUEL, jet->pid, REFUEL_QUEUE, 0, jet->fuel, b);
     }
+}
+
+void scheduler_tick(SchedulerState* s, FILE* log_file) {
+    pthread_mutex_lock(&s->lock);
+    session_input(SREC_TICK, 0, 0, 0);
     
-    // --- 4. DISPATCH (if runway is free) ---
-    if (s->is_runway_busy) {
+    if (s->is_paused) {
         pthread_mutex_unlock(&s->lock);
         return;
     }
 
-    // 4a. Check Queue 1 (SRTF)
-    if (s->q1_count > 0) {
-        int srtf_jet_idx = -1, min_fuel = 9999;
-        for (int i = 0; i < MAX_JETS; i++) {
-            if (s->queue1[i].pid != 0 && s->queue1[i].status == STATUS_IN_QUEUE && s->queue1[i].fuel < min_fuel) {
-                min_fuel = s->queue1[i].fuel;
-                srtf_jet_idx = i;
-            }
-        }
-        
-        if (srtf_jet_idx != -1) {
-            SchedulerJet* jet = &s->queue1[srtf_jet_idx];
-            AtcCommandMessage cmd = { CMD_START_LANDING };
-            if (write(jet->atc_write_fd, &cmd, sizeof(cmd)) != -1) {
-                s->is_runway_busy = true; s->runway_jet_pid = jet->pid; s->runway_jet_q = 1;
-                jet->status = STATUS_LANDING_CMD; 
-                if (jet->first_run_time == 0) jet->first_run_time = time(NULL); // Set response time
-                s->total_context_switches++; // Count dispatch
-                log_scheduler_event(log_file, "[Scheduler]: Runway assigned to EMERGENCY Jet %d (from Q1).\n", jet->pid);
-            }
-            pthread_mutex_unlock(&s->lock);
-            return;
+    // --- MODIFIED: Wait and busy time come from timestamps and the deadlines
+    // live in the timer wheel, so a tick costs O(timers due), not O(jets).
+    // Its period (s->tick_ms) is their resolution ---
+    uint64_t now = scheduler_now_ns();
+    TimerEntry* due = timer_wheel_expire(&s->timers, now);
+    bool quantum_due[MAX_RUNWAYS] = { false };
+
+    // --- 1. AGING (Q3 -> Q2), longest waiting first ---
+    TimerEntry* next_timer;
+    for (TimerEntry* e = due; e != NULL; e = next_timer) {
+        next_timer = e->next;
+        if (e->kind == TIMER_QUANTUM) {
+            quantum_due[(Runway*)((char*)e - offsetof(Runway, quantum_timer)) - s->runways] = true;
+            continue;
         }
+        SchedulerJet* jet = (SchedulerJet*)((char*)e - offsetof(SchedulerJet, aging_timer));
+        SchedulerPolicy::on_tick_aging(s, jet, log_file);
     }
-    
-    // 4b. Check Queue 2 (RR)
-    if (s->q2_count > 0) {
-        int jet_idx = -1;
-        // First, check for any promoted refuel requests
-        for (int i = 0; i < MAX_JETS; i++) {
-            if (s->queue2[i].pid != 0 && s->queue2[i].status == STATUS_WAITING_FUEL) {
-                jet_idx = i;
-                break; 
-            }
-        }
-        // If no refuel requests, find a normal landing request
-        if (jet_idx == -1) {
-            for (int i = 0; i < MAX_JETS; i++) {
-                if (s->queue2[i].pid != 0 && s->queue2[i].status == STATUS_IN_QUEUE) {
-                    jet_idx = i;
-                    break;
-                }
-            }
-        }
 
-        if (jet_idx != -1) {
-            SchedulerJet* jet = &s->queue2[jet_idx];
-            AtcCommandMessage cmd;
-            if (jet->status == STATUS_WAITING_FUEL) {
-                cmd.command = CMD_REFUEL;
-                jet->status = STATUS_REFUELING;
-                log_scheduler_event(log_file, "[Scheduler]: Runway assigned to Jet %d for REFUELING (from Q2).\n", jet->pid);
-            } else {
-                cmd.command = CMD_START_LANDING;
-                jet->status = STATUS_LANDING_CMD;
-                jet->time_on_runway = 0;
-                log_scheduler_event(log_file, "[Scheduler]: Runway assigned to Jet %d for LANDING (from Q2).\n", jet->pid);
-            }
 
-            if (write(jet->atc_write_fd, &cmd, sizeof(cmd)) != -1) {
-                s->is_runway_busy = true; s->runway_jet_pid = jet->pid; s->runway_jet_q = 2;
-                if (jet->first_run_time == 0) jet->first_run_time = time(NULL); // Set response time
-                s->total_context_switches++; // Count dispatch
-            }
-            pthread_mutex_unlock(&s->lock);
-            return;
-        }
+    // --- 2. RUNWAY CHECK (MLFQ: RR Demotion) ---
+    // Quantum timers are only armed for dispatches the policy gave one
+    for (int r = 0; r < s->runway_count; r++) {
+        if (!quantum_due[r] || !s->runways[r].busy) continue;
+        SchedulerJet* jet = scheduler_find_jet_unsafe(s, s->runways[r].jet_pid, NULL);
+        if (jet) SchedulerPolicy::on_tick_quantum(s, jet, r, log_file);
     }
     
-    // Q3 is standby/aging only. No dispatch from Q3.
+    // --- 3. DISPATCH (also run between ticks by scheduler_dispatch) ---
+    if (s->dispatch_pending) dispatch_unsafe(s, log_file);
+    scheduler_publish_radar_unsafe(s);
+    pthread_mutex_unlock(&s->lock);
+}
+
+void scheduler_dispatch(SchedulerState* s, FILE* log_file) {
+    pthread_mutex_lock(&s->lock);
+    // Nothing asked for it since the last dispatch, or paused until a tick after resume_sim
+    if (!s->dispatch_pending || s->is_paused) {
+        pthread_mutex_unlock(&s->lock);
+        return;
+    }
+    session_input(SREC_DISPATCH, 0, 0, 0);
+    dispatch_unsafe(s, log_file);
+    scheduler_publish_radar_unsafe(s);
+    pthread_mutex_unlock(&s->lock);
+}
+
+
+// --- NEW: Scheduler thread wakeups (eventfd + timerfd) ---
 
+bool scheduler_enable_dispatch_events(SchedulerState* s) {
+    if (s->dispatch_fd >= 0) return true;
+    int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (fd == -1) return false;
+    pthread_mutex_lock(&s->lock);
+    s->dispatch_fd = fd;
+    s->dispatch_pending = false;
     pthread_mutex_unlock(&s->lock);
+    return true;
+}
+
+int scheduler_open_tick_timer(int period_ms) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd == -1) return -1;
+    struct itimerspec its;
+    its.it_interval.tv_sec = period_ms / 1000;
+    its.it_interval.tv_nsec = (long)(period_ms % 1000) * 1000000L;
+    its.it_value = its.it_interval;
+    if (timerfd_settime(fd, 0, &its, NULL) == -1) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void scheduler_wait_events(SchedulerState* s, int tick_fd, int timeout_ms, int* ticks, bool* dispatch) {
+    *ticks = 0;
+    *dispatch = false;
+    struct pollfd fds[2];
+    fds[0].fd = tick_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = s->dispatch_fd; // poll skips a negative fd
+    fds[1].events = POLLIN;
+    if (poll(fds, 2, timeout_ms) <= 0) return;
+
+    uint64_t count;
+    if ((fds[0].revents & POLLIN) && read(tick_fd, &count, sizeof(count)) == sizeof(count)) {
+        *ticks = (int)count; // More than 1 if the thread fell behind
+    }
+    if ((fds[1].revents & POLLIN) && eventfd_read(s->dispatch_fd, &count) == 0) {
+        *dispatch = true;
+    }
 }
 
 void scheduler_jet_landed_unsafe(SchedulerState* s, pid_t pid, FILE* log_file) {
+    int q;
+    // Find the jet to clear its data
+    SchedulerJet* jet = scheduler_find_jet_unsafe(s, pid, &q);
+    int r = jet ? jet->runway : -1;
+
     log_scheduler_event(log_file, "[Scheduler]: Jet %d has landed and is being cleared.\n", pid);
+    record_decision(JEV_LANDED, pid, 0, 0, 0, r);
     
-    if (s->runway_jet_pid == pid) {
-        s->is_runway_busy = false; s->runway_jet_pid = 0; s->runway_jet_q = 0;
-    }
-    
-    int q, idx;
-    // Find the jet to clear its data
-    SchedulerJet* jet = scheduler_find_jet_unsafe(s, pid, &q, &idx);
+    if (r >= 0) runway_release(s, r);
+    if (jet && jet->bay >= 0) bay_release(s, jet->bay);
     
     if (jet) {
-        close(jet->atc_read_fd); close(jet->atc_write_fd);
-        
-        // Clear the jet's slot in the queue
-        if (q == 1) {
-            memset(&s->queue1[idx], 0, sizeof(SchedulerJet)); s->q1_count--;
-        } else if (q == 2) {
-            memset(&s->queue2[idx], 0, sizeof(SchedulerJet)); s->q2_count--;
-        } else if (q == 3) {
-            memset(&s->queue3[idx], 0, sizeof(SchedulerJet)); s->q3_count--;
+        if (jet->atc_read_fd >= 0) {
+            // Drones inherit copies of this fd, so close() alone would not unregister it
+            epoll_ctl(s->epoll_fd, EPOLL_CTL_DEL, jet->atc_read_fd, NULL);
+            close(jet->atc_read_fd);
         }
+        if (jet->atc_write_fd >= 0) close(jet->atc_write_fd);
+        if (jet->shm) shm_channel_unmap(jet->shm);
+        
+        // Return the record to the pool
+        if (jet->heap_idx >= 0) heap_remove(s, jet);
+        if (jet->q2_refuel_counted) s->q2_waiting_fuel--;
+        index_remove(&s->index, pid);
+        queue_unlink(scheduler_get_queue(s, q), jet);
+        pool_free(s, jet);
     } else {
         log_scheduler_event(log_file, "[Scheduler]: ERROR: Could not find landed jet %d in queues.\n", pid);
     }
+    scheduler_publish_radar_unsafe(s);
 }
 
 
-void scheduler_handle_emergency_unsafe(SchedulerState* s, pid_t pid, int current_fuel, FILE* log_file) {
-    int q, idx;
-    SchedulerJet* jet = scheduler_find_jet_unsafe(s, pid, &q, &idx);
+static void handle_emergency(SchedulerState* s, pid_t pid, int current_fuel, FILE* log_file) {
+    int q;
+    SchedulerJet* jet = scheduler_find_jet_unsafe(s, pid, &q);
 
     if (!jet) {
         log_scheduler_event(log_file, "[Scheduler]: ERROR: Could not find jet %d to handle emergency.\n", pid);
@@ -404,43 +1395,36 @@ void scheduler_handle_emergency_unsafe(SchedulerState* s, pid_t pid, int current
     
     jet->fuel = current_fuel;
     jet->status = STATUS_IN_QUEUE; // Ensure it's ready to run
+    // --- NEW: Emergency-to-runway latency runs from the first declaration until it
+    // gets a runway (0 if it already holds one) ---
+    if (jet->runway >= 0) jet->emergency_latency_ns = 0;
+    else if (jet->emergency_ns == 0) jet->emergency_ns = scheduler_now_ns();
 
     if (q != 1) {
         log_scheduler_event(log_file, "[Scheduler]: Jet %d moved to Q1 (Emergency).\n", pid);
-        if (!scheduler_move_jet_unsafe(s, q, idx, 1, log_file)) return;
-        jet = scheduler_find_jet_unsafe(s, pid, &q, &idx); 
-        if (!jet) return;
-        jet->fuel = current_fuel;
-        jet->status = STATUS_IN_QUEUE; // Set status again after move
+        record_decision(JEV_EMERGENCY, pid, q, 1, current_fuel);
+        if (!move_jet(s, jet, 1, log_file)) return;
+    } else {
+        q1_heap_sync(s, jet); // Decrease-key on the new fuel reading
     }
 
-    if (s->is_runway_busy && s->runway_jet_pid != pid) {
-        SchedulerJet* running_jet = scheduler_find_jet_unsafe(s, s->runway_jet_pid, NULL, NULL);
-        if (!running_jet) return;
-        
-        bool preempt = false;
-        if (s->runway_jet_q == 1) {
-            if (jet->fuel < running_jet->fuel) {
-                preempt = true;
-                log_scheduler_event(log_file, "[Scheduler]: New emergency Jet %d (fuel %d) preempting running Jet %d (fuel %d).\n",
-                     jet->pid, jet->fuel, running_jet->pid, running_jet->fuel);
-            }
-        } else {
-            preempt = true;
-             log_scheduler_event(log_file, "[Scheduler]: Emergency Jet %d preempting non-emergency Jet %d.\n",
-                  jet->pid, running_jet->pid);
-        }
-
-        if (preempt) {
-            scheduler_preempt_runway_unsafe(s, log_file);
-        }
+    // --- MODIFIED: Preempt only when every runway is taken; the policy picks the runway ---
+    if (s->runways_busy == s->runway_count && jet->runway < 0 && jet->bay < 0) {
+        int victim = SchedulerPolicy::should_preempt(s, jet, log_file);
+        if (victim >= 0) scheduler_preempt_runway_unsafe(s, victim, log_file);
     }
 }
 
+void scheduler_handle_emergency_unsafe(SchedulerState* s, pid_t pid, int current_fuel, FILE* log_file) {
+    handle_emergency(s, pid, current_fuel, log_file);
+    request_dispatch(s); // Q1 goes first, even if it did not have to move
+    scheduler_publish_radar_unsafe(s);
+}
+
 // --- MODIFIED: Handle refuel request ---
-void scheduler_handle_refuel_request_unsafe(SchedulerState* s, pid_t pid, int current_fuel, FILE* log_file) {
-    int q, idx;
-    SchedulerJet* jet = scheduler_find_jet_unsafe(s, pid, &q, &idx);
+static void handle_refuel_request(SchedulerState* s, pid_t pid, int current_fuel, FILE* log_file) {
+    int q;
+    SchedulerJet* jet = scheduler_find_jet_unsafe(s, pid, &q);
     if (!jet) {
         log_scheduler_event(log_file, "[Scheduler]: ERROR: Could not find jet %d to handle refuel request.\n", pid);
         return;
@@ -448,12 +1432,120 @@ void scheduler_handle_refuel_request_unsafe(SchedulerState* s, pid_t pid, int cu
     
     jet->fuel = current_fuel;
     jet->status = STATUS_WAITING_FUEL;
+    q1_heap_sync(s, jet); // EDF and stride keep a jet waiting to refuel in the ready heap
+
+    // --- NEW: With refuel bays the jet waits for a bay, not for a runway ---
+    if (s->bay_count > 0) {
+        if (q != REFUEL_QUEUE) {
+            log_scheduler_event(log_file, "[Scheduler]: Jet %d queued for a refuel bay.\n", pid);
+            record_decision(JEV_REFUEL_REQUEST, pid, q, REFUEL_QUEUE, current_fuel);
+            move_jet(s, jet, REFUEL_QUEUE, log_file);
+        } else {
+            log_scheduler_event(log_file, "[Scheduler]: Jet %d is waiting for a refuel bay.\n", pid);
+            record_decision(JEV_REFUEL_WAIT, pid, q, q, current_fuel);
+        }
+        return;
+    }
 
     if (q != 3) {
         log_scheduler_event(log_file, "[Scheduler]: Jet %d moved to Q3 for refueling.\n", pid);
-        scheduler_move_jet_unsafe(s, q, idx, 3, log_file);
+        record_decision(JEV_REFUEL_REQUEST, pid, q, 3, current_fuel);
+        move_jet(s, jet, 3, log_file);
     } else {
         log_scheduler_event(log_file, "[Scheduler]: Jet %d is waiting in Q3 to refuel.\n", pid);
+        record_decision(JEV_REFUEL_WAIT, pid, 3, 3, current_fuel);
+    }
+}
+
+void scheduler_handle_refuel_request_unsafe(SchedulerState* s, pid_t pid, int current_fuel, FILE* log_file) {
+    handle_refuel_request(s, pid, current_fuel, log_file);
+    scheduler_publish_radar_unsafe(s);
+}
+
+// --- NEW: Fuel reading from STATUS_FUEL_LOW (or any other feedback) ---
+void scheduler_update_fuel_unsafe(SchedulerState* s, SchedulerJet* jet, int fuel) {
+    jet->fuel = fuel;
+    record_decision(JEV_FUEL, jet->pid, jet->queue, jet->queue, fuel);
+    SchedulerPolicy::on_feedback(s, jet);
+    scheduler_publish_radar_unsafe(s);
+}
+
+// --- NEW: Jet finished refueling, free the runway or bay it was holding ---
+void scheduler_handle_refueled_unsafe(SchedulerState* s, pid_t pid, int new_fuel, FILE* log_file) {
+    SchedulerJet* jet = scheduler_find_jet_unsafe(s, pid, NULL);
+    if (!jet) {
+        log_scheduler_event(log_file, "[Scheduler]: ERROR: Could not find refueled jet %d.\n", pid);
+        return;
+    }
+
+    jet->fuel = new_fuel;
+    jet->status = STATUS_IN_QUEUE; 
+    record_decision(JEV_REFUELED, pid, jet->queue, jet->queue, new_fuel, jet->bay >= 0 ? jet->bay : jet->runway);
+    if (jet->runway >= 0) runway_release(s, jet->runway);
+    if (jet->bay >= 0) bay_release(s, jet->bay);
+    mark_queued(s, jet); // Waiting to land now
+    // Out of the bay queue and back in line to land (an emergency already moved it to Q1)
+    if (jet->queue == REFUEL_QUEUE) move_jet(s, jet, 2, log_file);
+    q1_heap_sync(s, jet);
+    scheduler_publish_radar_unsafe(s);
+}
+
+
+// --- NEW: Work stealing (sector.cpp) ---
+
+// A jet another sector may take: waiting to land, holding nothing, and
+// not registered in the tower's epoll set under this record's address
+static bool stealable(const SchedulerJet* jet) {
+    return jet->status == STATUS_IN_QUEUE && jet->runway < 0 && jet->bay < 0 && jet->atc_read_fd < 0;
+}
+
+// Copies the record into `to`'s pool and releases it from `from`'s
+static bool transfer_jet(SchedulerState* from, SchedulerState* to, SchedulerJet* jet) {
+    SchedulerJet* copy = pool_alloc(to);
+    if (copy == NULL) return false;
+    if (!index_insert(&to->index, jet->pid, copy)) {
+        pool_free(to, copy);
+        return false;
     }
+    int q = jet->queue;
+    timer_wheel_cancel(&from->timers, &jet->aging_timer);
+    *copy = *jet;
+    copy->heap_idx = -1;
+    timer_entry_init(&copy->aging_timer, TIMER_AGING);
+    copy->q2_refuel_counted = false; // Counted in `to` by q1_heap_sync
+
+    if (jet->heap_idx >= 0) heap_remove(from, jet);
+    if (jet->q2_refuel_counted) from->q2_waiting_fuel--;
+    index_remove(&from->index, jet->pid);
+    queue_unlink(scheduler_get_queue(from, q), jet);
+    pool_free(from, jet);
+
+    queue_push_back(scheduler_get_queue(to, q), copy);
+    copy->queue = q;
+    // Still the same wait: queued_ns is kept, so a Q3 jet ages on its original deadline
+    aging_timer_sync(to, copy);
+    q1_heap_sync(to, copy);
+    request_dispatch(to);
+    return true;
 }
 
+int scheduler_steal_jets_unsafe(SchedulerState* from, SchedulerState* to, int max, pid_t* out_pids, FILE* log_file) {
+    int taken = 0;
+    for (int q = 2; q <= 3 && taken < max; q++) {
+        SchedulerJet* next_jet;
+        for (SchedulerJet* jet = scheduler_get_queue(from, q)->head; jet != NULL && taken < max; jet = next_jet) {
+            next_jet = jet->next; // Grab before the record is released
+            if (!stealable(jet)) continue;
+            pid_t pid = jet->pid;
+            if (!transfer_jet(from, to, jet)) return taken;
+            out_pids[taken++] = pid;
+            log_scheduler_event(log_file, "[Scheduler]: Jet %d handed over from sector %d to sector %d (Q%d).\n",
+                pid, from->sector + 1, to->sector + 1, q);
+        }
+    }
+    if (taken > 0) {
+        scheduler_publish_radar_unsafe(from);
+        scheduler_publish_radar_unsafe(to);
+    }
+    return taken;
+}
@@ -3,11 +3,68 @@
 
 #include "utils.h"
 #include <time.h> // --- NEW: For stats
+#include <stdint.h>
+#include "shm_ring.h"
+#include "timer_wheel.h"
 
 // --- Assignment Constants ---
 #define RR_QUANTUM 5        // Default 5-second time quantum for Q2
 #define AGING_THRESHOLD 10  // 10-second wait in Q3 before promotion
 
+// --- MODIFIED: Scheduler timing is in CLOCK_MONOTONIC ns, configured in ms ---
+#define NS_PER_MS 1000000ULL
+#define NS_PER_SEC 1000000000ULL
+#define RR_QUANTUM_MS (RR_QUANTUM * 1000)
+#define AGING_THRESHOLD_MS (AGING_THRESHOLD * 1000)
+
+// --- Runways ---
+#define MAX_RUNWAYS 16
+#define DEFAULT_RUNWAYS 1
+#define TICK_PERIOD_MS 1000 // Default tick: runs the aging and RR quantum timers that are due
+
+// --- TimerEntry::kind for the scheduler's timer wheel ---
+#define TIMER_AGING 1       // SchedulerJet::aging_timer, armed while it waits in Q3
+#define TIMER_QUANTUM 2     // Runway::quantum_timer, armed while a Q2 jet holds it
+
+// --- Refuel bays (0: refuels take a runway, as before) ---
+#define MAX_REFUEL_BAYS 16
+#define DEFAULT_REFUEL_BAYS 1
+#define REFUEL_QUEUE 4      // jet->queue while waiting for (or in) a refuel bay
+
+// --- NEW: Scheduling policy, chosen at compile time ---
+// Build with -DSCHEDULER_POLICY=SCHED_POLICY_EDF (or _STRIDE) to swap the
+// policy. The queues, runways, bays, timers and accounting are the same for
+// every policy; the policy only decides who goes next (scheduler.cpp).
+//
+// A policy is a struct of static functions (no instances, no virtuals), and
+// scheduler.cpp calls SchedulerPolicy::f() directly, so each call inlines:
+//   on_arrival(s, jet)            Queue (1-3) for a new jet; sets its policy fields
+//   ready(jet) / before(a, b)     Membership and order of the ready heap (s->q1_heap)
+//   select_next(s)                Jet for a free runway, NULL if none
+//   on_dispatch(s, jet, from_q)   It got a runway; true arms the RR quantum timer
+//   ages(jet)                     Arm the Q3 aging timer while it waits
+//   on_tick_aging(s, jet, log)    Its aging timer expired
+//   on_tick_quantum(s, jet, r, log)  Its quantum on runway r expired
+//   on_feedback(s, jet)           Its fuel reading changed
+//   should_preempt(s, jet, log)   Runway an emergency takes over, -1 for none
+#define SCHED_POLICY_MLFQ 0     // SRTF Q1, RR Q2, FCFS Q3 with aging (default)
+#define SCHED_POLICY_EDF 1      // Earliest deadline first, the deadline being fuel
+#define SCHED_POLICY_STRIDE 2   // Stride scheduling, tickets by low fuel
+#ifndef SCHEDULER_POLICY
+#define SCHEDULER_POLICY SCHED_POLICY_MLFQ
+#endif
+
+// --- Stride policy ---
+#define STRIDE_ONE (1ULL << 20) // Pass charged per quantum to a jet with one ticket
+#define STRIDE_FUEL_CAP 100     // Tickets: 1 + (STRIDE_FUEL_CAP - fuel), at least 1
+
+// --- Radar snapshot ---
+#define RADAR_MAX_LISTED 16 // Jets listed per queue on the display, the rest are counted
+
+// --- Jet record pool ---
+#define JET_SLAB_SIZE 256   // Jet records allocated per slab chunk
+#define JET_INDEX_INITIAL_CAPACITY 64
+
 // --- MODIFIED: Added fields for statistics ---
 struct SchedulerJet {
     pid_t pid;
@@ -15,59 +72,289 @@ struct SchedulerJet {
     int atc_write_fd;
     int fuel;
     JetStatus status;
-    int time_on_runway;
-    int time_in_q3;
+    int runway;         // Index into s->runways while it holds one, -1 otherwise
+    int bay;            // Index into s->bays while it holds one, -1 otherwise
+    uint64_t queued_ns; // When it last started waiting for a runway or bay (also Q3 aging), 0 while it holds one
 
-    // --- NEW: Fields for statistics ---
-    time_t arrival_time;
-    time_t first_run_time; // 0 if not run yet
-    int total_wait_time;
+    // --- MODIFIED: Statistics, in scheduler_now_ns() ---
+    uint64_t arrival_ns;
+    uint64_t first_run_ns;  // 0 if not run yet
+    uint64_t total_wait_ns; // Summed from queued_ns at each dispatch (and at landing)
+    uint64_t emergency_ns;  // --- NEW: Emergency declared and not on a runway yet, 0 otherwise
+    int64_t emergency_latency_ns; // Declaration to runway for the last emergency, -1 if none
+    int dispatched_from;    // --- NEW: Queue of its last runway dispatch, 0 if never dispatched
+
+    // --- Intrusive queue membership (owned by the scheduler) ---
+    int queue;          // 1-3 while queued, 0 while on the free list
+    SchedulerJet* prev;
+    SchedulerJet* next;
+
+    // --- Q1 SRTF heap position ---
+    int heap_idx;               // Slot in s->q1_heap, -1 if not in it
+    unsigned long q1_seq;       // Q1 entry order (arrival order until then), breaks fuel ties
+    uint64_t pass;              // --- NEW: Stride policy: virtual time charged so far
+    bool q2_refuel_counted;     // --- NEW: Counted in s->q2_waiting_fuel
+
+    TimerEntry aging_timer;     // --- NEW: Due at queued_ns + aging_ms while waiting in Q3
+
+    // --- Shared-memory transport (NULL: commands go through atc_write_fd) ---
+    ShmChannel* shm;            // atc_read_fd/atc_write_fd are then its doorbells
+
+    unsigned int feedback_seq;  // Next seq expected on the shared feedback socket
+};
+
+/**
+ * @brief Doubly linked list of jet records. Enqueue, unlink and
+ * queue-to-queue moves are O(1) and never copy the record.
+ */
+struct JetQueue {
+    SchedulerJet* head;
+    SchedulerJet* tail;
+    int count;
+};
+
+/**
+ * @brief A chunk of jet records. Slabs are chained and never freed
+ * until scheduler_destroy, so a SchedulerJet* stays valid while the
+ * jet is in the system no matter how far the pool grows.
+ */
+struct JetSlab {
+    JetSlab* next;
+    SchedulerJet jets[JET_SLAB_SIZE];
+};
+
+/**
+ * @brief Open-addressing (linear probing) index from pid to jet record.
+ * The table is kept at most half full and only grows on insert, so
+ * lookups are constant time and never allocate.
+ */
+struct JetIndexSlot {
+    pid_t pid;          // 0 = empty slot
+    SchedulerJet* jet;
+};
+
+struct JetIndex {
+    JetIndexSlot* slots;
+    int capacity;       // Always a power of two
+    int size;
+};
+
+/**
+ * @brief One runway. A jet holds it from dispatch until it lands,
+ * finishes refueling, is preempted or is demoted by RR. A landing is
+ * never preempted or demoted: the jet keeps the runway until it is down.
+ */
+struct Runway {
+    bool busy;
+    pid_t jet_pid;
+    int jet_q;                  // Queue the jet was dispatched from
+    bool landing;               // --- NEW: CMD_START_LANDING was sent (no quantum, no preemption)
+    uint64_t busy_ns;           // Summed over finished dispatches
+    uint64_t busy_since_ns;     // Dispatch time of the current jet (RR quantum)
+    int dispatches;
+    uint64_t idle_since_ns;     // scheduler_now_ns() when last released, 0 if never used
+    TimerEntry quantum_timer;   // --- NEW: Due at busy_since_ns + q2_quantum_ms for a Q2 jet
 };
 
+/**
+ * @brief One refuel bay. A jet holds it from CMD_REFUEL until
+ * STATUS_REFUELED, without taking a runway.
+ */
+struct RefuelBay {
+    bool busy;
+    pid_t jet_pid;
+    uint64_t busy_ns;           // Summed over finished refuels
+    uint64_t busy_since_ns;
+    int dispatches;
+};
+
+/**
+ * @brief NEW: What the radar display shows, copied out of the scheduler
+ * after every change so the display never takes s->lock.
+ */
+struct RadarJet {
+    pid_t pid;
+    int fuel;
+    int wait_ms;        // Time in its current queue
+    int status;         // JetStatus
+    bool refueling;     // Holds a refuel bay
+};
+
+struct RadarQueue {
+    int count;          // Jets in the queue
+    int listed;         // Jets in jets[] (at most RADAR_MAX_LISTED)
+    RadarJet jets[RADAR_MAX_LISTED];
+};
+
+struct RadarSnapshot {
+    bool paused;
+    int sector;
+    int q2_quantum_ms;
+    int runway_count;
+    int runways_busy;
+    Runway runways[MAX_RUNWAYS];
+    int bay_count;
+    int bays_busy;
+    int bays_waiting;   // Jets in the refuel queue not yet in a bay
+    RefuelBay bays[MAX_REFUEL_BAYS];
+    RadarQueue queues[4]; // Q1, Q2, Q3, refuel queue
+};
+
+/**
+ * @brief Delivers a runway command to a jet that has no pipe (simulated
+ * jets). Called with the scheduler lock held, so it must not call back
+ * into the scheduler. Returns false if the command could not be sent.
+ */
+typedef bool (*SchedulerCommandHook)(void* ctx, SchedulerJet* jet, AtcCommand command);
+
 // --- MODIFIED: Added fields for statistics ---
 struct SchedulerState 
 {
-    SchedulerJet queue1[MAX_JETS]; // Q1: SRTF
-    SchedulerJet queue2[MAX_JETS]; // Q2: RR
-    SchedulerJet queue3[MAX_JETS]; // Q3: FCFS
+    JetQueue queue1; // Q1: SRTF
+    JetQueue queue2; // Q2: RR
+    JetQueue queue3; // Q3: FCFS
+
+    // --- Jet record pool ---
+    JetSlab* slabs;
+    SchedulerJet* free_list; // Linked through SchedulerJet::next
+    int slab_count;
 
-    int q1_count;
-    int q2_count;
-    int q3_count;
+    JetIndex index;     // pid -> jet record for every queued jet
+
+    int epoll_fd;       // Tower event loop; jets' atc_read_fd registered with data.ptr = jet
+
+    // --- NEW: Where runway commands go. NULL = write to the jet's pipe ---
+    SchedulerCommandHook command_hook;
+    void* command_hook_ctx;
+
+    // --- Q1 SRTF: indexed min-heap on (fuel, q1_seq) ---
+    // Holds the Q1 jets that are ready to dispatch (STATUS_IN_QUEUE and
+    // not on the runway). Sized with the pool, so it never grows on insert.
+    // --- MODIFIED: The policy decides which jets it holds and in what
+    // order; EDF and stride keep every waiting jet in it ---
+    SchedulerJet** q1_heap;
+    int q1_heap_size;
+    unsigned long q1_seq_counter;
+    uint64_t stride_pass;   // --- NEW: Stride policy: pass of the last jet dispatched
+    int q2_waiting_fuel;    // --- NEW: Q2 jets in STATUS_WAITING_FUEL (MLFQ dispatches them first)
     
-    bool is_runway_busy;
-    pid_t runway_jet_pid;
-    int runway_jet_q;
+    // --- MODIFIED: N runways (set at startup with scheduler_set_runway_count) ---
+    Runway runways[MAX_RUNWAYS];
+    int runway_count;
+    int runways_busy;
+
+    // --- NEW: Refuel bays and their FIFO queue (REFUEL_QUEUE) ---
+    RefuelBay bays[MAX_REFUEL_BAYS];
+    int bay_count;
+    int bays_busy;
+    JetQueue refuel_queue;
     
-    int q2_rr_quantum;
+    int q2_quantum_ms;  // --- MODIFIED: RR quantum in ms (was whole seconds)
+    int aging_ms;       // Wait in Q3 before promotion to Q2
+    int tick_ms;        // Period of the tick thread's timer, the resolution of both
+    // --- NEW: Aging and quantum deadlines. A tick only touches the timers
+    // that are due, never the queues ---
+    TimerWheel timers;
     bool is_paused;     
+    int sector;         // --- NEW: Airspace sector (sector.h), -1 when the tower is not sharded
+
+    // --- NEW: Event-driven dispatch. A freed runway or bay, an arrival or an
+    // emergency sets dispatch_pending and rings dispatch_fd (an eventfd, -1 if
+    // nobody waits on it; the simulation polls the flag instead) ---
+    int dispatch_fd;
+    bool dispatch_pending;
     
     pthread_mutex_t lock;
 
+    // --- NEW: Radar snapshot, a seqlock with s->lock holders as the only writer ---
+    RadarSnapshot radar;
+    unsigned radar_seq; // Odd while a publish is in progress
+    int backlog;        // --- NEW: Q2 + Q3 jets as of the last publish, stored relaxed for other sectors
+
     // --- NEW: Fields for statistics ---
     int total_context_switches;
-    double total_runway_busy_time; // in seconds
+    uint64_t total_runway_busy_ns; // Summed over all runways, finished dispatches only
+    uint64_t total_bay_busy_ns;    // Same for all bays
+    uint64_t runway_queue_delay_ns; // Time jets waited for a runway, summed over dispatches
+    uint64_t bay_queue_delay_ns;    // Same for refuel bays
+    int runway_dispatches;
+    int bay_dispatches;
+    // --- NEW: Runway idle gap: how long a runway stood free while the jet it went to was already waiting ---
+    double runway_idle_gap_ns;     // Summed over dispatches
+    uint64_t runway_idle_gap_max_ns;
 };
 
 // --- Function Declarations ---
 
+// --- NEW: Scheduler clock (wall clock, or virtual time in simulation mode) ---
+time_t scheduler_now();
+void scheduler_set_virtual_time(time_t now);
+// --- NEW: CLOCK_MONOTONIC in ns (the virtual clock in simulation mode and replay) ---
+uint64_t scheduler_now_ns();
+uint64_t scheduler_monotonic_ns();  // Always the real clock
+// Virtual clock in ns; scheduler_now() reports now_ns + wall_offset_ns as wall time
+void scheduler_set_virtual_time_ns(uint64_t now_ns, int64_t wall_offset_ns);
+
 void scheduler_init(SchedulerState* s);
+const char* scheduler_policy_name(); // --- NEW: "mlfq", "edf" or "stride"
+// --- NEW: RR quantum and Q3 aging threshold in ms (at least 1) ---
+void scheduler_set_quantum_ms(SchedulerState* s, int quantum_ms);
+void scheduler_set_aging_ms(SchedulerState* s, int aging_ms);
+void scheduler_set_tick_ms(SchedulerState* s, int tick_ms); // Before the tick thread starts
+// --- NEW: Busy time of a runway or bay so far, including a dispatch still running ---
+uint64_t scheduler_runway_busy_ns_unsafe(const SchedulerState* s, int r);
+uint64_t scheduler_bay_busy_ns_unsafe(const SchedulerState* s, int b);
+// --- NEW: Call before the first jet is added. Clamped to 1..MAX_RUNWAYS ---
+void scheduler_set_runway_count(SchedulerState* s, int count);
+// --- NEW: Same, for refuel bays. Clamped to 0..MAX_REFUEL_BAYS ---
+void scheduler_set_refuel_bays(SchedulerState* s, int count);
 void scheduler_add_jet(SchedulerState* s, pid_t pid, int read_fd, int write_fd, int fuel, FILE* log_file);
+// --- NEW: Same, for a jet on the shm transport (read_fd/write_fd are its doorbells) ---
+void scheduler_add_shm_jet(SchedulerState* s, pid_t pid, int read_fd, int write_fd, ShmChannel* shm, int fuel, FILE* log_file);
 
-// --- MODIFIED: Reverted - 2 arguments, console print is back on
+// --- MODIFIED: Renders the radar snapshot, does not take s->lock ---
 void scheduler_print_queues(SchedulerState* s, FILE* log_file);
 
+// --- NEW: Radar snapshot. Every scheduler function that changes queue or
+// runway state publishes on its way out; call publish yourself after
+// changing SchedulerState fields directly. read never blocks the scheduler.
+void scheduler_publish_radar_unsafe(SchedulerState* s);
+void scheduler_read_radar(SchedulerState* s, RadarSnapshot* out);
+
 void scheduler_destroy(SchedulerState* s);
 void scheduler_tick(SchedulerState* s, FILE* log_file); 
+
+// --- NEW: Event-driven dispatch ---
+// Creates s->dispatch_fd so a scheduler thread can sleep on it
+bool scheduler_enable_dispatch_events(SchedulerState* s);
+// Fills free runways and bays if an event asked for it (no accounting, unlike a tick)
+void scheduler_dispatch(SchedulerState* s, FILE* log_file);
+// Periodic timerfd for the accounting tick, -1 on error
+int scheduler_open_tick_timer(int period_ms);
+// Sleeps until the tick timer or s->dispatch_fd fires (or timeout_ms passes).
+// Sets *ticks to the number of tick periods elapsed and *dispatch if woken for dispatch.
+void scheduler_wait_events(SchedulerState* s, int tick_fd, int timeout_ms, int* ticks, bool* dispatch);
 void scheduler_jet_landed_unsafe(SchedulerState* s, pid_t pid, FILE* log_file); 
 void scheduler_handle_emergency_unsafe(SchedulerState* s, pid_t pid, int current_fuel, FILE* log_file); 
 
 // --- NEW: Handle refuel request ---
 void scheduler_handle_refuel_request_unsafe(SchedulerState* s, pid_t pid, int current_fuel, FILE* log_file);
 
+// --- NEW: Fuel/refuel feedback (keeps the Q1 heap in sync) ---
+void scheduler_update_fuel_unsafe(SchedulerState* s, SchedulerJet* jet, int fuel);
+void scheduler_handle_refueled_unsafe(SchedulerState* s, pid_t pid, int new_fuel, FILE* log_file);
+
 // --- Helper functions ---
-SchedulerJet* scheduler_find_jet_unsafe(SchedulerState* s, pid_t pid, int* out_q, int* out_idx);
-bool scheduler_move_jet_unsafe(SchedulerState* s, int from_q, int from_idx, int to_q, FILE* log_file);
+bool scheduler_send_command_unsafe(SchedulerState* s, SchedulerJet* jet, AtcCommand command);
+JetQueue* scheduler_get_queue(SchedulerState* s, int q);
+SchedulerJet* scheduler_find_jet_unsafe(SchedulerState* s, pid_t pid, int* out_q);
+bool scheduler_move_jet_unsafe(SchedulerState* s, SchedulerJet* jet, int to_q, FILE* log_file);
+
+// --- NEW: Work stealing between sectors. Caller holds both locks. Moves up to
+// `max` ready Q2 (then Q3) jets from `from` to the same queue in `to` and
+// stores their pids in out_pids. Q1, jets on a runway or in a bay, and jets
+// with a feedback fd in the epoll set are never moved. Returns the count.
+int scheduler_steal_jets_unsafe(SchedulerState* from, SchedulerState* to, int max, pid_t* out_pids, FILE* log_file);
 
 #endif // SCHEDULER_H
 
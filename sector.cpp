@@ -0,0 +1,233 @@
+#include "sector.h"
+#include "metrics.h"
+#include <sched.h>
+
+// --- Setup ---
+
+bool sectors_init(SectorSet* set, SchedulerState* first, int count, int runways, int refuel_bays) {
+    if (count < 1) count = 1;
+    if (count > MAX_SECTORS) count = MAX_SECTORS;
+    set->count = count;
+    set->started = false;
+    set->keep_running = NULL;
+    set->log_file = NULL;
+    if (pthread_mutex_init(&set->route_lock, NULL) != 0) return false;
+
+    for (int i = 0; i < count; i++) {
+        Sector* sec = &set->sectors[i];
+        if (i == 0) {
+            sec->s = first;
+        } else {
+            sec->s = (SchedulerState*)malloc(sizeof(SchedulerState));
+            if (sec->s == NULL) {
+                set->count = i;
+                return false;
+            }
+            scheduler_init(sec->s);
+            sec->s->q2_quantum_ms = first->q2_quantum_ms;
+            sec->s->aging_ms = first->aging_ms;
+            sec->s->tick_ms = first->tick_ms;
+        }
+        // Even split, the remainder to the first sectors
+        int share = runways / count + (i < runways % count ? 1 : 0);
+        scheduler_set_runway_count(sec->s, share); // At least one
+        int bays = 0;
+        if (refuel_bays > 0) {
+            bays = refuel_bays / count + (i < refuel_bays % count ? 1 : 0);
+            if (bays < 1) bays = 1;
+        }
+        scheduler_set_refuel_bays(sec->s, bays);
+        sec->s->sector = i;
+        scheduler_publish_radar_unsafe(sec->s);
+        sec->set = set;
+        sec->index = i;
+        sec->cpu = -1;
+        sec->steals = 0;
+        sec->stolen = 0;
+    }
+    return true;
+}
+
+void sectors_destroy(SectorSet* set) {
+    for (int i = 1; i < set->count; i++) {
+        scheduler_destroy(set->sectors[i].s);
+        free(set->sectors[i].s);
+        set->sectors[i].s = NULL;
+    }
+    set->route.clear();
+    pthread_mutex_destroy(&set->route_lock);
+}
+
+void sectors_set_command_hook(SectorSet* set, SchedulerCommandHook hook, void* ctx) {
+    for (int i = 0; i < set->count; i++) {
+        SchedulerState* s = set->sectors[i].s;
+        pthread_mutex_lock(&s->lock);
+        s->command_hook = hook;
+        s->command_hook_ctx = ctx;
+        pthread_mutex_unlock(&s->lock);
+    }
+}
+
+
+// --- Work Stealing ---
+
+// Ready Q2 jets, counted up to `limit` (the dispatch order only looks at Q2)
+static int ready_q2_jets(const SchedulerState* s, int limit) {
+    int ready = 0;
+    for (const SchedulerJet* jet = s->queue2.head; jet != NULL && ready < limit; jet = jet->next) {
+        if (jet->runway < 0 && (jet->status == STATUS_IN_QUEUE || jet->status == STATUS_WAITING_FUEL)) ready++;
+    }
+    return ready;
+}
+
+static void sector_steal(SectorSet* set, int index, FILE* log_file) {
+    Sector* thief = &set->sectors[index];
+    SchedulerState* s = thief->s;
+    pthread_mutex_lock(&s->lock);
+
+    // Only an idle sector steals: free runways and no emergency of its own
+    int wanted = s->runway_count - s->runways_busy;
+    if (!s->is_paused && wanted > 0 && s->q1_heap_size == 0) wanted -= ready_q2_jets(s, wanted);
+    else wanted = 0;
+
+    // Most loaded neighbour, from the backlog each sector publishes. It is only a
+    // hint; the steal itself runs under the victim's lock.
+    int own = s->queue2.count + s->queue3.count;
+    int victim = -1;
+    int best = own + SECTOR_STEAL_MIN_BACKLOG - 1;
+    for (int v = 0; wanted > 0 && v < set->count; v++) {
+        if (v == index) continue;
+        const SchedulerState* vs = set->sectors[v].s;
+        int backlog = __atomic_load_n(&vs->backlog, __ATOMIC_RELAXED);
+        if (backlog > best) {
+            best = backlog;
+            victim = v;
+        }
+    }
+
+    // Never wait for a neighbour while holding our own lock
+    if (victim >= 0 && pthread_mutex_trylock(&set->sectors[victim].s->lock) == 0) {
+        // Take at most half the difference, so two sectors never trade the same jets back and forth
+        SchedulerState* vs = set->sectors[victim].s;
+        int surplus = (vs->queue2.count + vs->queue3.count - own) / 2;
+        if (wanted > surplus) wanted = surplus;
+        pid_t pids[MAX_RUNWAYS];
+        int taken = (wanted > 0) ? scheduler_steal_jets_unsafe(vs, s, wanted, pids, log_file) : 0;
+        if (taken > 0) {
+            pthread_mutex_lock(&set->route_lock);
+            for (int i = 0; i < taken; i++) set->route[pids[i]] = index;
+            pthread_mutex_unlock(&set->route_lock);
+            thief->steals += taken;
+            set->sectors[victim].stolen += taken;
+            metrics_add(MET_STEALS, taken);
+        }
+        pthread_mutex_unlock(&set->sectors[victim].s->lock);
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+
+// --- Tick Threads ---
+
+int sector_pin_thread(int index) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) return -1;
+    int cpu = (int)(index % cores);
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0 ? cpu : -1;
+}
+
+void sector_run_tick(SectorSet* set, int index, FILE* log_file) {
+    sector_steal(set, index, log_file); // Stolen jets are dispatched by this tick
+    scheduler_tick(set->sectors[index].s, log_file);
+}
+
+void sector_run_dispatch(SectorSet* set, int index, FILE* log_file) {
+    sector_steal(set, index, log_file); // A steal asks for a dispatch itself
+    scheduler_dispatch(set->sectors[index].s, log_file);
+}
+
+static void* sector_loop(void* arg) {
+    Sector* sec = (Sector*)arg;
+    sec->cpu = sector_pin_thread(sec->index);
+    // Same wakeups as scheduler_loop: tick timer plus the sector's dispatch eventfd
+    int tick_fd = scheduler_open_tick_timer(sec->s->tick_ms);
+    if (tick_fd == -1) {
+        perror("Sector: Failed to create tick timer");
+        return NULL;
+    }
+    while (*sec->set->keep_running) {
+        int ticks;
+        bool dispatch;
+        scheduler_wait_events(sec->s, tick_fd, sec->s->tick_ms, &ticks, &dispatch);
+        for (int t = 0; t < ticks; t++) sector_run_tick(sec->set, sec->index, sec->set->log_file);
+        if (dispatch) sector_run_dispatch(sec->set, sec->index, sec->set->log_file);
+    }
+    close(tick_fd);
+    return NULL;
+}
+
+bool sectors_start(SectorSet* set, const bool* keep_running, FILE* log_file) {
+    set->keep_running = keep_running;
+    set->log_file = log_file;
+    for (int i = 0; i < set->count; i++) {
+        if (!scheduler_enable_dispatch_events(set->sectors[i].s)) return false;
+    }
+    for (int i = 0; i < set->count; i++) {
+        if (pthread_create(&set->sectors[i].thread, NULL, sector_loop, &set->sectors[i]) != 0) {
+            set->count = i; // sectors_stop joins the ones that started
+            set->started = true;
+            return false;
+        }
+    }
+    set->started = true;
+    return true;
+}
+
+void sectors_stop(SectorSet* set) {
+    if (!set->started) return;
+    for (int i = 0; i < set->count; i++) pthread_join(set->sectors[i].thread, NULL);
+    set->started = false;
+}
+
+
+// --- Routing ---
+
+void sectors_add_jet(SectorSet* set, pid_t pid, int read_fd, int write_fd, int fuel, FILE* log_file) {
+    int index = (int)((unsigned int)pid % (unsigned int)set->count);
+    // Routed first, so feedback that beats the add still finds the right sector
+    pthread_mutex_lock(&set->route_lock);
+    set->route[pid] = index;
+    pthread_mutex_unlock(&set->route_lock);
+    scheduler_add_jet(set->sectors[index].s, pid, read_fd, write_fd, fuel, log_file);
+}
+
+SchedulerState* sectors_lock_jet(SectorSet* set, pid_t pid) {
+    for (;;) {
+        pthread_mutex_lock(&set->route_lock);
+        auto it = set->route.find(pid);
+        bool known = (it != set->route.end());
+        int index = known ? it->second : 0;
+        pthread_mutex_unlock(&set->route_lock);
+
+        SchedulerState* s = set->sectors[index].s;
+        pthread_mutex_lock(&s->lock);
+        if (!known || scheduler_find_jet_unsafe(s, pid, NULL) != NULL) return s;
+        pthread_mutex_unlock(&s->lock); // Stolen or landed in between: look again
+        pthread_mutex_lock(&set->route_lock);
+        bool moved = set->route.count(pid) && set->route[pid] != index;
+        pthread_mutex_unlock(&set->route_lock);
+        if (!moved) {
+            pthread_mutex_lock(&s->lock);
+            return s; // Routed here but not (yet) added
+        }
+    }
+}
+
+void sectors_forget_jet(SectorSet* set, pid_t pid) {
+    pthread_mutex_lock(&set->route_lock);
+    set->route.erase(pid);
+    pthread_mutex_unlock(&set->route_lock);
+}
@@ -0,0 +1,76 @@
+#ifndef SECTOR_H
+#define SECTOR_H
+
+#include "scheduler.h"
+#include <unordered_map>
+
+/**
+ * @brief Sharded scheduler. Jets are split into airspace sectors, each a
+ * full SchedulerState with its own lock, runways, refuel bays and tick
+ * thread (pinned to its own core). A sector with a free runway and nothing
+ * of its own to land steals ready Q2/Q3 jets from the most loaded sector.
+ * Q1 is never stolen, so an emergency keeps its strict priority within
+ * its sector.
+ *
+ * Jets are moved by copying their record, so only jets whose feedback
+ * does not arrive through a per-jet fd in the epoll set can move (inproc
+ * backend, or --feedback mux).
+ *
+ * Lock order: a sector lock may be held when route_lock is taken, never
+ * the other way round. A thief holds its own lock and only ever
+ * trylocks its victim.
+ */
+
+#define MAX_SECTORS 16
+#define SECTOR_STEAL_MIN_BACKLOG 2  // Victim must have at least this many Q2+Q3 jets
+
+struct SectorSet;
+
+struct Sector {
+    SchedulerState* s;          // Sector 0 is the caller's scheduler, the rest are owned
+    SectorSet* set;
+    int index;
+    pthread_t thread;
+    int cpu;                    // Core the tick thread is pinned to, -1 if pinning failed
+    long steals;                // Jets this sector took from others (under s->lock)
+    long stolen;                // Jets others took from this one (under s->lock)
+};
+
+struct SectorSet {
+    Sector sectors[MAX_SECTORS];
+    int count;
+    bool started;
+    const bool* keep_running;   // Tick threads run while this is true
+    FILE* log_file;
+
+    pthread_mutex_t route_lock;
+    std::unordered_map<pid_t, int> route; // pid -> sector holding the jet
+};
+
+// Splits the runways and bays evenly (at least one runway each, and one
+// bay each if there are any). `first` becomes sector 0 and must already
+// be initialised. Clamped to 1..MAX_SECTORS.
+bool sectors_init(SectorSet* set, SchedulerState* first, int count, int runways, int refuel_bays);
+void sectors_destroy(SectorSet* set); // After sectors_stop; leaves sector 0 to its owner
+
+void sectors_set_command_hook(SectorSet* set, SchedulerCommandHook hook, void* ctx);
+
+// One tick thread per sector: steal, then scheduler_tick every tick_ms,
+// or scheduler_dispatch as soon as the sector's dispatch eventfd is rung
+bool sectors_start(SectorSet* set, const bool* keep_running, FILE* log_file);
+void sectors_stop(SectorSet* set);
+
+// One period of a sector's tick thread (also used by bench_scheduler)
+void sector_run_tick(SectorSet* set, int index, FILE* log_file);
+void sector_run_dispatch(SectorSet* set, int index, FILE* log_file); // Same, for a dispatch wakeup
+int sector_pin_thread(int index); // Pins the calling thread, returns the core or -1
+
+// Jets are placed by pid (pid % count)
+void sectors_add_jet(SectorSet* set, pid_t pid, int read_fd, int write_fd, int fuel, FILE* log_file);
+
+// Locks and returns the sector holding `pid` (sector 0 if it is unknown),
+// following the jet if it is stolen meanwhile. Caller unlocks s->lock.
+SchedulerState* sectors_lock_jet(SectorSet* set, pid_t pid);
+void sectors_forget_jet(SectorSet* set, pid_t pid); // After it landed
+
+#endif // SECTOR_H
@@ -0,0 +1,213 @@
+#include "session.h"
+#include "scheduler.h"
+#include "journal.h"
+#include <errno.h>
+#include <fcntl.h>
+
+#define SESSION_WRITE_BUFFER 65536
+
+enum SessionMode { SESSION_OFF, SESSION_RECORD, SESSION_VERIFY };
+
+static SessionMode mode = SESSION_OFF;
+
+// Recording. Buffered by hand rather than through stdio, so a forked
+// child that exit()s does not write its copy of the buffer out again.
+static int session_fd = -1;
+static char session_buffer[SESSION_WRITE_BUFFER];
+static size_t session_buffer_len = 0;
+static bool session_virtual_clock = false;
+static int64_t session_wall_offset_ns = 0; // Wall clock minus the scheduler clock
+
+// Verify mode
+static const SessionRecord* expected_records = NULL;
+static uint64_t expected_count = 0;
+static uint64_t verify_pos = 0;
+static bool verify_failed = false;
+static uint64_t mismatch_pos = 0;
+static SessionRecord mismatch_expected, mismatch_actual;
+
+static bool flush_buffer() {
+    size_t off = 0;
+    while (off < session_buffer_len) {
+        ssize_t n = write(session_fd, session_buffer + off, session_buffer_len - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            perror("Session: write");
+            close(session_fd);
+            session_fd = -1;
+            mode = SESSION_OFF;
+            return false;
+        }
+        off += n;
+    }
+    session_buffer_len = 0;
+    return true;
+}
+
+static void append(const void* data, size_t len) {
+    if (session_buffer_len + len > sizeof(session_buffer) && !flush_buffer()) return;
+    memcpy(session_buffer + session_buffer_len, data, len);
+    session_buffer_len += len;
+}
+
+bool session_record_open(const char* path, bool virtual_clock, int runway_count, int refuel_bays,
+                         int q2_quantum_ms) {
+    session_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (session_fd == -1) return false;
+
+    SessionHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SESSION_MAGIC, 8);
+    h.version = SESSION_VERSION;
+    h.record_size = sizeof(SessionRecord);
+    h.start_time = time(NULL); // The virtual clock also starts at the wall clock
+    h.virtual_clock = virtual_clock ? 1 : 0;
+    h.runway_count = runway_count;
+    h.refuel_bays = refuel_bays;
+    h.q2_quantum_ms = q2_quantum_ms;
+    h.policy = SCHEDULER_POLICY;
+    // The simulation's clock is the wall clock in whole seconds; otherwise CLOCK_MONOTONIC
+    h.start_ns = virtual_clock ? h.start_time * (int64_t)NS_PER_SEC : (int64_t)scheduler_monotonic_ns();
+    session_wall_offset_ns = h.start_time * (int64_t)NS_PER_SEC - h.start_ns;
+    session_buffer_len = 0;
+    mode = SESSION_RECORD;
+    append(&h, sizeof(h));
+    session_virtual_clock = virtual_clock;
+    return true;
+}
+
+void session_record_close() {
+    if (mode != SESSION_RECORD) return;
+    flush_buffer();
+    mode = SESSION_OFF;
+    if (session_fd != -1) close(session_fd);
+    session_fd = -1;
+}
+
+void session_input(SessionRecordKind kind, pid_t pid, int code, int a) {
+    if (mode != SESSION_RECORD) return;
+    // --- MODIFIED: On the real clock, the scheduler's clock only moves here, at each
+    // input, so every decision the input causes sees the time a replay will use ---
+    if (!session_virtual_clock) scheduler_set_virtual_time_ns(scheduler_monotonic_ns(), session_wall_offset_ns);
+    SessionRecord r;
+    memset(&r, 0, sizeof(r));
+    r.time = scheduler_now_ns();
+    r.kind = kind;
+    r.code = code;
+    r.pid = pid;
+    r.a = a;
+    append(&r, sizeof(r));
+    // A crashed tower still leaves everything up to the last second on disk
+    if (kind == SREC_TICK && !session_virtual_clock) flush_buffer();
+}
+
+void session_decision(SessionRecordKind kind, int code, pid_t pid, int a, int b, int c, int d) {
+    if (mode == SESSION_OFF) return;
+    SessionRecord r;
+    memset(&r, 0, sizeof(r));
+    r.time = scheduler_now_ns();
+    r.kind = kind;
+    r.code = code;
+    r.pid = pid;
+    r.a = a;
+    r.b = b;
+    r.c = c;
+    r.d = d;
+    if (mode == SESSION_RECORD) {
+        append(&r, sizeof(r));
+        return;
+    }
+
+    // Verify: must be the next recorded decision (time is not compared)
+    if (verify_failed) return;
+    const SessionRecord* e = (verify_pos < expected_count) ? &expected_records[verify_pos] : NULL;
+    if (e && !session_is_input(e->kind) && e->kind == r.kind && e->code == r.code && e->pid == r.pid &&
+        e->a == r.a && e->b == r.b && e->c == r.c && e->d == r.d) {
+        verify_pos++;
+        return;
+    }
+    verify_failed = true;
+    mismatch_pos = verify_pos;
+    if (e && !session_is_input(e->kind)) mismatch_expected = *e;
+    else memset(&mismatch_expected, 0, sizeof(mismatch_expected)); // Nothing more was decided here
+    mismatch_actual = r;
+}
+
+void session_verify_begin(const SessionRecord* records, uint64_t count) {
+    expected_records = records;
+    expected_count = count;
+    verify_pos = 0;
+    verify_failed = false;
+    mode = SESSION_VERIFY;
+}
+
+void session_verify_end() {
+    if (mode == SESSION_VERIFY) mode = SESSION_OFF;
+    expected_records = NULL;
+    expected_count = 0;
+}
+
+void session_verify_seek(uint64_t pos) {
+    verify_pos = pos;
+}
+
+uint64_t session_verify_pos() {
+    return verify_pos;
+}
+
+bool session_verify_failed() {
+    return verify_failed;
+}
+
+uint64_t session_verify_mismatch(SessionRecord* expected, SessionRecord* actual) {
+    *expected = mismatch_expected;
+    *actual = mismatch_actual;
+    return mismatch_pos;
+}
+
+bool session_verify_command_ok() {
+    if (verify_pos >= expected_count) return true;
+    const SessionRecord* e = &expected_records[verify_pos];
+    return e->kind != SREC_COMMAND || e->a != 0;
+}
+
+static const char* command_name(int command) {
+    switch (command) {
+    case CMD_START_LANDING: return "START_LANDING";
+    case CMD_REFUEL: return "REFUEL";
+    case CMD_SHUTDOWN: return "SHUTDOWN";
+    case CMD_ACTIVATE: return "ACTIVATE";
+    default: return "UNKNOWN";
+    }
+}
+
+int session_format_record(const SessionRecord* r, char* buf, size_t size) {
+    switch (r->kind) {
+    case SREC_NONE:
+        return snprintf(buf, size, "(nothing)");
+    case SREC_ARRIVAL:
+        return snprintf(buf, size, "arrival of jet %d (fuel %d)", r->pid, r->a);
+    case SREC_FEEDBACK:
+        return snprintf(buf, size, "feedback from jet %d (status %d, data %d)", r->pid, r->code, r->a);
+    case SREC_TICK:
+        return snprintf(buf, size, "tick");
+    case SREC_FORCE_EMERGENCY:
+        return snprintf(buf, size, "console force_emergency %d", r->pid);
+    case SREC_BOOST:
+        return snprintf(buf, size, "console boost of jet %d to Q%d", r->pid, r->a);
+    case SREC_SET_QUANTUM:
+        return snprintf(buf, size, "console change_quantum %d ms", r->a);
+    case SREC_SET_PAUSED:
+        return snprintf(buf, size, "console %s", r->a ? "pause_sim" : "resume_sim");
+    case SREC_DISPATCH:
+        return snprintf(buf, size, "dispatch");
+    case SREC_DECISION:
+        return snprintf(buf, size, "%s jet %d Q%d->Q%d fuel %d other %d",
+                        journal_event_name(r->code), r->pid, r->a, r->b, r->c, r->d);
+    case SREC_COMMAND:
+        return snprintf(buf, size, "command %s to jet %d (%s)", command_name(r->code), r->pid,
+                        r->a ? "delivered" : "failed");
+    default:
+        return snprintf(buf, size, "unknown record %u", r->kind);
+    }
+}
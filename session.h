@@ -0,0 +1,91 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "utils.h"
+#include <stdint.h>
+
+/**
+ * @brief Session recording for deterministic replay. Every external
+ * input to the scheduler (arrival, jet feedback, console command, clock
+ * tick) is appended with its scheduler_now_ns() time, in the order it was applied
+ * under scheduler.lock. So is every decision the scheduler made in
+ * response (queue moves, preemptions, dispatches, runway commands).
+ *
+ * In verify mode (replay.h) the same decision calls are compared
+ * against the recording instead of appended to it.
+ *
+ * Not thread-safe: callers hold scheduler.lock, like the journal.
+ */
+
+#define SESSION_MAGIC "SKYSESS1"
+#define SESSION_VERSION 4  // 2: header carries refuel_bays, 3: SREC_DISPATCH inputs,
+                           // 4: times in ns, start_ns and q2_quantum_ms, SREC_SET_QUANTUM in ms
+
+enum SessionRecordKind {
+    SREC_NONE = 0,
+    // Inputs
+    SREC_ARRIVAL,           // a = fuel
+    SREC_FEEDBACK,          // code = JetStatus, a = data
+    SREC_TICK,
+    SREC_FORCE_EMERGENCY,   // Console: a = fuel
+    SREC_BOOST,             // Console: a = target queue
+    SREC_SET_QUANTUM,       // Console: a = quantum in ms (seconds before version 4)
+    SREC_SET_PAUSED,        // Console: a = 1 paused, 0 resumed
+    // Outputs
+    SREC_DECISION,          // code = JournalEventType, a = from_q, b = to_q, c = fuel, d = other_pid
+    SREC_COMMAND,           // code = AtcCommand, a = 1 if it was delivered
+    // Inputs added later (kept after the outputs so older recordings decode the same)
+    SREC_DISPATCH,          // scheduler_dispatch between ticks
+    SREC_KIND_COUNT
+};
+
+struct SessionRecord {
+    int64_t time;       // scheduler_now_ns() when it happened (scheduler_now() before version 4)
+    uint16_t kind;      // SessionRecordKind
+    uint16_t code;
+    int32_t pid;
+    int32_t a, b, c, d;
+};
+
+struct SessionHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    int64_t start_time; // scheduler_now() at open
+    int32_t virtual_clock;
+    int32_t runway_count;
+    int32_t refuel_bays;    // Version 2 on; a version 1 header ends before this field
+    int32_t policy;         // --- MODIFIED: SCHEDULER_POLICY it was recorded with (was reserved, so 0 = MLFQ)
+    int64_t start_ns;       // Version 4 on: scheduler_now_ns() at open (start_time on the same clock)
+    int32_t q2_quantum_ms;  // Version 4 on: RR quantum at open (--quantum-ms)
+    int32_t reserved2;
+};
+
+inline bool session_is_input(int kind) {
+    return (kind >= SREC_ARRIVAL && kind <= SREC_SET_PAUSED) || kind == SREC_DISPATCH;
+}
+
+// --- Recording ---
+bool session_record_open(const char* path, bool virtual_clock, int runway_count, int refuel_bays,
+                         int q2_quantum_ms);
+void session_record_close();
+
+void session_input(SessionRecordKind kind, pid_t pid, int code, int a);
+
+// Appends (recording) or checks (verify mode) one scheduler decision
+void session_decision(SessionRecordKind kind, int code, pid_t pid, int a, int b = 0, int c = 0, int d = 0);
+
+// --- Verify mode (replay) ---
+void session_verify_begin(const SessionRecord* records, uint64_t count);
+void session_verify_end();
+void session_verify_seek(uint64_t pos);    // Next record a decision is checked against
+uint64_t session_verify_pos();
+bool session_verify_failed();
+// Index and both sides of the first mismatch (actual.kind == SREC_NONE: a recorded decision was not made)
+uint64_t session_verify_mismatch(SessionRecord* expected, SessionRecord* actual);
+// Whether the recorded run delivered the command expected next
+bool session_verify_command_ok();
+
+int session_format_record(const SessionRecord* r, char* buf, size_t size);
+
+#endif // SESSION_H
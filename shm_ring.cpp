@@ -0,0 +1,90 @@
+#include "shm_ring.h"
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <errno.h>
+
+ShmChannel* shm_channel_create(int* mem_fd, int* jet_bell, int* tower_bell) {
+    int fd = memfd_create("skywatch-jet", MFD_CLOEXEC);
+    if (fd == -1) return NULL;
+    if (ftruncate(fd, sizeof(ShmChannel)) == -1) {
+        close(fd);
+        return NULL;
+    }
+
+    ShmChannel* ch = shm_channel_attach(fd);
+    if (ch == NULL) {
+        close(fd);
+        return NULL;
+    }
+    // The memfd starts zeroed (empty rings). The tower only ever sleeps in
+    // epoll, so its side counts as waiting until it starts draining.
+    ch->to_tower.consumer_waiting.store(1);
+
+    *jet_bell = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    *tower_bell = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (*jet_bell == -1 || *tower_bell == -1) {
+        if (*jet_bell != -1) close(*jet_bell);
+        if (*tower_bell != -1) close(*tower_bell);
+        shm_channel_unmap(ch);
+        close(fd);
+        return NULL;
+    }
+    *mem_fd = fd;
+    return ch;
+}
+
+ShmChannel* shm_channel_attach(int mem_fd) {
+    void* p = mmap(NULL, sizeof(ShmChannel), PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, 0);
+    return (p == MAP_FAILED) ? NULL : (ShmChannel*)p;
+}
+
+void shm_channel_unmap(ShmChannel* ch) {
+    munmap(ch, sizeof(ShmChannel));
+}
+
+bool shm_ring_send(ShmRing* r, int bell_fd, const void* msg, size_t len) {
+    if (len > SHM_RING_SLOT_SIZE) return false;
+    uint32_t head = r->head.load(std::memory_order_relaxed);
+    if (head - r->tail.load(std::memory_order_acquire) == SHM_RING_SLOTS) return false; // Full
+
+    ShmRingSlot* slot = &r->slots[head & (SHM_RING_SLOTS - 1)];
+    slot->len = (uint32_t)len;
+    memcpy(slot->data, msg, len);
+    r->head.store(head + 1, std::memory_order_release);
+
+    // Pairs with the fence in shm_ring_prepare_wait: either the consumer
+    // sees the new head, or we see it waiting and ring
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (r->consumer_waiting.load(std::memory_order_relaxed)) {
+        uint64_t one = 1;
+        if (write(bell_fd, &one, sizeof(one)) == -1) perror("ShmRing: doorbell write");
+    }
+    return true;
+}
+
+bool shm_ring_recv(ShmRing* r, void* msg, size_t len) {
+    uint32_t tail = r->tail.load(std::memory_order_relaxed);
+    if (tail == r->head.load(std::memory_order_acquire)) return false; // Empty
+
+    ShmRingSlot* slot = &r->slots[tail & (SHM_RING_SLOTS - 1)];
+    size_t n = (slot->len < len) ? slot->len : len;
+    memcpy(msg, slot->data, n);
+    r->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool shm_ring_prepare_wait(ShmRing* r) {
+    r->consumer_waiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (r->tail.load(std::memory_order_relaxed) != r->head.load(std::memory_order_acquire)) {
+        r->consumer_waiting.store(0, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void shm_ring_finish_wait(ShmRing* r, int bell_fd) {
+    r->consumer_waiting.store(0, std::memory_order_relaxed);
+    uint64_t count;
+    if (read(bell_fd, &count, sizeof(count)) == -1 && errno != EAGAIN) perror("ShmRing: doorbell read");
+}
@@ -0,0 +1,66 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include "utils.h"
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * @brief Shared-memory transport between the tower and one drone. The
+ * jet's ShmChannel lives in a memfd mapped by both processes and holds
+ * one single-producer/single-consumer ring per direction. Messages are
+ * the same structs that go over the pipes (AtcCommandMessage,
+ * AtcActivateMessage, JetFeedbackMessage), copied into fixed slots.
+ *
+ * Each ring has an eventfd doorbell. The producer only rings it when
+ * the consumer has announced it is about to sleep (consumer_waiting),
+ * so a busy consumer costs no syscalls at all.
+ */
+
+#define SHM_RING_SLOTS 64       // Power of two
+#define SHM_RING_SLOT_SIZE 32   // Largest message is AtcActivateMessage
+
+struct ShmRingSlot {
+    uint32_t len;
+    char data[SHM_RING_SLOT_SIZE];
+};
+
+struct ShmRing {
+    alignas(64) std::atomic<uint32_t> head;             // Written by the producer
+    alignas(64) std::atomic<uint32_t> tail;             // Written by the consumer
+    alignas(64) std::atomic<uint32_t> consumer_waiting; // 1 while the consumer may sleep
+    alignas(64) ShmRingSlot slots[SHM_RING_SLOTS];
+};
+
+struct ShmChannel {
+    ShmRing to_jet;     // Commands (tower -> drone)
+    ShmRing to_tower;   // Feedback (drone -> tower)
+};
+
+/**
+ * @brief Creates a channel: memfd + mapping + two eventfds (jet_bell is
+ * read by the drone, tower_bell by the tower). All fds are close-on-exec
+ * and non-blocking. Returns NULL on failure.
+ */
+ShmChannel* shm_channel_create(int* mem_fd, int* jet_bell, int* tower_bell);
+
+// Maps an existing channel from its memfd (drone side)
+ShmChannel* shm_channel_attach(int mem_fd);
+void shm_channel_unmap(ShmChannel* ch);
+
+// Copies `msg` into the ring and rings `bell_fd` if the consumer sleeps. False if full.
+bool shm_ring_send(ShmRing* r, int bell_fd, const void* msg, size_t len);
+
+// Takes the oldest message, false if empty. Never blocks.
+bool shm_ring_recv(ShmRing* r, void* msg, size_t len);
+
+/**
+ * @brief Consumer is about to sleep on the doorbell. Returns true if it
+ * may (the ring is still empty); false if a message slipped in.
+ */
+bool shm_ring_prepare_wait(ShmRing* r);
+
+// Consumer woke up: clears the doorbell and stops wanting rings
+void shm_ring_finish_wait(ShmRing* r, int bell_fd);
+
+#endif // SHM_RING_H
@@ -0,0 +1,191 @@
+#include "sim.h"
+#include "jet_model.h"
+#include <queue>
+#include <vector>
+#include <unordered_map>
+#include <math.h>
+
+// --- Event Queue ---
+
+enum SimEventType {
+    SIM_ARRIVAL,    // Generator hands the tower a new jet
+    SIM_TICK,       // scheduler_tick: wait time, aging, RR quantum expiry, dispatch
+    SIM_JET_DUE,    // A jet's fuel threshold or landing/refuel completion
+    SIM_FEEDBACK    // A JetFeedbackMessage reaching the tower
+};
+
+struct SimEvent {
+    time_t time;
+    unsigned long seq;          // FIFO order among events at the same time
+    SimEventType type;
+    pid_t pid;
+    unsigned int generation;    // SIM_JET_DUE: stale if the jet was rescheduled
+    JetFeedbackMessage feedback;
+};
+
+struct SimEventLater {
+    bool operator()(const SimEvent& a, const SimEvent& b) const {
+        if (a.time != b.time) return a.time > b.time;
+        return a.seq > b.seq;
+    }
+};
+
+struct SimJet {
+    JetModel model;
+    unsigned int generation;
+    time_t scheduled;           // Time of the live SIM_JET_DUE event, 0 if none
+};
+
+struct SimContext {
+    std::priority_queue<SimEvent, std::vector<SimEvent>, SimEventLater> events;
+    unsigned long next_seq;
+    time_t now;
+    std::unordered_map<pid_t, SimJet> jets;
+};
+
+static void push_event(SimContext* ctx, time_t time, SimEventType type, pid_t pid) {
+    SimEvent ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.time = time;
+    ev.seq = ctx->next_seq++;
+    ev.type = type;
+    ev.pid = pid;
+    ctx->events.push(ev);
+}
+
+// Keeps exactly one live SIM_JET_DUE event per jet, at its next event time
+static void schedule_jet(SimContext* ctx, pid_t pid, SimJet* sj) {
+    time_t next = jet_model_next_event(&sj->model);
+    if (next == sj->scheduled) return;
+    sj->generation++;
+    sj->scheduled = next;
+    if (next == 0) return;
+
+    SimEvent ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.time = next;
+    ev.seq = ctx->next_seq++;
+    ev.type = SIM_JET_DUE;
+    ev.pid = pid;
+    ev.generation = sj->generation;
+    ctx->events.push(ev);
+}
+
+// Feedback is queued at the current time, like a pipe write the tower reads next
+static void sim_feedback_sink(void* arg, pid_t pid, JetFeedbackMessage msg) {
+    SimContext* ctx = (SimContext*)arg;
+    SimEvent ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.time = ctx->now;
+    ev.seq = ctx->next_seq++;
+    ev.type = SIM_FEEDBACK;
+    ev.pid = pid;
+    ev.feedback = msg;
+    ctx->events.push(ev);
+}
+
+// SchedulerCommandHook: runs under scheduler.lock, so it only touches the models
+static bool sim_command_hook(void* arg, SchedulerJet* jet, AtcCommand command) {
+    SimContext* ctx = (SimContext*)arg;
+    auto it = ctx->jets.find(jet->pid);
+    if (it == ctx->jets.end()) return false;
+    jet_model_command(&it->second.model, command, ctx->now, sim_feedback_sink, ctx);
+    schedule_jet(ctx, jet->pid, &it->second);
+    return true;
+}
+
+
+// --- Simulation Loop ---
+
+int run_simulation(const SimConfig* config) {
+    SimContext ctx;
+    ctx.next_seq = 0;
+    ctx.now = time(NULL); // Virtual time starts at the wall clock so log stamps look familiar
+    scheduler_set_virtual_time(ctx.now);
+    simulation_start_ns = scheduler_now_ns();
+
+    scheduler.command_hook = sim_command_hook;
+    scheduler.command_hook_ctx = &ctx;
+    tower_reap_jets = false;
+
+    if (config->traffic.jet_count >= 0) log_event("[Simulation]: Discrete-event mode, %ld jets.\n", config->traffic.jet_count);
+    else log_event("[Simulation]: Discrete-event mode, every jet in the trace.\n");
+
+    // --- MODIFIED: Arrivals are drawn one at a time from the traffic generator.
+    // The clock is in whole seconds, so an arrival lands on the second it falls in
+    // (rounded up, so the default one jet per second arrives at +1 s, +2 s, ...) ---
+    time_t start = ctx.now;
+    TrafficGenerator traffic;
+    TrafficArrival arrival;
+    bool more_arrivals = traffic_init(&traffic, &config->traffic) && traffic_next(&traffic, &arrival);
+    pid_t next_pid = 1;
+    bool tick_pending = false;
+    if (more_arrivals) push_event(&ctx, start + (time_t)ceil(arrival.time_s), SIM_ARRIVAL, 0);
+
+    while (!ctx.events.empty()) {
+        SimEvent ev = ctx.events.top();
+        ctx.events.pop();
+        ctx.now = ev.time;
+        scheduler_set_virtual_time(ctx.now);
+
+        if (ev.type == SIM_ARRIVAL) {
+            int initial_fuel = arrival.fuel;
+            pid_t pid = next_pid++;
+            if (arrival.jet_id) log_event("[ATC Tower]: Creating new jet with %d fuel (trace jet %d).\n", initial_fuel, arrival.jet_id);
+            else log_event("[ATC Tower]: Creating new jet with %d fuel.\n", initial_fuel);
+
+            SimJet& sj = ctx.jets[pid];
+            jet_model_init(&sj.model, pid, initial_fuel, ctx.now);
+            sj.generation = 0;
+            sj.scheduled = 0;
+            log_event("[ATC Tower]: Simulated new jet (PID %d)\n", pid);
+            scheduler_add_jet(&scheduler, pid, -1, -1, initial_fuel, log_file);
+            active_jet_count++;
+            schedule_jet(&ctx, pid, &sj);
+
+            more_arrivals = traffic_next(&traffic, &arrival);
+            if (more_arrivals) {
+                time_t due = start + (time_t)ceil(arrival.time_s);
+                push_event(&ctx, due > ctx.now ? due : ctx.now, SIM_ARRIVAL, 0);
+            } else {
+                log_event("[ATC Tower]: Jet Generator has shut down.\n");
+            }
+            if (!tick_pending) {
+                push_event(&ctx, ctx.now + 1, SIM_TICK, 0);
+                tick_pending = true;
+            }
+        }
+        else if (ev.type == SIM_TICK) {
+            scheduler_tick(&scheduler, log_file);
+            // An empty tower has nothing to tick; the next arrival restarts the clock
+            tick_pending = active_jet_count > 0;
+            if (tick_pending) push_event(&ctx, ctx.now + 1, SIM_TICK, 0);
+        }
+        else if (ev.type == SIM_JET_DUE) {
+            auto it = ctx.jets.find(ev.pid);
+            if (it == ctx.jets.end() || it->second.generation != ev.generation) continue; // Stale
+            it->second.scheduled = 0;
+            jet_model_advance(&it->second.model, ctx.now, sim_feedback_sink, &ctx);
+            schedule_jet(&ctx, ev.pid, &it->second);
+        }
+        else if (ev.type == SIM_FEEDBACK) {
+            pthread_mutex_lock(&scheduler.lock);
+            SchedulerJet* jet = scheduler_find_jet_unsafe(&scheduler, ev.pid, NULL);
+            if (jet) tower_handle_feedback_unsafe(&scheduler, jet, ev.feedback);
+            pthread_mutex_unlock(&scheduler.lock);
+            if (ev.feedback.status == STATUS_LANDED) ctx.jets.erase(ev.pid);
+        }
+        // --- NEW: Dispatch right away, as the scheduler thread does when its eventfd is rung ---
+        if (ev.type == SIM_ARRIVAL || ev.type == SIM_FEEDBACK) scheduler_dispatch(&scheduler, log_file);
+
+        if (!more_arrivals && active_jet_count == 0) {
+            log_event("[ATC Tower]: All jets have landed. Shutting down.\n");
+            break;
+        }
+    }
+
+    traffic_close(&traffic);
+    scheduler.command_hook = NULL;
+    scheduler.command_hook_ctx = NULL;
+    return 0;
+}
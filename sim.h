@@ -0,0 +1,19 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include "tower.h"
+#include "traffic.h"
+
+/**
+ * @brief Discrete-event simulation mode. Runs the tower against
+ * in-process jets (jet_model.h) on a virtual clock, with the same
+ * scheduler code, log lines and final summary as a real run.
+ */
+struct SimConfig {
+    TrafficConfig traffic;  // --- MODIFIED: Arrivals come from the traffic generator
+};
+
+// Runs until every jet has landed. scheduler and log_file must be set up.
+int run_simulation(const SimConfig* config);
+
+#endif // SIM_H
@@ -0,0 +1,173 @@
+#include "timer_wheel.h"
+#include <string.h>
+
+#define SLOT_MASK ((uint64_t)TIMER_WHEEL_SLOTS - 1)
+#define WHEEL_SPAN (1ULL << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS)) // Wheel ticks level 3 covers
+
+void timer_wheel_init(TimerWheel* w, uint64_t now_ns) {
+    memset(w, 0, sizeof(TimerWheel));
+    w->tick = now_ns / TIMER_WHEEL_RESOLUTION_NS;
+}
+
+void timer_entry_init(TimerEntry* e, int kind) {
+    memset(e, 0, sizeof(TimerEntry));
+    e->kind = kind;
+}
+
+// --- Slots (Internal) ---
+
+static void slot_append(TimerWheel* w, int level, int idx, TimerEntry* e) {
+    TimerSlot* slot = &w->slots[level][idx];
+    e->level = level;
+    e->slot = idx;
+    e->next = NULL;
+    e->prev = slot->tail;
+    if (slot->tail) slot->tail->next = e;
+    else slot->head = e;
+    slot->tail = e;
+    w->occupied[level] |= 1ULL << idx;
+}
+
+static void slot_unlink(TimerWheel* w, TimerEntry* e) {
+    TimerSlot* slot = &w->slots[e->level][e->slot];
+    if (e->prev) e->prev->next = e->next;
+    else slot->head = e->next;
+    if (e->next) e->next->prev = e->prev;
+    else slot->tail = e->prev;
+    if (slot->head == NULL) w->occupied[e->level] &= ~(1ULL << e->slot);
+    e->prev = e->next = NULL;
+}
+
+// Level 0 holds the next 64 wheel ticks, level L the next 64^(L+1).
+// A slot is picked by the deadline's own bits, so a level-L entry lands in
+// exactly the slot that is cascaded when its 64^L block comes round.
+static void place(TimerWheel* w, TimerEntry* e) {
+    uint64_t t = e->deadline_ns / TIMER_WHEEL_RESOLUTION_NS;
+    if (t < w->tick) t = w->tick; // Overdue: fires at the next expire
+    uint64_t delta = t - w->tick;
+    if (delta >= WHEEL_SPAN) {
+        t = w->tick + WHEEL_SPAN - 1; // Waits in level 3 and is placed again when cascaded
+        delta = WHEEL_SPAN - 1;
+    }
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1ULL << ((level + 1) * TIMER_WHEEL_BITS))) level++;
+    slot_append(w, level, (int)((t >> (level * TIMER_WHEEL_BITS)) & SLOT_MASK), e);
+}
+
+// On a level-L boundary, re-places that level's current slot (highest level first)
+static void cascade(TimerWheel* w) {
+    for (int level = TIMER_WHEEL_LEVELS - 1; level >= 1; level--) {
+        if (w->tick & ((1ULL << (level * TIMER_WHEEL_BITS)) - 1)) continue;
+        int idx = (int)((w->tick >> (level * TIMER_WHEEL_BITS)) & SLOT_MASK);
+        TimerSlot* slot = &w->slots[level][idx];
+        TimerEntry* e = slot->head;
+        slot->head = slot->tail = NULL;
+        w->occupied[level] &= ~(1ULL << idx);
+        while (e != NULL) {
+            TimerEntry* next = e->next;
+            place(w, e);
+            e = next;
+        }
+    }
+}
+
+// Next wheel tick that has a level-0 entry in this block, else the next
+// block boundary (where a cascade may bring entries down), at most `target`
+static uint64_t next_stop(const TimerWheel* w, uint64_t target) {
+    uint64_t idx = w->tick & SLOT_MASK;
+    uint64_t stop = (w->tick | SLOT_MASK) + 1;
+    if (idx < SLOT_MASK) {
+        uint64_t ahead = w->occupied[0] & (~0ULL << (idx + 1));
+        if (ahead) stop = (w->tick & ~SLOT_MASK) + __builtin_ctzll(ahead);
+    }
+    return (stop < target) ? stop : target;
+}
+
+// --- Sorting the expired list (merge sort, stable) ---
+
+static bool fires_before(const TimerEntry* a, const TimerEntry* b) {
+    if (a->deadline_ns != b->deadline_ns) return a->deadline_ns < b->deadline_ns;
+    return a->seq < b->seq;
+}
+
+static TimerEntry* sort_expired(TimerEntry* head) {
+    if (head == NULL || head->next == NULL) return head;
+    TimerEntry* slow = head;
+    TimerEntry* fast = head->next;
+    while (fast && fast->next) {
+        slow = slow->next;
+        fast = fast->next->next;
+    }
+    TimerEntry* second = slow->next;
+    slow->next = NULL;
+    TimerEntry* a = sort_expired(head);
+    TimerEntry* b = sort_expired(second);
+
+    TimerEntry merged;
+    TimerEntry* tail = &merged;
+    while (a && b) {
+        if (fires_before(b, a)) { tail->next = b; b = b->next; }
+        else { tail->next = a; a = a->next; }
+        tail = tail->next;
+    }
+    tail->next = a ? a : b;
+    return merged.next;
+}
+
+// --- Public Functions ---
+
+void timer_wheel_arm(TimerWheel* w, TimerEntry* e, uint64_t deadline_ns, uint64_t now_ns) {
+    if (e->armed) {
+        slot_unlink(w, e);
+        w->count--;
+    }
+    if (w->count == 0) w->tick = now_ns / TIMER_WHEEL_RESOLUTION_NS; // Nothing to cascade, follow the clock
+    e->deadline_ns = deadline_ns;
+    e->seq = w->seq++;
+    e->armed = true;
+    place(w, e);
+    w->count++;
+}
+
+void timer_wheel_cancel(TimerWheel* w, TimerEntry* e) {
+    if (!e->armed) return;
+    slot_unlink(w, e);
+    e->armed = false;
+    w->count--;
+}
+
+TimerEntry* timer_wheel_expire(TimerWheel* w, uint64_t now_ns) {
+    uint64_t target = now_ns / TIMER_WHEEL_RESOLUTION_NS;
+    if (w->count == 0) {
+        w->tick = target;
+        return NULL;
+    }
+    if (target < w->tick) target = w->tick; // Clock went back: only overdue entries can fire
+
+    TimerEntry* head = NULL;
+    TimerEntry* tail = NULL;
+    for (;;) {
+        TimerEntry* e = w->slots[0][w->tick & SLOT_MASK].head;
+        while (e != NULL) {
+            TimerEntry* next = e->next;
+            // A slot before `target` is due as a whole; in the last one, only what is due by now_ns
+            if (w->tick < target || e->deadline_ns <= now_ns) {
+                slot_unlink(w, e);
+                e->armed = false;
+                w->count--;
+                if (tail) tail->next = e;
+                else head = e;
+                tail = e;
+            }
+            e = next;
+        }
+        if (w->tick == target) break;
+        if (w->count == 0) {
+            w->tick = target;
+            break;
+        }
+        w->tick = next_stop(w, target);
+        cascade(w);
+    }
+    return sort_expired(head);
+}
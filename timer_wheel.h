@@ -0,0 +1,62 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+/**
+ * @brief Hierarchical timer wheel (Varghese & Lauck). Time is split into
+ * 1 ms wheel ticks. Level 0 has one slot per tick for the next 64 ms,
+ * level 1 one slot per 64 ms for the next 4 s, and so on up to level 3
+ * (about 4.6 hours; later deadlines wait in its last slot). When the wheel
+ * crosses a level-L boundary, that level's current slot is cascaded down.
+ *
+ * Entries are intrusive (embedded in the owner's record), so arming,
+ * cancelling and re-arming are O(1) and never allocate. Expiring costs
+ * O(expired entries), plus one step per 64 ms crossed while any timer is
+ * armed. An empty wheel costs nothing.
+ *
+ * Not thread-safe: the scheduler only touches its wheel under its lock.
+ */
+
+#define TIMER_WHEEL_RESOLUTION_NS 1000000ULL   // One wheel tick (1 ms)
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS) // 64 slots per level
+#define TIMER_WHEEL_LEVELS 4
+
+struct TimerEntry {
+    uint64_t deadline_ns;   // Fires once the clock is at or past this
+    uint64_t seq;           // Arm order, breaks deadline ties
+    int kind;               // Owner's tag, the wheel never reads it
+    bool armed;
+    int level;              // Slot holding it while armed
+    int slot;
+    TimerEntry* prev;
+    TimerEntry* next;       // Also links the list timer_wheel_expire returns
+};
+
+struct TimerSlot {
+    TimerEntry* head;
+    TimerEntry* tail;
+};
+
+struct TimerWheel {
+    uint64_t tick;          // Every slot before this wheel tick has fired
+    uint64_t seq;
+    int count;              // Armed entries
+    uint64_t occupied[TIMER_WHEEL_LEVELS]; // One bit per non-empty slot
+    TimerSlot slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+};
+
+void timer_wheel_init(TimerWheel* w, uint64_t now_ns);
+void timer_entry_init(TimerEntry* e, int kind);
+
+// Arms (or moves) the entry. now_ns re-bases an empty wheel, so the
+// clock may jump (virtual time) between runs of timers.
+void timer_wheel_arm(TimerWheel* w, TimerEntry* e, uint64_t deadline_ns, uint64_t now_ns);
+void timer_wheel_cancel(TimerWheel* w, TimerEntry* e); // No-op if not armed
+
+// Detaches every entry due at now_ns and returns them linked through
+// `next`, earliest deadline first (ties in arm order), or NULL.
+TimerEntry* timer_wheel_expire(TimerWheel* w, uint64_t now_ns);
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,377 @@
+#include "tower.h"
+#include "async_log.h"
+#include "session.h"
+#include "metrics.h"
+#include <stdarg.h>
+#include <sys/socket.h>
+
+// --- Global State ---
+SchedulerState scheduler;
+FILE* log_file = NULL;
+int active_jet_count = 0;
+bool tower_reap_jets = true;
+DronePool* tower_drone_pool = NULL;
+SectorSet* tower_sectors = NULL;
+
+// --- NEW: Global state for statistics ---
+uint64_t simulation_start_ns;
+TowerLatencyStats tower_latency;
+pthread_mutex_t stats_lock; // To protect tower_latency
+const char* tower_latency_csv_path = NULL;
+
+static const char* LAT_METRIC_NAMES[LAT_METRICS] = { "turnaround", "wait", "response", "emergency_to_runway" };
+static const char* LAT_ORIGIN_NAMES[LAT_ORIGINS] = { "all", "Q1", "Q2" };
+
+// Into the metric's overall histogram and its origin's. Caller holds stats_lock.
+static void record_latency(int metric, int origin, uint64_t value_us) {
+    latency_hist_record(&tower_latency.hist[metric][0], value_us);
+    if (origin > 0) latency_hist_record(&tower_latency.hist[metric][origin], value_us);
+}
+
+/**
+ * @brief MODIFIED: Reverted - prints to console AND log file
+ */
+void log_event(const char* format, ...) {
+    va_list args;
+    if (async_log_running()) {
+        // --- NEW: Queued for the writer thread ---
+        va_start(args, format);
+        async_log_vwrite(LOG_TO_CONSOLE | (log_file ? LOG_TO_FILE : 0), scheduler_now(), format, args);
+        va_end(args);
+        return;
+    }
+
+    va_start(args, format);
+    vprintf(format, args); // Print to console
+    va_end(args);
+    
+    if (log_file) {
+        time_t now = scheduler_now();
+        tm *ltm = localtime(&now);
+        char time_buf[20];
+        snprintf(time_buf, 20, "[%02d:%02d:%02d] ", ltm->tm_hour, ltm->tm_min, ltm->tm_sec);
+        fprintf(log_file, "%s", time_buf);
+        va_start(args, format);
+        vfprintf(log_file, format, args); // Print to log file
+        va_end(args);
+        fflush(log_file);
+    }
+}
+
+
+/**
+ * @brief Applies one feedback message from a jet. Caller holds
+ * s->lock (s is `scheduler`, or the jet's sector when sharded).
+ * On STATUS_LANDED the jet record is released.
+ */
+void tower_handle_feedback_unsafe(SchedulerState* s, SchedulerJet* jet, const JetFeedbackMessage& feedback) {
+    session_input(SREC_FEEDBACK, jet->pid, feedback.status, feedback.data);
+    metrics_count_feedback(feedback.status);
+    if (feedback.status == STATUS_LANDED) {
+        pid_t landed_pid = jet->pid;
+
+        // --- NEW: Capture stats BEFORE clearing jet data ---
+        // --- MODIFIED: From scheduler_now_ns() timestamps, into the histograms (µs) ---
+        uint64_t completion_ns = scheduler_now_ns();
+        uint64_t turnaround_us = (completion_ns - jet->arrival_ns) / 1000;
+        uint64_t wait_us = jet->total_wait_ns / 1000;
+        // Should always have run if it landed, but as a fallback: the turnaround
+        uint64_t response_us = jet->first_run_ns ? (jet->first_run_ns - jet->arrival_ns) / 1000 : turnaround_us;
+        // RR may have taken the runway back while it was landing, so not s->runways[jet->runway]
+        int origin = jet->dispatched_from;
+        if (origin < 0 || origin >= LAT_ORIGINS) origin = 0;
+        
+        pthread_mutex_lock(&stats_lock);
+        record_latency(LAT_TURNAROUND, origin, turnaround_us);
+        record_latency(LAT_WAIT, origin, wait_us);
+        record_latency(LAT_RESPONSE, origin, response_us);
+        if (jet->emergency_latency_ns >= 0) record_latency(LAT_EMERGENCY, origin, jet->emergency_latency_ns / 1000);
+        if (tower_latency.landed < SUMMARY_MAX_LISTED_JETS) {
+            JetStats* stats = &tower_latency.first_jets[tower_latency.landed];
+            stats->pid = landed_pid;
+            stats->turnaround_ms = turnaround_us / 1000.0;
+            stats->waiting_ms = wait_us / 1000.0;
+            stats->response_ms = response_us / 1000.0;
+        }
+        tower_latency.landed++;
+        pthread_mutex_unlock(&stats_lock);
+        // --- End of stats capture ---
+
+        scheduler_jet_landed_unsafe(s, landed_pid, log_file); 
+        if (tower_reap_jets) waitpid(landed_pid, NULL, 0); 
+        active_jet_count--;
+        log_event("[ATC Tower]: Cleaned up jet %d. %d jets remaining.\n", landed_pid, active_jet_count);
+    } 
+    else if (feedback.status == STATUS_EMERGENCY) {
+        log_event("[ATC Tower]: EMERGENCY from Jet %d! (Fuel: %d)\n", jet->pid, feedback.data);
+        scheduler_handle_emergency_unsafe(s, jet->pid, feedback.data, log_file);
+    } 
+    else if (feedback.status == STATUS_FUEL_LOW) {
+        log_event("[ATC Tower]: Low fuel warning from Jet %d (Fuel: %d).\n", jet->pid, feedback.data);
+        scheduler_update_fuel_unsafe(s, jet, feedback.data); 
+    }
+    else if (feedback.status == STATUS_WAITING_FUEL) {
+        log_event("[ATC Tower]: Refuel request from Jet %d (Fuel: %d).\n", jet->pid, feedback.data);
+        scheduler_handle_refuel_request_unsafe(s, jet->pid, feedback.data, log_file);
+    }
+    else if (feedback.status == STATUS_REFUELED) {
+        log_event("[ATC Tower]: Jet %d finished refueling (New Fuel: %d).\n", jet->pid, feedback.data);
+        scheduler_handle_refueled_unsafe(s, jet->pid, feedback.data, log_file);
+    }
+}
+
+
+#define MUX_RECV_BATCH 64 // Records per recvmmsg call
+
+/**
+ * @brief NEW: Reads everything waiting on the shared feedback socket
+ * (non-blocking, MUX_RECV_BATCH records per syscall) and appends it to
+ * `out`. Takes no lock, so call it before acquiring scheduler.lock.
+ * Returns the number of records read.
+ */
+int tower_read_mux_feedback(int mux_fd, std::vector<JetTaggedFeedback>* out) {
+    JetTaggedFeedback records[MUX_RECV_BATCH];
+    struct iovec iov[MUX_RECV_BATCH];
+    struct mmsghdr msgs[MUX_RECV_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < MUX_RECV_BATCH; i++) {
+        iov[i].iov_base = &records[i];
+        iov[i].iov_len = sizeof(JetTaggedFeedback);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int total = 0;
+    for (;;) {
+        int n = recvmmsg(mux_fd, msgs, MUX_RECV_BATCH, MSG_DONTWAIT, NULL);
+        if (n <= 0) break; // EAGAIN: drained
+        for (int i = 0; i < n; i++) {
+            if (msgs[i].msg_len == sizeof(JetTaggedFeedback)) out->push_back(records[i]);
+        }
+        total += n;
+        if (n < MUX_RECV_BATCH) break;
+    }
+    return total;
+}
+
+/**
+ * @brief NEW: Routes one record from the shared socket to its jet.
+ * Caller holds s->lock.
+ */
+void tower_handle_tagged_feedback_unsafe(SchedulerState* s, const JetTaggedFeedback& tagged) {
+    SchedulerJet* jet = scheduler_find_jet_unsafe(s, tagged.pid, NULL);
+    if (jet == NULL) {
+        log_event("ERROR: Feedback from unknown jet %d.\n", tagged.pid);
+        return;
+    }
+    if (tagged.seq != jet->feedback_seq) {
+        log_event("ERROR: Jet %d feedback out of sequence (got %u, expected %u).\n", 
+                  tagged.pid, tagged.seq, jet->feedback_seq);
+    }
+    jet->feedback_seq = tagged.seq + 1;
+    tower_handle_feedback_unsafe(s, jet, tagged.msg);
+}
+
+
+// snprintf into the summary buffer, stopping (not overflowing) once it is full
+static void summary_append(char* buffer, size_t size, int* len, const char* format, ...) {
+    if ((size_t)*len >= size - 1) return;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer + *len, size - *len, format, args);
+    va_end(args);
+    if (n > 0) *len = ((size_t)(*len + n) < size) ? *len + n : (int)size - 1;
+}
+
+/**
+ * @brief NEW: Prints the final statistics summary
+ * --- MODIFIED: Now also prints to console
+ */
+void print_final_summary()
+{
+    // --- MODIFIED: All times in ms, from scheduler_now_ns() ---
+    uint64_t simulation_end_ns = scheduler_now_ns();
+    double total_ms = (simulation_end_ns - simulation_start_ns) / 1e6;
+    if (total_ms < 1) total_ms = 1; // Avoid division by zero
+
+    char buffer[8192]; // Buffer to hold the summary string
+    int len = 0;
+
+    summary_append(buffer, sizeof(buffer), &len, "\n\n========================================================\n");
+    summary_append(buffer, sizeof(buffer), &len, "           FINAL SIMULATION SUMMARY\n");
+    summary_append(buffer, sizeof(buffer), &len, "========================================================\n\n");
+    
+    summary_append(buffer, sizeof(buffer), &len, "Total Simulation Time: %.3f s\n", total_ms / 1000.0);
+    
+    // --- MODIFIED: From the latency histograms; only the first jets are listed ---
+    pthread_mutex_lock(&stats_lock);
+    int jet_count = tower_latency.landed;
+    
+    if (jet_count > 0) {
+        summary_append(buffer, sizeof(buffer), &len, "\n--- Individual Jet Stats ---\n");
+        for (int j = 0; j < jet_count && j < SUMMARY_MAX_LISTED_JETS; j++) {
+            const JetStats* stats = &tower_latency.first_jets[j];
+            summary_append(buffer, sizeof(buffer), &len, "  - Jet %d: Turnaround=%.1f ms, Wait=%.1f ms, Response=%.1f ms\n", 
+                (int)stats->pid, stats->turnaround_ms, stats->waiting_ms, stats->response_ms);
+        }
+        
+        if (jet_count > SUMMARY_MAX_LISTED_JETS) {
+            summary_append(buffer, sizeof(buffer), &len, "  ... and %d more jets\n", jet_count - SUMMARY_MAX_LISTED_JETS);
+        }
+
+        summary_append(buffer, sizeof(buffer), &len, "\n--- Average Stats ---\n");
+        summary_append(buffer, sizeof(buffer), &len, "Average Turnaround Time: %.2f ms\n",
+            latency_hist_mean(&tower_latency.hist[LAT_TURNAROUND][0]) / 1000.0);
+        summary_append(buffer, sizeof(buffer), &len, "Average Waiting Time:    %.2f ms\n",
+            latency_hist_mean(&tower_latency.hist[LAT_WAIT][0]) / 1000.0);
+        summary_append(buffer, sizeof(buffer), &len, "Average Response Time:   %.2f ms\n",
+            latency_hist_mean(&tower_latency.hist[LAT_RESPONSE][0]) / 1000.0);
+
+        // --- NEW: Tails, per queue the jet landed from ---
+        static const double PERCENTILES[] = { 50, 90, 99, 99.9 };
+        summary_append(buffer, sizeof(buffer), &len, "\n--- Latency Percentiles (ms) ---\n");
+        summary_append(buffer, sizeof(buffer), &len, "%-20s %-4s %8s %10s %10s %10s %10s %10s\n",
+            "", "from", "count", "p50", "p90", "p99", "p99.9", "max");
+        for (int m = 0; m < LAT_METRICS; m++) {
+            for (int o = 0; o < LAT_ORIGINS; o++) {
+                const LatencyHistogram* h = &tower_latency.hist[m][o];
+                if (h->count == 0) continue;
+                summary_append(buffer, sizeof(buffer), &len, "%-20s %-4s %8llu",
+                    LAT_METRIC_NAMES[m], LAT_ORIGIN_NAMES[o], (unsigned long long)h->count);
+                for (int p = 0; p < 4; p++) {
+                    summary_append(buffer, sizeof(buffer), &len, " %10.1f", latency_hist_percentile(h, PERCENTILES[p]) / 1000.0);
+                }
+                summary_append(buffer, sizeof(buffer), &len, " %10.1f\n", h->max_us / 1000.0);
+            }
+        }
+
+    } else {
+        summary_append(buffer, sizeof(buffer), &len, "\nNo jets completed simulation.\n");
+    }
+
+    // --- NEW: Every histogram as CSV, for plotting ---
+    if (tower_latency_csv_path) {
+        FILE* csv = fopen(tower_latency_csv_path, "w");
+        if (csv) {
+            fprintf(csv, "metric,from,low_us,high_us,count,cumulative\n");
+            for (int m = 0; m < LAT_METRICS; m++) {
+                for (int o = 0; o < LAT_ORIGINS; o++) {
+                    latency_hist_write_csv(&tower_latency.hist[m][o], csv, LAT_METRIC_NAMES[m], LAT_ORIGIN_NAMES[o]);
+                }
+            }
+            fclose(csv);
+            summary_append(buffer, sizeof(buffer), &len, "Latency histograms written to %s\n", tower_latency_csv_path);
+        } else {
+            summary_append(buffer, sizeof(buffer), &len, "Could not write latency histograms to %s\n", tower_latency_csv_path);
+        }
+    }
+    pthread_mutex_unlock(&stats_lock);
+
+    // --- MODIFIED: Summed over every sector when sharded (at most 16 runways and bays in all) ---
+    int context_switches = 0, runway_count = 0, runway_dispatches = 0;
+    int bay_count = 0, bay_dispatches = 0;
+    double runway_busy_ms = 0, runway_queue_delay_ms = 0, bay_busy_ms = 0, bay_queue_delay_ms = 0;
+    double runway_idle_gap_ns = 0;
+    uint64_t runway_idle_gap_max_ns = 0;
+    Runway runways[MAX_RUNWAYS];
+    RefuelBay bays[MAX_REFUEL_BAYS];
+    double runway_ms[MAX_RUNWAYS], bay_ms[MAX_REFUEL_BAYS]; // Busy, including a dispatch still running
+    int sector_count = tower_sectors ? tower_sectors->count : 1;
+    for (int k = 0; k < sector_count; k++) {
+        SchedulerState* s = tower_sectors ? tower_sectors->sectors[k].s : &scheduler;
+        pthread_mutex_lock(&s->lock);
+        context_switches += s->total_context_switches;
+        runway_queue_delay_ms += s->runway_queue_delay_ns / 1e6;
+        runway_dispatches += s->runway_dispatches;
+        runway_idle_gap_ns += s->runway_idle_gap_ns;
+        if (s->runway_idle_gap_max_ns > runway_idle_gap_max_ns) runway_idle_gap_max_ns = s->runway_idle_gap_max_ns;
+        for (int r = 0; r < s->runway_count && runway_count < MAX_RUNWAYS; r++) {
+            runway_ms[runway_count] = scheduler_runway_busy_ns_unsafe(s, r) / 1e6;
+            runway_busy_ms += runway_ms[runway_count];
+            runways[runway_count++] = s->runways[r];
+        }
+        bay_queue_delay_ms += s->bay_queue_delay_ns / 1e6;
+        bay_dispatches += s->bay_dispatches;
+        for (int b = 0; b < s->bay_count && bay_count < MAX_REFUEL_BAYS; b++) {
+            bay_ms[bay_count] = scheduler_bay_busy_ns_unsafe(s, b) / 1e6;
+            bay_busy_ms += bay_ms[bay_count];
+            bays[bay_count++] = s->bays[b];
+        }
+        pthread_mutex_unlock(&s->lock);
+    }
+
+    // --- MODIFIED: Aggregate over all runways ---
+    double runway_capacity = total_ms * runway_count;
+    double cpu_utilization = (runway_busy_ms / runway_capacity) * 100.0;
+
+    summary_append(buffer, sizeof(buffer), &len, "\n--- System Stats ---\n");
+    summary_append(buffer, sizeof(buffer), &len, "Total Context Switches:  %d\n", context_switches);
+    summary_append(buffer, sizeof(buffer), &len, "Runway Utilization (CPU): %.2f %% (%.0f / %.0f ms)\n", 
+        cpu_utilization, runway_busy_ms, runway_capacity);
+    if (runway_count > 1) {
+        for (int r = 0; r < runway_count; r++) {
+            char label[32];
+            snprintf(label, sizeof(label), "  Runway %d:", r + 1);
+            summary_append(buffer, sizeof(buffer), &len, "%-25s%.2f %% (%.0f ms busy, %d dispatches)\n",
+                label, runway_ms[r] / total_ms * 100.0, runway_ms[r], runways[r].dispatches);
+        }
+    }
+    summary_append(buffer, sizeof(buffer), &len, "Runway Queueing Delay:   %.2f ms avg (%d dispatches)\n",
+        runway_dispatches ? runway_queue_delay_ms / runway_dispatches : 0.0, runway_dispatches);
+    // --- NEW: Time a free runway sat idle while its next jet was already waiting ---
+    summary_append(buffer, sizeof(buffer), &len, "Runway Idle Gap:         %.3f ms avg, %.3f ms max\n",
+        runway_dispatches ? runway_idle_gap_ns / runway_dispatches / 1e6 : 0.0, runway_idle_gap_max_ns / 1e6);
+
+    // --- NEW: Refuel bays are a separate resource ---
+    if (bay_count > 0) {
+        double bay_capacity = total_ms * bay_count;
+        summary_append(buffer, sizeof(buffer), &len, "Refuel Bay Utilization:  %.2f %% (%.0f / %.0f ms)\n",
+            bay_busy_ms / bay_capacity * 100.0, bay_busy_ms, bay_capacity);
+        if (bay_count > 1) {
+            for (int b = 0; b < bay_count; b++) {
+                char label[32];
+                snprintf(label, sizeof(label), "  Refuel Bay %d:", b + 1);
+                summary_append(buffer, sizeof(buffer), &len, "%-25s%.2f %% (%.0f ms busy, %d refuels)\n",
+                    label, bay_ms[b] / total_ms * 100.0, bay_ms[b], bays[b].dispatches);
+            }
+        }
+        summary_append(buffer, sizeof(buffer), &len, "Refuel Queueing Delay:   %.2f ms avg (%d refuels)\n",
+            bay_dispatches ? bay_queue_delay_ms / bay_dispatches : 0.0, bay_dispatches);
+    }
+    summary_append(buffer, sizeof(buffer), &len, "Landings/Hour:           %.1f\n", jet_count * 3600000.0 / total_ms);
+    if (async_log_dropped() > 0) {
+        summary_append(buffer, sizeof(buffer), &len, "Log Lines Dropped:       %ld\n", async_log_dropped());
+    }
+
+    // --- NEW: Sectors (tick threads joined by now, so no lock needed) ---
+    if (tower_sectors) {
+        summary_append(buffer, sizeof(buffer), &len, "\n--- Sectors ---\n");
+        for (int k = 0; k < tower_sectors->count; k++) {
+            const Sector* sec = &tower_sectors->sectors[k];
+            char label[32];
+            snprintf(label, sizeof(label), "  Sector %d:", k + 1);
+            summary_append(buffer, sizeof(buffer), &len, "%-25s%d runway(s), %d dispatches, %ld jets stolen in, %ld out, core %d\n",
+                label, sec->s->runway_count, sec->s->runway_dispatches, sec->steals, sec->stolen, sec->cpu);
+        }
+    }
+
+    // --- NEW: Drone pool (stopped by now, so no lock needed) ---
+    if (tower_drone_pool) {
+        DronePool* p = tower_drone_pool;
+        summary_append(buffer, sizeof(buffer), &len, "\n--- Drone Pool ---\n");
+        summary_append(buffer, sizeof(buffer), &len, "Pool Size:               %d (%ld drones pre-forked)\n",
+            p->target_size, p->spawned);
+        summary_append(buffer, sizeof(buffer), &len, "Checkouts:               %ld hits, %ld misses\n", p->hits, p->misses);
+        summary_append(buffer, sizeof(buffer), &len, "Activation Latency:      hit avg %.1f us (max %.1f), miss avg %.1f us (max %.1f)\n",
+            p->hits ? p->hit_latency_total_us / p->hits : 0.0, p->hit_latency_max_us,
+            p->misses ? p->miss_latency_total_us / p->misses : 0.0, p->miss_latency_max_us);
+    }
+    summary_append(buffer, sizeof(buffer), &len, "\n========================================================\n");
+
+    // --- NEW: Print the entire buffer to console and log file ---
+    printf("%s", buffer);
+    if (log_file) {
+        fprintf(log_file, "%s", buffer);
+        fflush(log_file);
+    }
+}
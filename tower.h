@@ -0,0 +1,53 @@
+#ifndef TOWER_H
+#define TOWER_H
+
+#include "utils.h"
+#include "scheduler.h"
+#include "drone_pool.h"
+#include "sector.h"
+#include "latency_hist.h"
+#include <vector>
+
+// --- Statistics for one landed jet (ms) ---
+struct JetStats {
+    pid_t pid;
+    double turnaround_ms;
+    double waiting_ms;
+    double response_ms;
+};
+
+// --- MODIFIED: Landed jets go into streaming histograms (constant memory),
+// split by the queue the jet was dispatched to the runway from ---
+enum LatencyMetric { LAT_TURNAROUND, LAT_WAIT, LAT_RESPONSE, LAT_EMERGENCY, LAT_METRICS };
+#define LAT_ORIGINS 3               // 0: every jet, 1: landed from Q1, 2: landed from Q2
+#define SUMMARY_MAX_LISTED_JETS 20  // Jets listed one by one in the summary
+
+struct TowerLatencyStats {
+    LatencyHistogram hist[LAT_METRICS][LAT_ORIGINS];
+    JetStats first_jets[SUMMARY_MAX_LISTED_JETS];
+    int landed;
+};
+
+// --- Shared Tower State (defined in tower.cpp) ---
+extern SchedulerState scheduler;
+extern FILE* log_file;
+extern int active_jet_count;
+extern bool tower_reap_jets;   // waitpid() landed jets; false when jets are not processes
+extern DronePool* tower_drone_pool; // Reported in the summary when set
+extern SectorSet* tower_sectors;    // Set when the scheduler is sharded into sectors
+
+extern uint64_t simulation_start_ns; // scheduler_now_ns() when the tower started
+extern TowerLatencyStats tower_latency;
+extern pthread_mutex_t stats_lock; // To protect tower_latency
+extern const char* tower_latency_csv_path; // Summary also writes the histograms here when set
+
+// --- Function Declarations ---
+void log_event(const char* format, ...);
+void tower_handle_feedback_unsafe(SchedulerState* s, SchedulerJet* jet, const JetFeedbackMessage& feedback);
+
+// --- NEW: Shared feedback socket (SOCK_SEQPACKET, one JetTaggedFeedback per record) ---
+int tower_read_mux_feedback(int mux_fd, std::vector<JetTaggedFeedback>* out);
+void tower_handle_tagged_feedback_unsafe(SchedulerState* s, const JetTaggedFeedback& tagged);
+void print_final_summary();
+
+#endif // TOWER_H
@@ -0,0 +1,157 @@
+#include "trace.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+bool trace_open(TraceReader* r, const char* path) {
+    memset(r, 0, sizeof(TraceReader));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        close(fd);
+        if (errno == 0) errno = ENODATA;
+        return false;
+    }
+    void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file
+    if (p == MAP_FAILED) return false;
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+
+    r->data = (const char*)p;
+    r->size = st.st_size;
+    const TraceFileHeader* h = (const TraceFileHeader*)r->data;
+    r->binary = r->size >= sizeof(TraceFileHeader) && memcmp(h->magic, TRACE_MAGIC, 8) == 0;
+    if (r->binary && h->record_size != sizeof(TraceRecord)) {
+        trace_close(r);
+        errno = EINVAL;
+        return false;
+    }
+    r->start = r->binary ? sizeof(TraceFileHeader) : 0;
+    r->pos = r->released = r->start;
+    return true;
+}
+
+void trace_close(TraceReader* r) {
+    if (r->data) munmap((void*)r->data, r->size);
+    r->data = NULL;
+}
+
+void trace_rewind(TraceReader* r) {
+    r->pos = r->start;
+    r->released = r->start;
+}
+
+// Gives the consumed pages back, so the mapping's resident size stays bounded
+static void release_consumed(TraceReader* r) {
+    if (r->pos - r->released < TRACE_RELEASE_BYTES) return;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t from = r->released & ~(page - 1);
+    size_t to = r->pos & ~(page - 1);
+    if (to > from) madvise((void*)(r->data + from), to - from, MADV_DONTNEED);
+    r->released = r->pos;
+}
+
+// --- CSV (the mapping is not NUL-terminated, so no strtod) ---
+
+// Unsigned decimal with an optional fraction, in millionths. False if there are no digits.
+static bool parse_time_us(const char** p, const char* end, int64_t* out) {
+    const char* s = *p;
+    bool negative = (s < end && *s == '-');
+    if (negative) s++;
+    int64_t whole = 0, frac = 0, scale = 1000000;
+    bool digits = false;
+    while (s < end && *s >= '0' && *s <= '9') {
+        whole = whole * 10 + (*s++ - '0');
+        digits = true;
+    }
+    if (s < end && *s == '.') {
+        s++;
+        while (s < end && *s >= '0' && *s <= '9') {
+            if (scale > 1) {
+                scale /= 10;
+                frac += (*s - '0') * scale;
+            }
+            s++;
+            digits = true;
+        }
+    }
+    if (!digits) return false;
+    *out = (whole * 1000000 + frac) * (negative ? -1 : 1);
+    *p = s;
+    return true;
+}
+
+static bool parse_int(const char** p, const char* end, int32_t* out) {
+    const char* s = *p;
+    bool negative = (s < end && *s == '-');
+    if (negative) s++;
+    int64_t v = 0;
+    bool digits = false;
+    while (s < end && *s >= '0' && *s <= '9') {
+        if (v < INT32_MAX) v = v * 10 + (*s - '0');
+        s++;
+        digits = true;
+    }
+    if (!digits) return false;
+    if (v > INT32_MAX) v = INT32_MAX;
+    *out = (int32_t)(negative ? -v : v);
+    *p = s;
+    return true;
+}
+
+static void skip_spaces(const char** p, const char* end) {
+    while (*p < end && (**p == ' ' || **p == '\t')) (*p)++;
+}
+
+// "time,fuel,jet_id"; the jet id may be left out
+static bool parse_csv_line(const char* s, const char* end, TraceRecord* out) {
+    skip_spaces(&s, end);
+    if (!parse_time_us(&s, end, &out->time_us)) return false;
+    skip_spaces(&s, end);
+    if (s == end || *s++ != ',') return false;
+    skip_spaces(&s, end);
+    if (!parse_int(&s, end, &out->fuel)) return false;
+    skip_spaces(&s, end);
+    out->jet_id = 0;
+    if (s < end && *s == ',') {
+        s++;
+        skip_spaces(&s, end);
+        if (!parse_int(&s, end, &out->jet_id)) return false;
+        skip_spaces(&s, end);
+    }
+    return s == end;
+}
+
+static bool read_csv(TraceReader* r, TraceRecord* out) {
+    while (r->pos < r->size) {
+        const char* line = r->data + r->pos;
+        const char* nl = (const char*)memchr(line, '\n', r->size - r->pos);
+        const char* end = nl ? nl : r->data + r->size;
+        r->pos = nl ? (size_t)(nl - r->data) + 1 : r->size;
+        if (end > line && end[-1] == '\r') end--;
+
+        const char* first = line;
+        skip_spaces(&first, end);
+        if (first == end || *first == '#') continue;
+        if (parse_csv_line(line, end, out)) return true;
+        // A header line ("time,fuel,jet_id") is not counted as malformed
+        bool header = (line == r->data + r->start) && !(*first >= '0' && *first <= '9') && *first != '-' && *first != '.';
+        if (!header) r->skipped++;
+    }
+    return false;
+}
+
+bool trace_read(TraceReader* r, TraceRecord* out) {
+    release_consumed(r);
+    if (r->binary) {
+        if (r->size - r->pos < sizeof(TraceRecord)) return false; // A torn last record is ignored
+        memcpy(out, r->data + r->pos, sizeof(TraceRecord));
+        r->pos += sizeof(TraceRecord);
+        return true;
+    }
+    return read_csv(r, out);
+}
@@ -0,0 +1,52 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Arrival trace reader. A trace is a list of (time, fuel, jet id)
+ * records in time order, either CSV or binary, and is read through a
+ * read-only mmap. Pages behind the cursor are handed back every
+ * TRACE_RELEASE_BYTES, so a trace of any size is read in constant
+ * memory.
+ *
+ * CSV: one "time_s,fuel,jet_id" per line, time in seconds (fractions
+ * allowed, any origin). A header line, blank lines and lines starting
+ * with '#' are skipped, as are malformed lines (counted in `skipped`).
+ *
+ * Binary: a TraceFileHeader, then TraceRecords (time in µs). trace_convert
+ * turns a CSV trace into this format.
+ */
+
+#define TRACE_MAGIC "SKYTRC01"
+#define TRACE_RELEASE_BYTES (16u << 20) // Consumed bytes between MADV_DONTNEED calls
+
+struct TraceFileHeader {
+    char magic[8];          // TRACE_MAGIC
+    uint32_t record_size;   // sizeof(TraceRecord)
+    uint32_t reserved;
+};
+
+struct TraceRecord {
+    int64_t time_us;
+    int32_t fuel;
+    int32_t jet_id;
+};
+
+struct TraceReader {
+    const char* data;       // The whole file, mapped
+    size_t size;
+    bool binary;
+    size_t start;           // First record (after the binary header)
+    size_t pos;             // Next byte to read
+    size_t released;        // Bytes before this were given back
+    long skipped;           // Malformed CSV lines
+};
+
+bool trace_open(TraceReader* r, const char* path); // Sets errno on failure
+void trace_close(TraceReader* r);
+bool trace_read(TraceReader* r, TraceRecord* out); // False at the end of the file
+void trace_rewind(TraceReader* r);
+
+#endif // TRACE_H
@@ -0,0 +1,277 @@
+#include "traffic.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --- MODIFIED: Moved from tower.cpp. A "traffic jam" to test all queues ---
+const int TRAFFIC_FUEL_MIX[] = {
+    60, // Standard jet
+    20, // EMERGENCY jet (will hit 10 fuel while waiting)
+    60, // Standard jet
+    40, // REFUEL jet (will hit 25 fuel while waiting)
+    60, // Standard jet (will be demoted by RR)
+    60, // Standard jet (will be demoted by RR)
+    18, // EMERGENCY jet
+    50  // REFUEL jet
+};
+const int TRAFFIC_FUEL_MIX_COUNT = sizeof(TRAFFIC_FUEL_MIX) / sizeof(TRAFFIC_FUEL_MIX[0]);
+
+void traffic_default_config(TrafficConfig* cfg) {
+    memset(cfg, 0, sizeof(TrafficConfig));
+    cfg->jet_count = TRAFFIC_FUEL_MIX_COUNT;
+    cfg->arrivals = ARRIVALS_FIXED;
+    cfg->rate = 1.0;
+    cfg->burst_rate = 10.0;
+    cfg->mean_calm_s = 60.0;
+    cfg->mean_burst_s = 10.0;
+    cfg->fuel = FUEL_MIX;
+    cfg->fuel_min = 15;
+    cfg->fuel_max = 90;
+    cfg->fuel_mean = 50.0;
+    cfg->fuel_sd = 15.0;
+    cfg->trace_speed = 1.0;
+}
+
+// --- Command line ---
+
+bool traffic_is_option(const char* option) {
+    return strcmp(option, "--arrivals") == 0 || strcmp(option, "--rate") == 0 ||
+           strcmp(option, "--burst") == 0 || strcmp(option, "--fuel") == 0 ||
+           strcmp(option, "--surge") == 0 || strcmp(option, "--trace") == 0 ||
+           strcmp(option, "--trace-speed") == 0;
+}
+
+bool traffic_parse_option(TrafficConfig* cfg, const char* option, const char* value) {
+    if (strcmp(option, "--arrivals") == 0) {
+        if (strcmp(value, "fixed") == 0) cfg->arrivals = ARRIVALS_FIXED;
+        else if (strcmp(value, "poisson") == 0) cfg->arrivals = ARRIVALS_POISSON;
+        else if (strcmp(value, "mmpp") == 0) cfg->arrivals = ARRIVALS_MMPP;
+        else return false;
+        return true;
+    }
+    if (strcmp(option, "--rate") == 0) {
+        cfg->rate = atof(value);
+        return cfg->rate > 0;
+    }
+    if (strcmp(option, "--burst") == 0) {
+        // <burst rate>:<mean calm s>:<mean burst s>
+        if (sscanf(value, "%lf:%lf:%lf", &cfg->burst_rate, &cfg->mean_calm_s, &cfg->mean_burst_s) != 3) return false;
+        return cfg->burst_rate > 0 && cfg->mean_calm_s > 0 && cfg->mean_burst_s > 0;
+    }
+    if (strcmp(option, "--fuel") == 0) {
+        if (strcmp(value, "mix") == 0) {
+            cfg->fuel = FUEL_MIX;
+            return true;
+        }
+        if (sscanf(value, "uniform:%d:%d", &cfg->fuel_min, &cfg->fuel_max) == 2) {
+            cfg->fuel = FUEL_UNIFORM;
+            return cfg->fuel_min >= 1 && cfg->fuel_max >= cfg->fuel_min;
+        }
+        if (sscanf(value, "normal:%lf:%lf", &cfg->fuel_mean, &cfg->fuel_sd) == 2) {
+            cfg->fuel = FUEL_NORMAL;
+            cfg->fuel_min = 1; // Clamped to [1, mean + 4 sd]
+            cfg->fuel_max = (int)(cfg->fuel_mean + 4 * cfg->fuel_sd + 0.5);
+            return cfg->fuel_mean >= 1 && cfg->fuel_sd >= 0;
+        }
+        return false;
+    }
+    if (strcmp(option, "--surge") == 0) {
+        // <start s>:<duration s>:<rate multiplier>
+        if (cfg->surge_count == TRAFFIC_MAX_SURGES) return false;
+        TrafficSurge* sg = &cfg->surges[cfg->surge_count];
+        if (sscanf(value, "%lf:%lf:%lf", &sg->start_s, &sg->duration_s, &sg->multiplier) != 3) return false;
+        if (sg->start_s < 0 || sg->duration_s <= 0 || sg->multiplier <= 0) return false;
+        cfg->surge_count++;
+        return true;
+    }
+    if (strcmp(option, "--trace") == 0) {
+        cfg->arrivals = ARRIVALS_TRACE;
+        cfg->trace_path = value;
+        return value[0] != '\0';
+    }
+    if (strcmp(option, "--trace-speed") == 0) {
+        cfg->trace_speed = atof(value);
+        return cfg->trace_speed > 0;
+    }
+    return false;
+}
+
+// --- PRNG (xoshiro256**, seeded through splitmix64) ---
+
+static uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+static uint64_t next_u64(TrafficGenerator* g) {
+    uint64_t* s = g->rng;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+static double uniform01(TrafficGenerator* g) { return (next_u64(g) >> 11) * 0x1.0p-53; } // [0, 1)
+
+static double exponential(TrafficGenerator* g, double mean) { return -mean * log(1.0 - uniform01(g)); }
+
+static double normal(TrafficGenerator* g, double mean, double sd) {
+    double u1 = 1.0 - uniform01(g); // (0, 1]
+    double u2 = uniform01(g);
+    return mean + sd * sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+// --- Rate ---
+
+static double surge_multiplier(const TrafficConfig* cfg, double t) {
+    double m = 1.0;
+    for (int i = 0; i < cfg->surge_count; i++) {
+        const TrafficSurge* sg = &cfg->surges[i];
+        if (t >= sg->start_s && t < sg->start_s + sg->duration_s) m *= sg->multiplier;
+    }
+    return m;
+}
+
+// Moves the MMPP state forward to time t
+static void mmpp_advance(TrafficGenerator* g, double t) {
+    while (t >= g->state_end_s) {
+        g->bursting = !g->bursting;
+        g->state_end_s += exponential(g, g->bursting ? g->cfg.mean_burst_s : g->cfg.mean_calm_s);
+    }
+}
+
+static double rate_at(TrafficGenerator* g, double t) {
+    double base = g->cfg.rate;
+    if (g->cfg.arrivals == ARRIVALS_MMPP) {
+        mmpp_advance(g, t);
+        if (g->bursting) base = g->cfg.burst_rate;
+    }
+    return base * surge_multiplier(&g->cfg, t);
+}
+
+// --- NEW: Trace ---
+
+// The next record of the trace, looping if asked to. Each pass starts one
+// mean gap after the last record of the one before.
+static bool trace_next(TrafficGenerator* g, TraceRecord* rec) {
+    if (!trace_read(&g->trace, rec)) {
+        if (!g->cfg.trace_loop || g->pass_records == 0) return false;
+        int64_t span = g->last_us - g->first_us;
+        int64_t gap = g->pass_records > 1 ? span / (g->pass_records - 1) : 1000000;
+        g->offset_us += span + gap;
+        g->pass_records = 0;
+        trace_rewind(&g->trace);
+        if (!trace_read(&g->trace, rec)) return false;
+    }
+    if (g->emitted == 0) g->first_us = rec->time_us;
+    if (g->pass_records > 0 && rec->time_us < g->last_us) rec->time_us = g->last_us; // Out of order: no earlier than the last
+    g->last_us = rec->time_us;
+    g->pass_records++;
+    return true;
+}
+
+// --- Public Functions ---
+
+bool traffic_init(TrafficGenerator* g, const TrafficConfig* cfg) {
+    memset(g, 0, sizeof(TrafficGenerator));
+    g->cfg = *cfg;
+    if (cfg->arrivals == ARRIVALS_TRACE) {
+        if (!trace_open(&g->trace, cfg->trace_path)) return false;
+        g->trace_mapped = true;
+    }
+    uint64_t x = cfg->seed;
+    for (int i = 0; i < 4; i++) g->rng[i] = splitmix64(&x);
+
+    // Overlapping surges multiply, so the bound is the product of every one above 1
+    double peak = cfg->rate;
+    if (cfg->arrivals == ARRIVALS_MMPP && cfg->burst_rate > peak) peak = cfg->burst_rate;
+    for (int i = 0; i < cfg->surge_count; i++) {
+        if (cfg->surges[i].multiplier > 1.0) peak *= cfg->surges[i].multiplier;
+    }
+    g->peak_rate = peak;
+    g->bursting = false;
+    g->state_end_s = (cfg->arrivals == ARRIVALS_MMPP) ? exponential(g, cfg->mean_calm_s) : 0;
+    return true;
+}
+
+void traffic_close(TrafficGenerator* g) {
+    if (g->trace_mapped) trace_close(&g->trace);
+    g->trace_mapped = false;
+}
+
+bool traffic_next(TrafficGenerator* g, TrafficArrival* out) {
+    if (g->cfg.jet_count >= 0 && g->emitted >= g->cfg.jet_count) return false;
+
+    if (g->cfg.arrivals == ARRIVALS_TRACE) {
+        TraceRecord rec;
+        if (!trace_next(g, &rec)) return false;
+        g->t = (g->offset_us + rec.time_us - g->first_us) / 1e6 / g->cfg.trace_speed;
+        out->time_s = g->t;
+        out->fuel = rec.fuel > 0 ? rec.fuel : 1;
+        out->jet_id = rec.jet_id;
+        g->emitted++;
+        return true;
+    }
+
+    if (g->cfg.arrivals == ARRIVALS_FIXED) {
+        g->t += 1.0 / rate_at(g, g->t);
+    } else {
+        // Thinning: candidates at the peak rate, kept with probability rate(t) / peak
+        for (;;) {
+            g->t += exponential(g, 1.0 / g->peak_rate);
+            if (uniform01(g) * g->peak_rate < rate_at(g, g->t)) break;
+        }
+    }
+
+    int fuel;
+    if (g->cfg.fuel == FUEL_MIX) {
+        fuel = TRAFFIC_FUEL_MIX[g->emitted % TRAFFIC_FUEL_MIX_COUNT];
+    } else if (g->cfg.fuel == FUEL_UNIFORM) {
+        fuel = g->cfg.fuel_min + (int)(next_u64(g) % (uint64_t)(g->cfg.fuel_max - g->cfg.fuel_min + 1));
+    } else {
+        fuel = (int)lround(normal(g, g->cfg.fuel_mean, g->cfg.fuel_sd));
+        if (fuel < g->cfg.fuel_min) fuel = g->cfg.fuel_min;
+        if (fuel > g->cfg.fuel_max) fuel = g->cfg.fuel_max;
+    }
+
+    out->time_s = g->t;
+    out->fuel = fuel;
+    out->jet_id = 0;
+    g->emitted++;
+    return true;
+}
+
+void traffic_describe(const TrafficConfig* cfg, char* buf, size_t len) {
+    char arrivals[96], fuel[64];
+    if (cfg->arrivals == ARRIVALS_TRACE) {
+        char jets[32];
+        if (cfg->jet_count < 0) snprintf(jets, sizeof(jets), "all jets");
+        else snprintf(jets, sizeof(jets), "%ld jets", cfg->jet_count);
+        snprintf(buf, len, "trace %s at %.2fx%s, %s", cfg->trace_path, cfg->trace_speed,
+                 cfg->trace_loop ? ", looping" : "", jets);
+        return;
+    }
+    if (cfg->arrivals == ARRIVALS_FIXED) {
+        snprintf(arrivals, sizeof(arrivals), "fixed %.2f/s", cfg->rate);
+    } else if (cfg->arrivals == ARRIVALS_POISSON) {
+        snprintf(arrivals, sizeof(arrivals), "poisson %.2f/s", cfg->rate);
+    } else {
+        snprintf(arrivals, sizeof(arrivals), "mmpp %.2f/s, bursts of %.2f/s (mean %.0f s calm, %.0f s burst)",
+                 cfg->rate, cfg->burst_rate, cfg->mean_calm_s, cfg->mean_burst_s);
+    }
+    if (cfg->fuel == FUEL_MIX) snprintf(fuel, sizeof(fuel), "mix");
+    else if (cfg->fuel == FUEL_UNIFORM) snprintf(fuel, sizeof(fuel), "uniform(%d, %d)", cfg->fuel_min, cfg->fuel_max);
+    else snprintf(fuel, sizeof(fuel), "normal(%.0f, %.0f)", cfg->fuel_mean, cfg->fuel_sd);
+    snprintf(buf, len, "%s, fuel %s, %d surge(s), %ld jets, seed %llu", arrivals, fuel,
+             cfg->surge_count, cfg->jet_count, (unsigned long long)cfg->seed);
+}
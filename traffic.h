@@ -0,0 +1,111 @@
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "trace.h"
+
+/**
+ * @brief Stochastic arrival generator. Produces one arrival at a time
+ * (time since the start, initial fuel), so a run of millions of jets
+ * needs no buffer. Everything it draws comes from its own PRNG seeded
+ * from the config, so a seed always gives the same traffic.
+ *
+ * Arrivals are fixed-interval, Poisson, or a two-state MMPP (Poisson
+ * whose rate switches between a calm and a burst rate, each state lasting
+ * an exponential time). Surges multiply the rate over a time window. Poisson
+ * and MMPP with surges are drawn by thinning: candidates at the peak rate,
+ * each kept with probability rate(t) / peak.
+ *
+ * --- NEW: Arrivals can also come from a recorded trace (trace.h), replayed
+ * at `trace_speed` times real time and optionally looped. The trace is
+ * streamed, so its size does not matter.
+ */
+
+#define TRAFFIC_MAX_SURGES 8
+
+enum TrafficArrivals {
+    ARRIVALS_FIXED,     // Every 1/rate s (the old generator: one jet per second)
+    ARRIVALS_POISSON,
+    ARRIVALS_MMPP,
+    ARRIVALS_TRACE      // --- NEW: Times, fuel and jet ids from trace_path
+};
+
+enum TrafficFuel {
+    FUEL_MIX,           // Cycles TRAFFIC_FUEL_MIX (the old "traffic jam" mix)
+    FUEL_UNIFORM,       // Integer in [fuel_min, fuel_max]
+    FUEL_NORMAL         // Rounded N(fuel_mean, fuel_sd), clamped to [fuel_min, fuel_max]
+};
+
+struct TrafficSurge {
+    double start_s;
+    double duration_s;
+    double multiplier;  // Applied to the arrival rate while it lasts
+};
+
+struct TrafficConfig {
+    long jet_count;         // --- MODIFIED: -1 for no limit (a whole trace)
+    uint64_t seed;
+    TrafficArrivals arrivals;
+    double rate;            // Arrivals/s (MMPP: in the calm state)
+    double burst_rate;      // MMPP: arrivals/s in the burst state
+    double mean_calm_s;     // MMPP: mean time in each state
+    double mean_burst_s;
+    TrafficFuel fuel;
+    int fuel_min;
+    int fuel_max;
+    double fuel_mean;
+    double fuel_sd;
+    TrafficSurge surges[TRAFFIC_MAX_SURGES];
+    int surge_count;
+    const char* trace_path; // --- NEW: ARRIVALS_TRACE
+    double trace_speed;     // Time compression: 10 replays a trace ten times faster
+    bool trace_loop;        // Start over at the end of the trace
+};
+
+struct TrafficArrival {
+    double time_s;      // Since the start of the run
+    int fuel;
+    int jet_id;         // --- NEW: From the trace, 0 if none
+};
+
+struct TrafficGenerator {
+    TrafficConfig cfg;
+    uint64_t rng[4];    // xoshiro256**
+    double t;           // Time of the last arrival
+    double peak_rate;   // Thinning bound
+    bool bursting;      // MMPP state
+    double state_end_s; // MMPP: when the current state ends
+    long emitted;
+    // --- NEW: ARRIVALS_TRACE ---
+    TraceReader trace;
+    bool trace_mapped;
+    int64_t first_us;   // First record of the trace
+    int64_t last_us;    // Last record read
+    int64_t offset_us;  // Added to the times of this pass (looping)
+    long pass_records;  // Records read in this pass
+};
+
+// --- The old generator: 8 jets, one per second ---
+extern const int TRAFFIC_FUEL_MIX[];
+extern const int TRAFFIC_FUEL_MIX_COUNT;
+
+void traffic_default_config(TrafficConfig* cfg);
+
+// Parses one of the generator's command-line options (--arrivals, --rate,
+// --burst, --fuel, --surge, --trace, --trace-speed). Returns false if
+// `value` is not valid.
+bool traffic_parse_option(TrafficConfig* cfg, const char* option, const char* value);
+bool traffic_is_option(const char* option);
+
+// --- MODIFIED: False (with errno set) if the trace cannot be opened ---
+bool traffic_init(TrafficGenerator* g, const TrafficConfig* cfg);
+// The next arrival, in time order. False once jet_count arrivals were made
+// (or the trace ended).
+bool traffic_next(TrafficGenerator* g, TrafficArrival* out);
+void traffic_close(TrafficGenerator* g); // --- NEW: Unmaps the trace
+
+// One line such as "poisson 5.00/s, fuel normal(50, 15), 1000 jets, seed 2035"
+void traffic_describe(const TrafficConfig* cfg, char* buf, size_t len);
+
+#endif // TRAFFIC_H
@@ -18,7 +18,13 @@
 // Using the standard namespace as requested
 using namespace std;
 
-const int MAX_JETS = 20;
+// --- Jet behaviour (shared by drone.cpp and the simulated jets) ---
+const int JET_LANDING_TIME = 12;     // Seconds on the runway to land
+const int JET_REFUEL_TIME = 10;      // Seconds to refuel
+const int JET_REFUEL_AMOUNT = 75;    // Fuel added by one refuel
+const int FUEL_REFUEL_LEVEL = 25;    // Sends STATUS_WAITING_FUEL
+const int FUEL_LOW_LEVEL = 20;       // Sends STATUS_FUEL_LOW
+const int FUEL_EMERGENCY_LEVEL = 10; // Sends STATUS_EMERGENCY (at or below)
 
 /**
 * @brief Message from Jet Generator OR Console to ATC Tower.
@@ -26,6 +32,7 @@ const int MAX_JETS = 20;
 struct JetMessage 
 {
     int initial_fuel;
+    int jet_id;       // --- NEW: From an arrival trace; 0 numbers it from jet_counter
 };
 
 // --- Enums for Jet <-> ATC Communication ---
@@ -37,7 +44,8 @@ enum AtcCommand
 {
     CMD_START_LANDING,
     CMD_REFUEL,       // <-- NEW
-    CMD_SHUTDOWN
+    CMD_SHUTDOWN,
+    CMD_ACTIVATE      // <-- NEW: Wakes a pre-forked drone (AtcActivateMessage)
 };
 
 /**
@@ -72,5 +80,28 @@ struct JetFeedbackMessage
     int data; // e.g., current fuel level
 };
 
+/**
+ * @brief NEW: Feedback on the shared (multiplexed) channel. Every drone
+ * writes to the same socket, so each message names its sender and
+ * carries a per-drone sequence number.
+ */
+struct JetTaggedFeedback
+{
+    pid_t pid;
+    unsigned int seq;
+    JetFeedbackMessage msg;
+};
+
+/**
+ * @brief NEW: First (and only) message a pooled drone waits for.
+ * Carries what a freshly exec'd drone would get on its command line.
+ */
+struct AtcActivateMessage
+{
+    AtcCommand command; // CMD_ACTIVATE
+    int initial_fuel;
+    char jet_id[16];
+};
+
 #endif // UTILS_H
 